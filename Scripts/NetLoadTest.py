@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Headless dedicated server load test.
+
+Starts a dedicated server and a number of -nullrhi clients on this machine, lets them play for a while, then
+reads the net reports the server logs (AFirstAttemptGameState::ReportNetStats, turned on by -NetReportInterval=)
+and prints the server frame time and the bandwidth of every client connection.
+
+    python3 Scripts/NetLoadTest.py --engine /path/to/UE4Editor --clients 4 --duration 120
+    python3 Scripts/NetLoadTest.py --engine "C:/UE_4.15/Engine/Binaries/Win64/UE4Editor.exe" --map /Game/Maps/Level1
+
+Without --map the server loads the project's default server map. Logs are kept in --out for a closer look.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import time
+
+REPORT_RE = re.compile(r"Net report: dedicated server, frame ([\d.]+) ms, (\d+) clients")
+CLIENT_RE = re.compile(r"LogTemp:\s+(\S+)\s+out\s+([\d.]+) KB/s, in\s+([\d.]+) KB/s, ping\s+([\d.]+) ms")
+
+
+def parse_args():
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Runs a dedicated server with headless clients and reports bandwidth and server frame time")
+    parser.add_argument("--engine", required=True, help="UE4Editor executable, run with -server and -game")
+    parser.add_argument("--project", default=os.path.join(script_dir, "..", "FirstAttempt.uproject"), help="the .uproject file")
+    parser.add_argument("--map", default="", help="map the server opens, the default server map if left out")
+    parser.add_argument("--clients", type=int, default=4, help="headless clients to connect")
+    parser.add_argument("--duration", type=float, default=60.0, help="seconds to run once every client is started")
+    parser.add_argument("--interval", type=float, default=5.0, help="seconds between net reports on the server")
+    parser.add_argument("--port", type=int, default=7777)
+    parser.add_argument("--out", default=os.path.join(script_dir, "..", "Saved", "NetLoadTest"), help="where the logs go")
+    return parser.parse_args()
+
+
+def launch(args, extra, log_path):
+    command = [args.engine, os.path.abspath(args.project)] + extra + ["-unattended", "-nosplash", "-nosound", "-log", "-abslog=" + log_path]
+    return subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def read_reports(log_path):
+    """Every net report in the log as (frame ms, number of clients, [(address, out KB/s, in KB/s, ping ms)])"""
+    reports = []
+    with open(log_path, errors="replace") as log:
+        for line in log:
+            match = REPORT_RE.search(line)
+            if match:
+                reports.append((float(match.group(1)), int(match.group(2)), []))
+                continue
+            match = CLIENT_RE.search(line)
+            if match and reports:
+                reports[-1][2].append((match.group(1), float(match.group(2)), float(match.group(3)), float(match.group(4))))
+    return reports
+
+
+def main():
+    args = parse_args()
+    os.makedirs(args.out, exist_ok=True)
+    server_log = os.path.abspath(os.path.join(args.out, "Server.log"))
+
+    server_args = ([args.map] if args.map else []) + ["-server", "-port=%d" % args.port, "-NetReportInterval=%g" % args.interval]
+    processes = [launch(args, server_args, server_log)]
+    try:
+        # Give the server time to load the map before anyone connects
+        time.sleep(15)
+        for index in range(args.clients):
+            client_log = os.path.abspath(os.path.join(args.out, "Client%d.log" % index))
+            processes.append(launch(args, ["127.0.0.1:%d" % args.port, "-game", "-nullrhi", "-windowed", "-ResX=320", "-ResY=240"], client_log))
+        time.sleep(args.duration)
+    finally:
+        for process in processes:
+            process.terminate()
+        for process in processes:
+            try:
+                process.wait(timeout=30)
+            except subprocess.TimeoutExpired:
+                process.kill()
+
+    if not os.path.exists(server_log):
+        print("No server log at %s, did the server start?" % server_log)
+        return 1
+
+    # Only count reports from when every client was in, the ones before are still loading
+    reports = [report for report in read_reports(server_log) if report[1] == args.clients]
+    if not reports:
+        print("The server never reported %d clients connected, see %s" % (args.clients, server_log))
+        return 1
+
+    frame_ms = [report[0] for report in reports]
+    print("%d reports with %d clients" % (len(reports), args.clients))
+    print("Server frame: average %.2f ms, worst %.2f ms" % (sum(frame_ms) / len(frame_ms), max(frame_ms)))
+
+    per_client = {}
+    for report in reports:
+        for address, out_kbs, in_kbs, ping in report[2]:
+            per_client.setdefault(address, []).append((out_kbs, in_kbs, ping))
+    print("%-24s %12s %12s %10s" % ("Client", "Out KB/s", "In KB/s", "Ping ms"))
+    total_out = 0.0
+    for address in sorted(per_client):
+        samples = per_client[address]
+        out_kbs = sum(sample[0] for sample in samples) / len(samples)
+        in_kbs = sum(sample[1] for sample in samples) / len(samples)
+        ping = sum(sample[2] for sample in samples) / len(samples)
+        total_out += out_kbs
+        print("%-24s %12.1f %12.1f %10.0f" % (address, out_kbs, in_kbs, ping))
+    print("Server out total %.1f KB/s, %.1f KB/s per client" % (total_out, total_out / max(1, len(per_client))))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Before and after frame time benchmarks.
+
+Runs one of ABenchmarkDirector's scenarios headless at each of its sizes, once the way it was before its change
+(-BenchBefore) and once as it is now against that run as the baseline, then prints the p50 and p95 of both.
+
+    python3 Scripts/RunBenchmark.py --engine /path/to/UE4Editor --scenario Bullets
+    python3 Scripts/RunBenchmark.py --engine "C:/UE_4.15/Engine/Binaries/Win64/UE4Editor.exe" --scenario Pursuit --sizes 100 500 --map /Game/Maps/Level1
+
+The scenarios, and what they compare:
+
+    Pursuit     enemies chasing the player, each calling MoveToActor against the flow field
+    PawnCache   enemies chasing the player, looking the player pawn up in the world against the gameplay context cache
+    Sensors     100 parked vehicles and enemies, each with an overlap sensor against the possessable registry
+    Bullets     bullets in flight, as projectile actors against the bullet manager
+    Perception  enemies watching the player, each with pawn sensing against the perception manager
+    Mixed       spawners, parked vehicles and shooters, run once at the director's defaults with no before
+
+PathfindingMs needs the FirstAttempt timings, so it reads 0 in shipping builds. Path queries the navigation system
+runs by itself, its repaths for MoveToActor and its async queries for PathQueue, aren't counted.
+The reports are written to Saved/Benchmarks as <Scenario>-<Size>-Before and <Scenario>-<Size>-After.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+SIZES = {
+    "Pursuit": [100, 500, 1000],
+    "PawnCache": [500],
+    "Sensors": [300],
+    "Bullets": [1000, 5000, 20000],
+    "Perception": [50, 200, 500],
+    "Mixed": [0],
+}
+
+
+def parse_args():
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Runs a benchmark scenario before and after its change and compares the frame times")
+    parser.add_argument("--engine", required=True, help="UE4Editor executable, run with -game")
+    parser.add_argument("--project", default=os.path.join(script_dir, "..", "FirstAttempt.uproject"), help="the .uproject file")
+    parser.add_argument("--map", default="", help="map to run in, the default game map if left out")
+    parser.add_argument("--scenario", required=True, choices=sorted(SIZES), help="which benchmark to run")
+    parser.add_argument("--sizes", type=int, nargs="*", help="sizes to run at, the scenario's usual ones if left out")
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds to record for each run")
+    parser.add_argument("--seed", type=int, default=1, help="random seed, the same for every run")
+    return parser.parse_args()
+
+
+def run(args, extra):
+    command = [args.engine, os.path.abspath(args.project)] + ([args.map] if args.map else []) + [
+        "-game", "-nullrhi", "-nosound", "-unattended", "-benchmark", "-fps=60", "-FirstAttemptBenchmark",
+        "-BenchScenario=" + args.scenario, "-BenchDuration=%g" % args.duration, "-RandomSeed=%d" % args.seed] + extra
+    print(" ".join(command))
+    subprocess.call(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def report_path(project, name):
+    """Where the director writes a scenario's reports, without the extension"""
+    return os.path.join(os.path.dirname(os.path.abspath(project)), "Saved", "Benchmarks", name)
+
+
+def read_summary(project, name):
+    path = report_path(project, name) + ".json"
+    if not os.path.exists(path):
+        return None
+    with open(path) as summary:
+        return json.load(summary)
+
+
+def print_summary(label, summary):
+    if summary is None:
+        print("  %-8s no report, see the log" % label)
+        return
+    metrics = summary.get("Metrics", {})
+    columns = ["%s p50 %.2f p95 %.2f" % (name, metrics[name]["P50"], metrics[name]["P95"]) for name in sorted(metrics)]
+    print("  %-8s %s" % (label, ", ".join(columns)))
+
+
+def main():
+    args = parse_args()
+    passed = True
+    for size in args.sizes or SIZES[args.scenario]:
+        size_args = ["-BenchSize=%d" % size]
+        print("%s, size %d" % (args.scenario, size))
+        if args.scenario == "Mixed":
+            run(args, size_args + ["-BenchReport=" + report_path(args.project, "Mixed-0-After")])
+            print_summary("mixed", read_summary(args.project, "Mixed-0-After"))
+            continue
+
+        before = "%s-%d-Before" % (args.scenario, size)
+        after = "%s-%d-After" % (args.scenario, size)
+        run(args, size_args + ["-BenchBefore"])
+        run(args, size_args + ["-BenchBaseline=" + report_path(args.project, before) + ".json"])
+
+        after_summary = read_summary(args.project, after)
+        print_summary("before", read_summary(args.project, before))
+        print_summary("after", after_summary)
+        if after_summary is None or not after_summary.get("Passed", False):
+            passed = False
+    return 0 if passed else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,173 +1,238 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-
-#include "FirstAttempt.h"
-#include "Airplane.h"
-#include "ThirdPersonCharacter.h"
-#include "ThirdPersonVehicle.h"
-
-AAirplane::AAirplane()
-{
-	// Structure to hold one-time initialization
-	struct FConstructorStatics
-	{
-		ConstructorHelpers::FObjectFinderOptional<UStaticMesh> PlaneMesh;
-		FConstructorStatics()
-			: PlaneMesh(TEXT("/Game/Flying/Meshes/UFO.UFO"))
-		{
-		}
-	};
-	static FConstructorStatics ConstructorStatics;
-
-	// Create static mesh component
-	PlaneMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("PlaneMesh0"));
-	PlaneMesh->SetStaticMesh(ConstructorStatics.PlaneMesh.Get());
-	RootComponent = PlaneMesh;
-
-	// Create a spring arm component
-	SpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("SpringArm0"));
-	SpringArm->SetupAttachment(RootComponent);
-	SpringArm->TargetArmLength = 160.0f; // The camera follows at this distance behind the character	
-	SpringArm->SocketOffset = FVector(0.f, 0.f, 60.f);
-	SpringArm->bEnableCameraLag = false;
-	SpringArm->CameraLagSpeed = 15.f;
-
-	// Create camera component 
-	Camera = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera0"));
-	Camera->SetupAttachment(SpringArm, USpringArmComponent::SocketName);
-	Camera->bUsePawnControlRotation = false; // Don't rotate camera with controller
-
-											 // Set handling parameters
-	Acceleration = 500.f;
-	TurnSpeed = 50.f;
-	MaxSpeed = 4000.f;
-	MinSpeed = 0.f;
-	CurrentForwardSpeed = 0.f;
-	
-	Sensor = CreateDefaultSubobject<USphereComponent>(TEXT("Sensor"));
-	Sensor->SetSphereRadius(0, true);
-	Sensor->SetupAttachment(RootComponent);
-	
-}
-
-void AAirplane::Tick(float DeltaSeconds)
-{
-	const FVector LocalMove = FVector(CurrentForwardSpeed * DeltaSeconds, 0.f, 0.f);
-
-	// Move plan forwards (with sweep so we stop when we collide with things)
-	AddActorLocalOffset(LocalMove, true);
-
-	// Calculate change in rotation this frame
-	FRotator DeltaRotation(0, 0, 0);
-	DeltaRotation.Pitch = CurrentPitchSpeed * DeltaSeconds;
-	DeltaRotation.Yaw = CurrentYawSpeed * DeltaSeconds;
-	DeltaRotation.Roll = CurrentRollSpeed * DeltaSeconds;
-
-	// Rotate plane
-	AddActorLocalRotation(DeltaRotation);
-
-	// Call any parent class Tick implementation
-	Super::Tick(DeltaSeconds);
-}
-
-void AAirplane::NotifyHit(class UPrimitiveComponent* MyComp, class AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
-{
-	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
-
-	// Deflect along the surface when we collide.
-	FRotator CurrentRotation = GetActorRotation();
-	SetActorRotation(FQuat::Slerp(CurrentRotation.Quaternion(), HitNormal.ToOrientationQuat(), 0.025f));
-}
-
-
-void AAirplane::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
-{
-	check(PlayerInputComponent);
-
-	PlayerInputComponent->BindAction("SwitchPawns", IE_Pressed, this, &AAirplane::SwitchPawns);
-
-	// Bind our control axis' to callback functions
-	PlayerInputComponent->BindAxis("Thrust", this, &AAirplane::ThrustInput);
-	PlayerInputComponent->BindAxis("VehicleMoveForward", this, &AAirplane::MoveUpInput);
-	PlayerInputComponent->BindAxis("VehicleMoveRight", this, &AAirplane::MoveRightInput);
-}
-
-void AAirplane::ThrustInput(float Val)
-{
-	// Is there no input?
-	bool bHasInput = !FMath::IsNearlyEqual(Val, 0.f);
-	// If input is not held down, reduce speed
-	float CurrentAcc = bHasInput ? (Val * Acceleration) : (-0.5f * Acceleration);
-	// Calculate new speed
-	float NewForwardSpeed = CurrentForwardSpeed + (GetWorld()->GetDeltaSeconds() * CurrentAcc);
-	// Clamp between MinSpeed and MaxSpeed
-	CurrentForwardSpeed = FMath::Clamp(NewForwardSpeed, MinSpeed, MaxSpeed);
-}
-
-void AAirplane::MoveUpInput(float Val)
-{
-	// Target pitch speed is based in input
-	float TargetPitchSpeed = (Val * TurnSpeed * -1.f);
-
-	// When steering, we decrease pitch slightly
-	TargetPitchSpeed += (FMath::Abs(CurrentYawSpeed) * -0.2f);
-
-	// Smoothly interpolate to target pitch speed
-	CurrentPitchSpeed = FMath::FInterpTo(CurrentPitchSpeed, TargetPitchSpeed, GetWorld()->GetDeltaSeconds(), 2.f);
-}
-
-void AAirplane::MoveRightInput(float Val)
-{
-	// Target yaw speed is based on input
-	float TargetYawSpeed = (Val * TurnSpeed);
-
-	// Smoothly interpolate to target yaw speed
-	CurrentYawSpeed = FMath::FInterpTo(CurrentYawSpeed, TargetYawSpeed, GetWorld()->GetDeltaSeconds(), 2.f);
-
-	// Is there any left/right input?
-	const bool bIsTurning = FMath::Abs(Val) > 0.2f;
-
-	// If turning, yaw value is used to influence roll
-	// If not turning, roll to reverse current roll value
-	float TargetRollSpeed = bIsTurning ? (CurrentYawSpeed * 0.5f) : (GetActorRotation().Roll * -2.f);
-
-	// Smoothly interpolate roll speed
-	CurrentRollSpeed = FMath::FInterpTo(CurrentRollSpeed, TargetRollSpeed, GetWorld()->GetDeltaSeconds(), 2.f);
-}
-
-void AAirplane::SwitchPawns()
-{
-	TArray<AActor*> OverlappingActors;
-	Sensor->GetOverlappingActors(OverlappingActors);
-	for (int i = 0; i < OverlappingActors.Num(); i++)
-	{
-		//UE_LOG(LogTemp, Warning, TEXT("Fuck"));
-		APawn *Pawn = Cast<APawn>(OverlappingActors[i]);
-		if (Pawn && Pawn != this)
-		{
-			//UE_LOG(LogTemp, Warning, TEXT("Ass"));
-			AController* TempController = GetController();
-			if (TempController)
-			{
-				//UE_LOG(LogTemp, Warning, TEXT("Bitch"));
-				TempController->UnPossess();
-				TempController->Possess(Pawn);
-				AThirdPersonCharacter *Character = Cast<AThirdPersonCharacter>(Pawn);
-				if (Character)
-				{
-					Character->GetUp();
-				}
-				/*
-				else
-				{
-					AThirdPersonVehicle *Vehicle = Cast<AThirdPersonVehicle>(Pawn);
-					if (Vehicle)
-					{
-						Vehicle->GetMesh()->SetSimulatePhysics(true);
-					}
-				}
-				*/
-			}
-			break;
-		}
-	}
-}
\ No newline at end of file
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "FirstAttempt.h"
+#include "Airplane.h"
+#include "FirstAttemptGameModeBase.h"
+#include "PossessableRegistry.h"
+#include "ContentPreloader.h"
+
+AAirplane::AAirplane()
+{
+	// Soft reference to the plane's mesh, streamed in by the content preloader and applied in OnConstruction
+	PlaneMeshAsset = TAssetPtr<UStaticMesh>(FStringAssetReference(TEXT("/Game/Flying/Meshes/UFO.UFO")));
+
+	// Create static mesh component
+	PlaneMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("PlaneMesh0"));
+	RootComponent = PlaneMesh;
+
+	// Create a spring arm component
+	SpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("SpringArm0"));
+	SpringArm->SetupAttachment(RootComponent);
+	SpringArm->TargetArmLength = 160.0f; // The camera follows at this distance behind the character	
+	SpringArm->SocketOffset = FVector(0.f, 0.f, 60.f);
+	SpringArm->bEnableCameraLag = false;
+	SpringArm->CameraLagSpeed = 15.f;
+
+	// Create camera component 
+	Camera = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera0"));
+	Camera->SetupAttachment(SpringArm, USpringArmComponent::SocketName);
+	Camera->bUsePawnControlRotation = false; // Don't rotate camera with controller
+
+											 // Set handling parameters
+	Acceleration = 500.f;
+	TurnSpeed = 50.f;
+	MaxSpeed = 4000.f;
+	MinSpeed = 0.f;
+	FixedTimeStep = 1.f / 60.f;
+	MaxSubSteps = 8;
+	StepAccumulator = 0.f;
+	bFlightInputDirty = false;
+	FlightInputResendInterval = 0.1f;
+	FlightInputSendAge = 0.f;
+
+	// The server flies every plane, clients only get where it ended up
+	bReplicates = true;
+	bReplicateMovement = true;
+	NetCullDistanceSquared = FMath::Square(30000.f);
+	NetUpdateFrequency = 30.f;
+	MinNetUpdateFrequency = 2.f;
+}
+
+void AAirplane::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	if (PlaneMesh->GetStaticMesh() == NULL)
+	{
+		PlaneMesh->SetStaticMesh(AContentPreloader::Resolve(PlaneMeshAsset));
+	}
+}
+
+void AAirplane::GetContentAssets(TArray<FStringAssetReference>& OutAssets) const
+{
+	OutAssets.AddUnique(PlaneMeshAsset.ToStringReference());
+}
+
+void AAirplane::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FlightState.Location = GetActorLocation();
+	FlightState.Rotation = GetActorQuat();
+	PreviousFlightState = FlightState;
+
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APossessableRegistry *Registry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+	if (Registry)
+	{
+		Registry->AddPossessable(this);
+	}
+}
+
+void AAirplane::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// When the whole world is going away the registry goes with it, so only unregister on a plain destroy
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+		APossessableRegistry *Registry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+		if (Registry)
+		{
+			Registry->RemovePossessable(this);
+		}
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AAirplane::Tick(float DeltaSeconds)
+{
+	if (Role < ROLE_Authority)
+	{
+		// Send the stick at most once a frame when it moved, and now and again when it didn't so a lost send
+		// doesn't leave the server flying on old input
+		FlightInputSendAge += DeltaSeconds;
+		if ((bFlightInputDirty || FlightInputSendAge >= FlightInputResendInterval) && IsLocallyControlled())
+		{
+			ServerSetFlightInput(FlightInput.Thrust, FlightInput.MoveUp, FlightInput.MoveRight);
+			FlightInputSendAge = 0.f;
+		}
+		bFlightInputDirty = false;
+		Super::Tick(DeltaSeconds);
+		return;
+	}
+
+	// Run the flight model in fixed steps so the trajectory doesn't depend on the frame rate
+	const FAirplaneFlightParams Params = GetFlightParams();
+	FAirplaneState::StepFixed(FlightState, PreviousFlightState, StepAccumulator, FlightInput, Params, DeltaSeconds, FixedTimeStep, MaxSubSteps);
+
+	// Draw the plane part way between the last two steps
+	const FAirplaneState RenderState = FAirplaneState::Interpolate(PreviousFlightState, FlightState, StepAccumulator / FixedTimeStep);
+
+	// Move plane (with sweep so we stop when we collide with things)
+	FHitResult Hit;
+	SetActorLocationAndRotation(RenderState.Location, RenderState.Rotation, true, &Hit);
+	if (Hit.bBlockingHit)
+	{
+		// Pull the simulation back to where the sweep stopped us
+		FlightState.Location = GetActorLocation();
+		PreviousFlightState.Location = FlightState.Location;
+	}
+
+	// Call any parent class Tick implementation
+	Super::Tick(DeltaSeconds);
+}
+
+void AAirplane::NotifyHit(class UPrimitiveComponent* MyComp, class AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
+{
+	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
+
+	// Deflect along the surface when we collide.
+	FRotator CurrentRotation = GetActorRotation();
+	SetActorRotation(FQuat::Slerp(CurrentRotation.Quaternion(), HitNormal.ToOrientationQuat(), 0.025f));
+	FlightState.Rotation = GetActorQuat();
+	PreviousFlightState.Rotation = FlightState.Rotation;
+}
+
+
+void AAirplane::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
+{
+	check(PlayerInputComponent);
+
+	PlayerInputComponent->BindAction("SwitchPawns", IE_Pressed, this, &AAirplane::SwitchPawns);
+
+	// Bind our control axis' to callback functions
+	PlayerInputComponent->BindAxis("Thrust", this, &AAirplane::ThrustInput);
+	PlayerInputComponent->BindAxis("VehicleMoveForward", this, &AAirplane::MoveUpInput);
+	PlayerInputComponent->BindAxis("VehicleMoveRight", this, &AAirplane::MoveRightInput);
+}
+
+void AAirplane::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AAirplane::UnPossessed()
+{
+	Super::UnPossessed();
+	// Nobody is holding the stick any more, so don't keep applying the last input
+	FlightInput = FAirplaneInput();
+}
+
+void AAirplane::ThrustInput(float Val)
+{
+	// Inputs are only stored here, the flight model applies them in Tick
+	bFlightInputDirty |= (FlightInput.Thrust != Val);
+	FlightInput.Thrust = Val;
+}
+
+void AAirplane::MoveUpInput(float Val)
+{
+	bFlightInputDirty |= (FlightInput.MoveUp != Val);
+	FlightInput.MoveUp = Val;
+}
+
+void AAirplane::MoveRightInput(float Val)
+{
+	bFlightInputDirty |= (FlightInput.MoveRight != Val);
+	FlightInput.MoveRight = Val;
+}
+
+void AAirplane::ServerSetFlightInput_Implementation(float Thrust, float MoveUp, float MoveRight)
+{
+	// An axis is the sum of every key bound to it, so holding two of them gives 2. Treat that as full deflection
+	FlightInput.Thrust = FMath::Clamp(Thrust, -1.f, 1.f);
+	FlightInput.MoveUp = FMath::Clamp(MoveUp, -1.f, 1.f);
+	FlightInput.MoveRight = FMath::Clamp(MoveRight, -1.f, 1.f);
+}
+
+bool AAirplane::ServerSetFlightInput_Validate(float Thrust, float MoveUp, float MoveRight)
+{
+	// Only NaN or infinity can't come from a real input device
+	return FMath::IsFinite(Thrust) && FMath::IsFinite(MoveUp) && FMath::IsFinite(MoveRight);
+}
+
+FAirplaneFlightParams AAirplane::GetFlightParams() const
+{
+	FAirplaneFlightParams Params;
+	Params.Acceleration = Acceleration;
+	Params.TurnSpeed = TurnSpeed;
+	Params.MaxSpeed = MaxSpeed;
+	Params.MinSpeed = MinSpeed;
+	return Params;
+}
+
+void AAirplane::SwitchPawns()
+{
+	if (Role < ROLE_Authority)
+	{
+		ServerSwitchPawns();
+		return;
+	}
+	// The registry keeps every possessable pawn in a grid, so this only looks at the few nearby
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APossessableRegistry *Registry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+	if (Registry)
+	{
+		Registry->SwitchPawns(this);
+	}
+}
+
+void AAirplane::ServerSwitchPawns_Implementation()
+{
+	SwitchPawns();
+}
+
+bool AAirplane::ServerSwitchPawns_Validate()
+{
+	return true;
+}
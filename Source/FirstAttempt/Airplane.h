@@ -1,86 +1,130 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-#pragma once
-#include "GameFramework/Pawn.h"
-#include "Airplane.generated.h"
-
-UCLASS(config = Game)
-class AAirplane : public APawn
-{
-	GENERATED_BODY()
-
-		/** StaticMesh component that will be the visuals for our flying pawn */
-		UPROPERTY(Category = Mesh, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		class UStaticMeshComponent* PlaneMesh;
-
-	/** Spring arm that will offset the camera */
-	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		class USpringArmComponent* SpringArm;
-
-	/** Camera component that will be our viewpoint */
-	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		class UCameraComponent* Camera;
-public:
-	AAirplane();
-
-	// Begin AActor overrides
-	virtual void Tick(float DeltaSeconds) override;
-	virtual void NotifyHit(class UPrimitiveComponent* MyComp, class AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override;
-	// End AActor overrides
-
-protected:
-
-	// Begin APawn overrides
-	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override; // Allows binding actions/axes to functions
-																							// End APawn overrides
-
-																							/** Bound to the thrust axis */
-	void ThrustInput(float Val);
-
-	/** Bound to the vertical axis */
-	void MoveUpInput(float Val);
-
-	/** Bound to the horizontal axis */
-	void MoveRightInput(float Val);
-
-	void SwitchPawns();
-
-private:
-
-	/** How quickly forward speed changes */
-	UPROPERTY(Category = Plane, EditAnywhere)
-		float Acceleration;
-
-	/** How quickly pawn can steer */
-	UPROPERTY(Category = Plane, EditAnywhere)
-		float TurnSpeed;
-
-	/** Max forward speed */
-	UPROPERTY(Category = Pitch, EditAnywhere)
-		float MaxSpeed;
-
-	/** Min forward speed */
-	UPROPERTY(Category = Yaw, EditAnywhere)
-		float MinSpeed;
-
-	/** Current forward speed */
-	float CurrentForwardSpeed;
-
-	/** Current yaw speed */
-	float CurrentYawSpeed;
-
-	/** Current pitch speed */
-	float CurrentPitchSpeed;
-
-	/** Current roll speed */
-	float CurrentRollSpeed;
-
-	class USphereComponent *Sensor;
-
-public:
-	/** Returns PlaneMesh subobject **/
-	FORCEINLINE class UStaticMeshComponent* GetPlaneMesh() const { return PlaneMesh; }
-	/** Returns SpringArm subobject **/
-	FORCEINLINE class USpringArmComponent* GetSpringArm() const { return SpringArm; }
-	/** Returns Camera subobject **/
-	FORCEINLINE class UCameraComponent* GetCamera() const { return Camera; }
-};
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "GameFramework/Pawn.h"
+#include "AirplaneFlightModel.h"
+#include "GameplayContext.h"
+#include "PreloadedContent.h"
+#include "Airplane.generated.h"
+
+UCLASS(config = Game)
+class AAirplane : public APawn, public IPreloadedContent
+{
+	GENERATED_BODY()
+
+		/** StaticMesh component that will be the visuals for our flying pawn */
+		UPROPERTY(Category = Mesh, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		class UStaticMeshComponent* PlaneMesh;
+
+	/** Spring arm that will offset the camera */
+	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		class USpringArmComponent* SpringArm;
+
+	/** Camera component that will be our viewpoint */
+	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		class UCameraComponent* Camera;
+public:
+	AAirplane();
+
+	/** Adds the soft referenced content this plane needs to the list, for the content preloader */
+	virtual void GetContentAssets(TArray<FStringAssetReference>& OutAssets) const override;
+
+	// Begin AActor overrides
+	virtual void OnConstruction(const FTransform& Transform) override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void NotifyHit(class UPrimitiveComponent* MyComp, class AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override;
+	// End AActor overrides
+
+protected:
+
+	// Begin APawn overrides
+	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override; // Allows binding actions/axes to functions
+	virtual void PostInitializeComponents() override;
+	virtual void UnPossessed() override;
+																							// End APawn overrides
+
+																							/** Bound to the thrust axis */
+	void ThrustInput(float Val);
+
+	/** Bound to the vertical axis */
+	void MoveUpInput(float Val);
+
+	/** Bound to the horizontal axis */
+	void MoveRightInput(float Val);
+
+	void SwitchPawns();
+
+	/** A client's SwitchPawns input, possession only happens on the server */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSwitchPawns();
+
+	/**
+	 * A client's stick and throttle. The server flies the plane and replicates where it ends up. Unreliable so a
+	 * lost packet doesn't hold up newer input behind it, the client sends again every FlightInputResendInterval
+	 */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerSetFlightInput(float Thrust, float MoveUp, float MoveRight);
+
+private:
+
+	/** Mesh for the plane, loaded through the content preloader */
+	UPROPERTY(Category = Mesh, EditDefaultsOnly)
+		TAssetPtr<UStaticMesh> PlaneMeshAsset;
+
+	/** How quickly forward speed changes */
+	UPROPERTY(Category = Plane, EditAnywhere)
+		float Acceleration;
+
+	/** How quickly pawn can steer */
+	UPROPERTY(Category = Plane, EditAnywhere)
+		float TurnSpeed;
+
+	/** Max forward speed */
+	UPROPERTY(Category = Pitch, EditAnywhere)
+		float MaxSpeed;
+
+	/** Min forward speed */
+	UPROPERTY(Category = Yaw, EditAnywhere)
+		float MinSpeed;
+
+	/** Length of one flight model step. The model always runs at this rate whatever the frame rate */
+	UPROPERTY(Category = Plane, EditAnywhere, meta = (ClampMin = "0.001"))
+		float FixedTimeStep;
+
+	/** Most flight model steps run in one frame, so a long hitch doesn't stall the game catching up */
+	UPROPERTY(Category = Plane, EditAnywhere, meta = (ClampMin = "1"))
+		int32 MaxSubSteps;
+
+	/** On a client, input that hasn't changed is sent to the server again this often, in case it was lost */
+	UPROPERTY(Category = Plane, EditAnywhere, meta = (ClampMin = "0.01"))
+		float FlightInputResendInterval;
+
+	/** Flight model state after the latest step */
+	FAirplaneState FlightState;
+
+	/** Flight model state one step earlier, blended with FlightState for drawing */
+	FAirplaneState PreviousFlightState;
+
+	/** Latest stick and throttle values, applied on the next steps */
+	FAirplaneInput FlightInput;
+
+	/** Time not yet simulated, always less than FixedTimeStep after a tick */
+	float StepAccumulator;
+
+	/** On a client, the input changed since it was last sent to the server */
+	bool bFlightInputDirty;
+
+	/** On a client, time since the input was last sent to the server */
+	float FlightInputSendAge;
+
+	FAirplaneFlightParams GetFlightParams() const;
+
+public:
+	/** Returns PlaneMesh subobject **/
+	FORCEINLINE class UStaticMeshComponent* GetPlaneMesh() const { return PlaneMesh; }
+	/** Returns SpringArm subobject **/
+	FORCEINLINE class USpringArmComponent* GetSpringArm() const { return SpringArm; }
+	/** Returns Camera subobject **/
+	FORCEINLINE class UCameraComponent* GetCamera() const { return Camera; }
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "AirplaneFlightModel.h"
+
+void FAirplaneState::Step(const FAirplaneInput& Input, const FAirplaneFlightParams& Params, float DeltaTime)
+{
+	// Is there no thrust input?
+	const bool bHasThrust = !FMath::IsNearlyEqual(Input.Thrust, 0.f);
+	// If thrust is not held down, reduce speed
+	const float CurrentAcc = bHasThrust ? (Input.Thrust * Params.Acceleration) : (-0.5f * Params.Acceleration);
+	ForwardSpeed = FMath::Clamp(ForwardSpeed + (DeltaTime * CurrentAcc), Params.MinSpeed, Params.MaxSpeed);
+
+	// Target pitch speed is based on input, and we pitch down slightly when steering
+	float TargetPitchSpeed = (Input.MoveUp * Params.TurnSpeed * -1.f);
+	TargetPitchSpeed += (FMath::Abs(YawSpeed) * -0.2f);
+	PitchSpeed = FMath::FInterpTo(PitchSpeed, TargetPitchSpeed, DeltaTime, 2.f);
+
+	const float TargetYawSpeed = (Input.MoveRight * Params.TurnSpeed);
+	YawSpeed = FMath::FInterpTo(YawSpeed, TargetYawSpeed, DeltaTime, 2.f);
+
+	// If turning, yaw value is used to influence roll
+	// If not turning, roll to reverse current roll value
+	const bool bIsTurning = FMath::Abs(Input.MoveRight) > 0.2f;
+	const float TargetRollSpeed = bIsTurning ? (YawSpeed * 0.5f) : (Rotation.Rotator().Roll * -2.f);
+	RollSpeed = FMath::FInterpTo(RollSpeed, TargetRollSpeed, DeltaTime, 2.f);
+
+	// Move forwards along the current heading, then rotate in local space
+	Location += Rotation.RotateVector(FVector(ForwardSpeed * DeltaTime, 0.f, 0.f));
+	const FRotator DeltaRotation(PitchSpeed * DeltaTime, YawSpeed * DeltaTime, RollSpeed * DeltaTime);
+	Rotation = Rotation * DeltaRotation.Quaternion();
+	Rotation.Normalize();
+}
+
+int32 FAirplaneState::StepFixed(FAirplaneState& State, FAirplaneState& PreviousState, float& Accumulator, const FAirplaneInput& Input, const FAirplaneFlightParams& Params, float DeltaSeconds, float FixedTimeStep, int32 MaxSubSteps)
+{
+	Accumulator += DeltaSeconds;
+	int32 NumSteps = 0;
+	while (Accumulator >= FixedTimeStep && NumSteps < MaxSubSteps)
+	{
+		PreviousState = State;
+		State.Step(Input, Params, FixedTimeStep);
+		Accumulator -= FixedTimeStep;
+		NumSteps++;
+	}
+	// Drop whatever a long hitch left over rather than running it all next frame, keeping only the part step
+	if (Accumulator >= FixedTimeStep)
+	{
+		Accumulator = FMath::Fmod(Accumulator, FixedTimeStep);
+	}
+	return NumSteps;
+}
+
+FAirplaneState FAirplaneState::Interpolate(const FAirplaneState& From, const FAirplaneState& To, float Alpha)
+{
+	FAirplaneState Result;
+	Result.Location = FMath::Lerp(From.Location, To.Location, Alpha);
+	Result.Rotation = FQuat::Slerp(From.Rotation, To.Rotation, Alpha);
+	Result.ForwardSpeed = FMath::Lerp(From.ForwardSpeed, To.ForwardSpeed, Alpha);
+	Result.PitchSpeed = FMath::Lerp(From.PitchSpeed, To.PitchSpeed, Alpha);
+	Result.YawSpeed = FMath::Lerp(From.YawSpeed, To.YawSpeed, Alpha);
+	Result.RollSpeed = FMath::Lerp(From.RollSpeed, To.RollSpeed, Alpha);
+	return Result;
+}
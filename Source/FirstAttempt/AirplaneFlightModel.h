@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/** Stick and throttle for one flight model step, each from -1 to 1 */
+struct FAirplaneInput
+{
+	float Thrust;
+	float MoveUp;
+	float MoveRight;
+
+	FAirplaneInput()
+		: Thrust(0.f)
+		, MoveUp(0.f)
+		, MoveRight(0.f)
+	{
+	}
+};
+
+/** Handling values the flight model is run with, copied from the airplane's settings */
+struct FAirplaneFlightParams
+{
+	/** How quickly forward speed changes */
+	float Acceleration;
+
+	/** How quickly the plane can steer */
+	float TurnSpeed;
+
+	float MaxSpeed;
+
+	float MinSpeed;
+
+	FAirplaneFlightParams()
+		: Acceleration(500.f)
+		, TurnSpeed(50.f)
+		, MaxSpeed(4000.f)
+		, MinSpeed(0.f)
+	{
+	}
+};
+
+/**
+ * Everything the flight model needs to move a plane, with no actor or world behind it.
+ * Step only reads its arguments and writes the state, so the same inputs always give the same
+ * trajectory, and many planes can be stepped in a plain loop without touching the engine.
+ */
+struct FIRSTATTEMPT_API FAirplaneState
+{
+	FVector Location;
+	FQuat Rotation;
+
+	/** Current forward speed */
+	float ForwardSpeed;
+
+	/** Current pitch, yaw and roll speeds in degrees per second */
+	float PitchSpeed;
+	float YawSpeed;
+	float RollSpeed;
+
+	FAirplaneState()
+		: Location(FVector::ZeroVector)
+		, Rotation(FQuat::Identity)
+		, ForwardSpeed(0.f)
+		, PitchSpeed(0.f)
+		, YawSpeed(0.f)
+		, RollSpeed(0.f)
+	{
+	}
+
+	/** Advances the plane by DeltaTime. Meant to be called with a fixed DeltaTime */
+	void Step(const FAirplaneInput& Input, const FAirplaneFlightParams& Params, float DeltaTime);
+
+	/**
+	 * Adds DeltaSeconds to Accumulator and runs as many whole FixedTimeStep steps of State as fit, at most
+	 * MaxSubSteps, keeping the state before the last one in PreviousState. Time a long hitch leaves over is
+	 * dropped, so Accumulator is always less than FixedTimeStep afterwards. Returns the number of steps run.
+	 */
+	static int32 StepFixed(FAirplaneState& State, FAirplaneState& PreviousState, float& Accumulator, const FAirplaneInput& Input, const FAirplaneFlightParams& Params, float DeltaSeconds, float FixedTimeStep, int32 MaxSubSteps);
+
+	/** Blends between two steps for drawing the plane in between them */
+	static FAirplaneState Interpolate(const FAirplaneState& From, const FAirplaneState& To, float Alpha);
+};
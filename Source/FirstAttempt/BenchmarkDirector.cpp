@@ -0,0 +1,659 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "BenchmarkDirector.h"
+#include "Kismet/GameplayStatics.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "EnemySpawner.h"
+#include "ThirdPersonCharacter.h"
+#include "ThirdPersonVehicle.h"
+#include "FirstAttemptGameModeBase.h"
+#include "SpawnScheduler.h"
+#include "FlowFieldManager.h"
+#include "ProjectilePool.h"
+#include "BulletManager.h"
+#include "PerceptionManager.h"
+#include "Perception/PawnSensingComponent.h"
+#include "FirstAttemptStats.h"
+
+/** -BenchPursuit= names, in EEnemyPursuitMode order */
+static const TCHAR* PursuitModeNames[] = { TEXT("FlowField"), TEXT("PathQueue"), TEXT("MoveToActor") };
+
+/** -BenchScenario= names, in EBenchmarkScenario order */
+static const TCHAR* ScenarioNames[] = { TEXT("Mixed"), TEXT("Pursuit"), TEXT("PawnCache"), TEXT("Sensors"), TEXT("Bullets"), TEXT("Perception") };
+
+void FBenchmarkPhysicsTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->OnPhysicsTick(bIsStart);
+	}
+}
+
+FString FBenchmarkPhysicsTickFunction::DiagnosticMessage()
+{
+	return bIsStart ? TEXT("BenchmarkDirector StartPhysics") : TEXT("BenchmarkDirector EndPhysics");
+}
+
+ABenchmarkDirector::ABenchmarkDirector()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Sample once everything else in the frame has ticked
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	StartPhysicsTick.bCanEverTick = true;
+	StartPhysicsTick.TickGroup = TG_StartPhysics;
+	StartPhysicsTick.bIsStart = true;
+	EndPhysicsTick.bCanEverTick = true;
+	EndPhysicsTick.TickGroup = TG_EndPhysics;
+	EndPhysicsTick.bIsStart = false;
+
+	Scenario = EBenchmarkScenario::Mixed;
+	ScenarioSize = 0;
+	bScenarioBefore = false;
+	NumSpawners = 8;
+	NumVehicles = 20;
+	NumShooters = 30;
+	NumPursuers = 0;
+	PursuitMode = EEnemyPursuitMode::FlowField;
+	bCachePlayerPawn = true;
+	SensorRadius = 0.f;
+	NumBullets = 0;
+	NumWatchers = 0;
+	bWatchersUsePawnSensing = false;
+	bBulletsUseManager = false;
+	BulletHeight = 3000.f;
+	WarmUpTime = 5.f;
+	RecordTime = 30.f;
+	RegressionThreshold = 10.f;
+	MinComparableMs = 0.5f;
+	PlayerPathRadius = 2000.f;
+	PlayerPathPeriod = 20.f;
+	Spacing = 600.f;
+
+	SpawnerClass = AEnemySpawner::StaticClass();
+	EnemyClass = AThirdPersonCharacter::StaticClass();
+	VehicleClass = AThirdPersonVehicle::StaticClass();
+	ShooterClass = AThirdPersonCharacter::StaticClass();
+
+	Center = FVector::ZeroVector;
+	RunStartTime = 0.0;
+	LastTickTime = 0.0;
+	PhysicsStartTime = 0.0;
+	GCStartTime = 0.0;
+	CurrentPhysicsMs = 0.f;
+	CurrentGCMs = 0.f;
+	bFinished = false;
+}
+
+void ABenchmarkDirector::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void ABenchmarkDirector::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ReadCommandLine();
+	Center = GetActorLocation();
+
+	// Bracket the world's own physics ticks, otherwise these run anywhere in their tick groups and the time
+	// between them is mostly the rest of TG_DuringPhysics
+	UWorld *World = GetWorld();
+	StartPhysicsTick.Target = this;
+	StartPhysicsTick.RegisterTickFunction(GetLevel());
+	World->StartPhysicsTickFunction.AddPrerequisite(this, StartPhysicsTick);
+	EndPhysicsTick.Target = this;
+	EndPhysicsTick.AddPrerequisite(World, World->EndPhysicsTickFunction);
+	EndPhysicsTick.RegisterTickFunction(GetLevel());
+	PreGCHandle = FCoreUObjectDelegates::PreGarbageCollect.AddUObject(this, &ABenchmarkDirector::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::PostGarbageCollect.AddUObject(this, &ABenchmarkDirector::OnPostGarbageCollect);
+
+	SpawnScenario();
+
+	RunStartTime = GetWorld()->GetTimeSeconds();
+	LastTickTime = FPlatformTime::Seconds();
+	UE_LOG(LogTemp, Log, TEXT("Benchmark scenario %s%s"), ScenarioNames[(int32)Scenario], bScenarioBefore ? TEXT(", as before its change") : TEXT(""));
+	UE_LOG(LogTemp, Log, TEXT("Benchmark: %d spawners, %d vehicles, %d shooters, %d pursuers using %s, player pawn cache %s, sensors %.0f, %d bullets through %s, %d watchers using %s, %.0fs warm up, %.0fs recorded"),
+		NumSpawners, NumVehicles, NumShooters, NumPursuers, PursuitModeNames[(int32)PursuitMode], bCachePlayerPawn ? TEXT("on") : TEXT("off"), SensorRadius,
+		NumBullets, bBulletsUseManager ? TEXT("the bullet manager") : TEXT("projectile actors"),
+		NumWatchers, bWatchersUsePawnSensing ? TEXT("pawn sensing") : TEXT("the perception manager"), WarmUpTime, RecordTime);
+}
+
+void ABenchmarkDirector::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UWorld *World = GetWorld();
+	World->StartPhysicsTickFunction.RemovePrerequisite(this, StartPhysicsTick);
+	EndPhysicsTick.RemovePrerequisite(World, World->EndPhysicsTickFunction);
+	StartPhysicsTick.UnRegisterTickFunction();
+	EndPhysicsTick.UnRegisterTickFunction();
+	FCoreUObjectDelegates::PreGarbageCollect.Remove(PreGCHandle);
+	FCoreUObjectDelegates::PostGarbageCollect.Remove(PostGCHandle);
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABenchmarkDirector::ReadCommandLine()
+{
+	const TCHAR *CommandLine = FCommandLine::Get();
+	FString ScenarioName;
+	if (FParse::Value(CommandLine, TEXT("BenchScenario="), ScenarioName))
+	{
+		for (int32 i = 0; i < ARRAY_COUNT(ScenarioNames); i++)
+		{
+			if (ScenarioName == ScenarioNames[i])
+			{
+				Scenario = (EBenchmarkScenario)i;
+			}
+		}
+	}
+	FParse::Value(CommandLine, TEXT("BenchSize="), ScenarioSize);
+	if (FParse::Param(CommandLine, TEXT("BenchBefore")))
+	{
+		bScenarioBefore = true;
+	}
+	ApplyScenario();
+
+	FParse::Value(CommandLine, TEXT("BenchSpawners="), NumSpawners);
+	FParse::Value(CommandLine, TEXT("BenchVehicles="), NumVehicles);
+	FParse::Value(CommandLine, TEXT("BenchShooters="), NumShooters);
+	FParse::Value(CommandLine, TEXT("BenchPursuers="), NumPursuers);
+	FString PursuitModeName;
+	if (FParse::Value(CommandLine, TEXT("BenchPursuit="), PursuitModeName))
+	{
+		for (int32 i = 0; i < ARRAY_COUNT(PursuitModeNames); i++)
+		{
+			if (PursuitModeName == PursuitModeNames[i])
+			{
+				PursuitMode = (EEnemyPursuitMode)i;
+			}
+		}
+	}
+	if (FParse::Param(CommandLine, TEXT("BenchNoPawnCache")))
+	{
+		bCachePlayerPawn = false;
+	}
+	FParse::Value(CommandLine, TEXT("BenchSensors="), SensorRadius);
+	FParse::Value(CommandLine, TEXT("BenchBullets="), NumBullets);
+	FString BulletPath;
+	if (FParse::Value(CommandLine, TEXT("BenchBulletPath="), BulletPath))
+	{
+		bBulletsUseManager = (BulletPath == TEXT("Manager"));
+	}
+	FParse::Value(CommandLine, TEXT("BenchWatchers="), NumWatchers);
+	FString PerceptionName;
+	if (FParse::Value(CommandLine, TEXT("BenchPerception="), PerceptionName))
+	{
+		bWatchersUsePawnSensing = (PerceptionName == TEXT("PawnSensing"));
+	}
+	FParse::Value(CommandLine, TEXT("BenchWarmup="), WarmUpTime);
+	FParse::Value(CommandLine, TEXT("BenchDuration="), RecordTime);
+	FParse::Value(CommandLine, TEXT("BenchThreshold="), RegressionThreshold);
+	FParse::Value(CommandLine, TEXT("BenchBaseline="), BaselinePath);
+	if (!FParse::Value(CommandLine, TEXT("BenchReport="), ReportPath))
+	{
+		// A scenario run is named for what it ran, so the after run can find the before run as its baseline
+		ReportPath = (Scenario == EBenchmarkScenario::Mixed)
+			? FPaths::GameSavedDir() / TEXT("Benchmarks") / FString::Printf(TEXT("FirstAttempt-%s"), *FDateTime::Now().ToString())
+			: FPaths::GameSavedDir() / TEXT("Benchmarks") / FString::Printf(TEXT("%s-%d-%s"), ScenarioNames[(int32)Scenario], ScenarioSize, bScenarioBefore ? TEXT("Before") : TEXT("After"));
+	}
+}
+
+void ABenchmarkDirector::ApplyScenario()
+{
+	if (Scenario == EBenchmarkScenario::Mixed)
+	{
+		return;
+	}
+
+	// Only what the scenario measures, so the difference between before and after isn't lost in the rest
+	NumSpawners = 0;
+	NumShooters = 0;
+	NumVehicles = 0;
+	switch (Scenario)
+	{
+	case EBenchmarkScenario::Pursuit:
+		ScenarioSize = (ScenarioSize > 0) ? ScenarioSize : 500;
+		NumPursuers = ScenarioSize;
+		PursuitMode = bScenarioBefore ? EEnemyPursuitMode::MoveToActor : EEnemyPursuitMode::FlowField;
+		break;
+	case EBenchmarkScenario::PawnCache:
+		ScenarioSize = (ScenarioSize > 0) ? ScenarioSize : 500;
+		NumPursuers = ScenarioSize;
+		bCachePlayerPawn = !bScenarioBefore;
+		break;
+	case EBenchmarkScenario::Sensors:
+		ScenarioSize = (ScenarioSize > 0) ? ScenarioSize : 300;
+		NumVehicles = 100;
+		NumPursuers = ScenarioSize;
+		SensorRadius = bScenarioBefore ? 100.f : 0.f;
+		break;
+	case EBenchmarkScenario::Bullets:
+		ScenarioSize = (ScenarioSize > 0) ? ScenarioSize : 5000;
+		NumBullets = ScenarioSize;
+		bBulletsUseManager = !bScenarioBefore;
+		break;
+	case EBenchmarkScenario::Perception:
+		ScenarioSize = (ScenarioSize > 0) ? ScenarioSize : 200;
+		NumWatchers = ScenarioSize;
+		bWatchersUsePawnSensing = bScenarioBefore;
+		break;
+	default:
+		break;
+	}
+}
+
+void ABenchmarkDirector::SpawnScenario()
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	// Spawners in a ring round the player start, all going through the scheduler like the ones placed in the level
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	if (GameMode)
+	{
+		GameMode->GetGameplayContext().SetPlayerPawnCaching(bCachePlayerPawn);
+	}
+	ASpawnScheduler *Scheduler = GameMode ? GameMode->GetSpawnScheduler() : NULL;
+	for (int32 i = 0; i < NumSpawners && SpawnerClass; i++)
+	{
+		const float Angle = 2.f * PI * i / NumSpawners;
+		const FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * PlayerPathRadius * 1.5f;
+		AEnemySpawner *Spawner = GetWorld()->SpawnActor<AEnemySpawner>(SpawnerClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Spawner)
+		{
+			Spawner->SetWhatToSpawn(EnemyClass);
+			Spawner->GetWhereToSpawn()->SetBoxExtent(FVector(Spacing, Spacing, 100.f));
+			Spawner->BuildSpawnPointCache();
+			if (Scheduler)
+			{
+				Scheduler->SetSpawnerActive(Spawner, true);
+			}
+		}
+	}
+
+	// Parked vehicles in rows off to one side
+	const int32 VehiclesPerRow = 10;
+	for (int32 i = 0; i < NumVehicles && VehicleClass; i++)
+	{
+		const FVector Location = Center + FVector(-PlayerPathRadius - Spacing * (i / VehiclesPerRow), Spacing * ((i % VehiclesPerRow) - VehiclesPerRow / 2), 100.f);
+		AttachSensor(GetWorld()->SpawnActor<AThirdPersonVehicle>(VehicleClass, Location, FRotator::ZeroRotator, SpawnParams));
+	}
+
+	// Shooters in a circle inside the player's path, facing the middle and firing for the whole run
+	for (int32 i = 0; i < NumShooters && ShooterClass; i++)
+	{
+		const float Angle = 2.f * PI * i / NumShooters;
+		const FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * PlayerPathRadius * 0.5f;
+		const FRotator Rotation(0.f, FMath::RadiansToDegrees(Angle) + 180.f, 0.f);
+		AThirdPersonCharacter *Shooter = GetWorld()->SpawnActor<AThirdPersonCharacter>(ShooterClass, Location, Rotation, SpawnParams);
+		if (Shooter)
+		{
+			AttachSensor(Shooter);
+			// A plain controller, so the shooters stay put and fire instead of going after the player when they see them
+			Shooter->AIControllerClass = AAIController::StaticClass();
+			Shooter->SpawnDefaultController();
+			Shooter->StartShooting();
+		}
+	}
+
+	// Pursuers in a block on the far side of the circle from the vehicles, so they all have some way to go
+	const int32 PursuersPerRow = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(NumPursuers)));
+	const float PursuerSpacing = Spacing * 0.5f;
+	for (int32 i = 0; i < NumPursuers && EnemyClass; i++)
+	{
+		const FVector Location = Center + FVector(PlayerPathRadius * 2.f + PursuerSpacing * (i / PursuersPerRow), PursuerSpacing * ((i % PursuersPerRow) - PursuersPerRow / 2), 100.f);
+		AThirdPersonCharacter *Pursuer = GetWorld()->SpawnActor<AThirdPersonCharacter>(EnemyClass, Location, FRotator(0.f, 180.f, 0.f), SpawnParams);
+		if (Pursuer)
+		{
+			AttachSensor(Pursuer);
+			Pursuer->SpawnDefaultController();
+			AEnemyController *Controller = Cast<AEnemyController>(Pursuer->GetController());
+			if (Controller)
+			{
+				Controller->PursuitMode = PursuitMode;
+				Pursuers.Add(Controller);
+			}
+		}
+	}
+
+	// Watchers in rings just outside the player's circle, facing the middle
+	static const int32 WatchersPerRing = 100;
+	APerceptionManager *PerceptionManager = GameMode ? GameMode->GetPerceptionManager() : NULL;
+	for (int32 i = 0; i < NumWatchers && EnemyClass; i++)
+	{
+		const int32 Ring = i / WatchersPerRing;
+		const int32 NumInRing = FMath::Min(WatchersPerRing, NumWatchers - Ring * WatchersPerRing);
+		const float Angle = 2.f * PI * (i % WatchersPerRing) / NumInRing;
+		const FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * (PlayerPathRadius * 1.25f + Ring * Spacing * 0.5f);
+		const FRotator Rotation(0.f, FMath::RadiansToDegrees(Angle) + 180.f, 0.f);
+		AThirdPersonCharacter *Watcher = GetWorld()->SpawnActor<AThirdPersonCharacter>(EnemyClass, Location, Rotation, SpawnParams);
+		if (Watcher == NULL)
+		{
+			continue;
+		}
+		// A plain controller, so seeing the player costs the same callback either way but nobody moves
+		Watcher->AIControllerClass = AAIController::StaticClass();
+		Watcher->SpawnDefaultController();
+		if (bWatchersUsePawnSensing)
+		{
+			if (PerceptionManager)
+			{
+				PerceptionManager->RemovePerceiver(Watcher);
+			}
+			UPawnSensingComponent *PawnSensing = NewObject<UPawnSensingComponent>(Watcher, TEXT("PawnSensingComponent"));
+			PawnSensing->SetPeripheralVisionAngle(90.f);
+			PawnSensing->OnSeePawn.AddDynamic(Watcher, &AThirdPersonCharacter::OnSeePlayer);
+			PawnSensing->RegisterComponent();
+		}
+	}
+
+	BulletStream.Initialize(1);
+	AProjectilePool *ProjectilePool = (GameMode && NumBullets > 0 && !bBulletsUseManager) ? GameMode->GetProjectilePool() : NULL;
+	if (ProjectilePool)
+	{
+		ProjectilePool->SetMaxPoolSize(NumBullets);
+	}
+}
+
+void ABenchmarkDirector::KeepBulletsInFlight()
+{
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	if (GameMode == NULL || NumBullets <= 0)
+	{
+		return;
+	}
+	ABulletManager *BulletManager = bBulletsUseManager ? GameMode->GetBulletManager() : NULL;
+	AProjectilePool *ProjectilePool = bBulletsUseManager ? NULL : GameMode->GetProjectilePool();
+	const int32 NumInFlight = BulletManager ? BulletManager->GetNumBullets() : (ProjectilePool ? ProjectilePool->GetNumActive() : NumBullets);
+	const int32 NumToFire = FMath::Min(NumBullets - NumInFlight, FMath::Max(1, NumBullets / 60));
+	for (int32 i = 0; i < NumToFire; i++)
+	{
+		// Level and outwards from somewhere over the player's circle, so they fly their whole life without hitting anything
+		const FVector Location = Center + FVector(BulletStream.FRandRange(-PlayerPathRadius, PlayerPathRadius), BulletStream.FRandRange(-PlayerPathRadius, PlayerPathRadius), BulletHeight);
+		const FRotator Rotation(0.f, BulletStream.FRandRange(0.f, 360.f), 0.f);
+		if (BulletManager)
+		{
+			BulletManager->FireBullet(Location, Rotation, this);
+		}
+		else if (ProjectilePool)
+		{
+			ProjectilePool->AcquireProjectile(Location, Rotation);
+		}
+	}
+}
+
+void ABenchmarkDirector::AttachSensor(APawn* Pawn) const
+{
+	if (Pawn == NULL || SensorRadius <= 0.f)
+	{
+		return;
+	}
+	USphereComponent *Sensor = NewObject<USphereComponent>(Pawn, TEXT("Sensor"));
+	Sensor->SetupAttachment(Pawn->GetRootComponent());
+	Sensor->SetSphereRadius(SensorRadius, false);
+	Sensor->SetCollisionProfileName(TEXT("OverlapAllDynamic"));
+	Sensor->bGenerateOverlapEvents = true;
+	Sensor->RegisterComponent();
+}
+
+void ABenchmarkDirector::DrivePlayer()
+{
+	APlayerController *PlayerController = UGameplayStatics::GetPlayerController(this, 0);
+	APawn *PlayerPawn = PlayerController ? PlayerController->GetPawn() : NULL;
+	if (PlayerPawn == NULL)
+	{
+		return;
+	}
+	// Head for where the path says the player should be by now, so every run walks the same circle
+	const float Angle = 2.f * PI * (GetWorld()->GetTimeSeconds() - RunStartTime) / PlayerPathPeriod;
+	const FVector Target = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * PlayerPathRadius;
+	FVector ToTarget = Target - PlayerPawn->GetActorLocation();
+	ToTarget.Z = 0.f;
+	PlayerPawn->AddMovementInput(ToTarget.GetSafeNormal(), 1.f);
+	PlayerController->SetControlRotation((Center - PlayerPawn->GetActorLocation()).Rotation());
+
+	// Pursuers always know where the player is, whether or not they can see them
+	for (const TWeakObjectPtr<AEnemyController>& Pursuer : Pursuers)
+	{
+		if (Pursuer.IsValid())
+		{
+			Pursuer->OnSeeTarget(PlayerPawn);
+		}
+	}
+}
+
+float ABenchmarkDirector::GetPathfindingMs() const
+{
+	float PathfindingMs = 0.f;
+#if FIRSTATTEMPT_TIMINGS
+	// This runs after every controller and manager has ticked and before the counters roll over at the end of the frame
+	static FGameplayTimingCounter *Counters[] =
+	{
+		FGameplayTimings::FindOrAddCounter(TEXT("STAT_EnemyPursuit")),
+		FGameplayTimings::FindOrAddCounter(TEXT("STAT_PathRequestTick")),
+		FGameplayTimings::FindOrAddCounter(TEXT("STAT_FlowFieldTick"))
+	};
+	for (const FGameplayTimingCounter *Counter : Counters)
+	{
+		PathfindingMs += FPlatformTime::ToMilliseconds(Counter->FrameCycles);
+	}
+#endif
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	AFlowFieldManager *FlowField = (GameMode && PursuitMode == EEnemyPursuitMode::FlowField) ? GameMode->GetFlowFieldManager() : NULL;
+	if (FlowField)
+	{
+		PathfindingMs += FlowField->GetRebuildMsLastFrame();
+	}
+	return PathfindingMs;
+}
+
+void ABenchmarkDirector::OnPhysicsTick(bool bIsStart)
+{
+	if (bIsStart)
+	{
+		PhysicsStartTime = FPlatformTime::Seconds();
+	}
+	else
+	{
+		CurrentPhysicsMs = (FPlatformTime::Seconds() - PhysicsStartTime) * 1000.0;
+	}
+}
+
+void ABenchmarkDirector::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void ABenchmarkDirector::OnPostGarbageCollect()
+{
+	CurrentGCMs += (FPlatformTime::Seconds() - GCStartTime) * 1000.0;
+}
+
+void ABenchmarkDirector::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const double Now = FPlatformTime::Seconds();
+	const float FrameMs = (Now - LastTickTime) * 1000.0;
+	LastTickTime = Now;
+
+	if (bFinished)
+	{
+		return;
+	}
+	DrivePlayer();
+	KeepBulletsInFlight();
+
+	// GGameThreadTime is set once a frame is over, so what it holds now belongs to the sample taken last tick
+	if (Samples.Num() > 0)
+	{
+		Samples.Last().GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	}
+
+	const float RunTime = GetWorld()->GetTimeSeconds() - RunStartTime;
+	if (RunTime >= WarmUpTime + RecordTime)
+	{
+		FinishRun();
+		return;
+	}
+
+	// Garbage collection runs after the world has ticked, so it lands in the next frame's sample
+	if (RunTime >= WarmUpTime)
+	{
+		FFrameSample Sample;
+		Sample.FrameMs = FrameMs;
+		Sample.GameThreadMs = 0.f;
+		Sample.PhysicsMs = CurrentPhysicsMs;
+		Sample.GCMs = CurrentGCMs;
+		Sample.PathfindingMs = GetPathfindingMs();
+		Samples.Add(Sample);
+	}
+	CurrentPhysicsMs = 0.f;
+	CurrentGCMs = 0.f;
+}
+
+void ABenchmarkDirector::AddMetric(const TSharedRef<FJsonObject>& Metrics, const FString& Name, float FFrameSample::*Field) const
+{
+	TArray<float> Values;
+	Values.Reserve(Samples.Num());
+	double Total = 0.0;
+	for (const FFrameSample& Sample : Samples)
+	{
+		Values.Add(Sample.*Field);
+		Total += Sample.*Field;
+	}
+	Values.Sort();
+
+	// Nearest rank percentile
+	auto Percentile = [&Values](float Percent)
+	{
+		const int32 Rank = FMath::CeilToInt(Percent / 100.f * Values.Num()) - 1;
+		return Values.Num() > 0 ? Values[FMath::Clamp(Rank, 0, Values.Num() - 1)] : 0.f;
+	};
+
+	TSharedRef<FJsonObject> Metric = MakeShareable(new FJsonObject());
+	Metric->SetNumberField(TEXT("Avg"), Values.Num() > 0 ? Total / Values.Num() : 0.0);
+	Metric->SetNumberField(TEXT("P50"), Percentile(50.f));
+	Metric->SetNumberField(TEXT("P95"), Percentile(95.f));
+	Metric->SetNumberField(TEXT("P99"), Percentile(99.f));
+	Metric->SetNumberField(TEXT("Max"), Values.Num() > 0 ? Values.Last() : 0.f);
+	Metrics->SetObjectField(Name, Metric);
+}
+
+bool ABenchmarkDirector::CompareWithBaseline(const TSharedRef<FJsonObject>& Summary, const TSharedPtr<FJsonObject>& Baseline) const
+{
+	const TSharedPtr<FJsonObject> *BaselineMetrics = NULL;
+	if (!Baseline.IsValid() || !Baseline->TryGetObjectField(TEXT("Metrics"), BaselineMetrics))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Benchmark: baseline %s has no metrics, skipping the regression check"), *BaselinePath);
+		return true;
+	}
+	bool bPassed = true;
+	const TSharedPtr<FJsonObject> Metrics = Summary->GetObjectField(TEXT("Metrics"));
+	for (const auto& Pair : Metrics->Values)
+	{
+		const TSharedPtr<FJsonObject> *BaselineMetric = NULL;
+		if (!(*BaselineMetrics)->TryGetObjectField(Pair.Key, BaselineMetric))
+		{
+			continue;
+		}
+		const TSharedPtr<FJsonObject> Metric = Pair.Value->AsObject();
+		const TCHAR *Fields[] = { TEXT("P50"), TEXT("P95") };
+		for (const TCHAR *Field : Fields)
+		{
+			const double Before = (*BaselineMetric)->GetNumberField(Field);
+			const double After = Metric->GetNumberField(Field);
+			if (Before >= MinComparableMs && After > Before * (1.0 + RegressionThreshold / 100.0))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Benchmark regression: %s %s went from %.2fms to %.2fms (%+.1f%%, limit %.1f%%)"),
+					*Pair.Key, Field, Before, After, (After / Before - 1.0) * 100.0, RegressionThreshold);
+				bPassed = false;
+			}
+		}
+	}
+	return bPassed;
+}
+
+void ABenchmarkDirector::FinishRun()
+{
+	bFinished = true;
+
+	// Every frame, for graphing
+	FString Csv = TEXT("Frame,FrameMs,GameThreadMs,PhysicsMs,GCMs,PathfindingMs\n");
+	for (int32 i = 0; i < Samples.Num(); i++)
+	{
+		const FFrameSample& Sample = Samples[i];
+		Csv += FString::Printf(TEXT("%d,%.3f,%.3f,%.3f,%.3f,%.3f\n"), i, Sample.FrameMs, Sample.GameThreadMs, Sample.PhysicsMs, Sample.GCMs, Sample.PathfindingMs);
+	}
+	FFileHelper::SaveStringToFile(Csv, *(ReportPath + TEXT(".csv")));
+
+	TSharedRef<FJsonObject> ScenarioInfo = MakeShareable(new FJsonObject());
+	ScenarioInfo->SetStringField(TEXT("Name"), ScenarioNames[(int32)Scenario]);
+	ScenarioInfo->SetBoolField(TEXT("Before"), bScenarioBefore);
+	ScenarioInfo->SetNumberField(TEXT("Spawners"), NumSpawners);
+	ScenarioInfo->SetNumberField(TEXT("Vehicles"), NumVehicles);
+	ScenarioInfo->SetNumberField(TEXT("Shooters"), NumShooters);
+	ScenarioInfo->SetNumberField(TEXT("Pursuers"), NumPursuers);
+	ScenarioInfo->SetStringField(TEXT("Pursuit"), PursuitModeNames[(int32)PursuitMode]);
+	ScenarioInfo->SetBoolField(TEXT("PlayerPawnCache"), bCachePlayerPawn);
+	ScenarioInfo->SetNumberField(TEXT("SensorRadius"), SensorRadius);
+	ScenarioInfo->SetNumberField(TEXT("Watchers"), NumWatchers);
+	ScenarioInfo->SetStringField(TEXT("Perception"), bWatchersUsePawnSensing ? TEXT("PawnSensing") : TEXT("Manager"));
+	ScenarioInfo->SetNumberField(TEXT("Bullets"), NumBullets);
+	ScenarioInfo->SetStringField(TEXT("BulletPath"), bBulletsUseManager ? TEXT("Manager") : TEXT("Actor"));
+	ScenarioInfo->SetNumberField(TEXT("RecordTime"), RecordTime);
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	if (GameMode)
+	{
+		// Runs only compare like for like when they were seeded the same
+		ScenarioInfo->SetNumberField(TEXT("Seed"), (double)GameMode->GetRandomSeed());
+	}
+
+	TSharedRef<FJsonObject> Metrics = MakeShareable(new FJsonObject());
+	AddMetric(Metrics, TEXT("FrameMs"), &FFrameSample::FrameMs);
+	AddMetric(Metrics, TEXT("GameThreadMs"), &FFrameSample::GameThreadMs);
+	AddMetric(Metrics, TEXT("PhysicsMs"), &FFrameSample::PhysicsMs);
+	AddMetric(Metrics, TEXT("GCMs"), &FFrameSample::GCMs);
+	AddMetric(Metrics, TEXT("PathfindingMs"), &FFrameSample::PathfindingMs);
+
+	TSharedRef<FJsonObject> Summary = MakeShareable(new FJsonObject());
+	Summary->SetStringField(TEXT("Map"), GetWorld()->GetMapName());
+	Summary->SetObjectField(TEXT("Scenario"), ScenarioInfo);
+	Summary->SetNumberField(TEXT("Frames"), Samples.Num());
+	Summary->SetObjectField(TEXT("Metrics"), Metrics);
+
+	bool bPassed = true;
+	if (!BaselinePath.IsEmpty())
+	{
+		FString BaselineText;
+		TSharedPtr<FJsonObject> Baseline;
+		if (FFileHelper::LoadFileToString(BaselineText, *BaselinePath) && FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline))
+		{
+			bPassed = CompareWithBaseline(Summary, Baseline);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Benchmark: could not read baseline %s"), *BaselinePath);
+		}
+	}
+	Summary->SetBoolField(TEXT("Passed"), bPassed);
+
+	FString Json;
+	FJsonSerializer::Serialize(Summary, TJsonWriterFactory<>::Create(&Json));
+	FFileHelper::SaveStringToFile(Json, *(ReportPath + TEXT(".json")));
+
+	if (bPassed)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Benchmark passed, %d frames written to %s.json"), Samples.Num(), *ReportPath);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Benchmark FAILED against %s, %d frames written to %s.json"), *BaselinePath, Samples.Num(), *ReportPath);
+	}
+	UKismetSystemLibrary::QuitGame(this, nullptr, EQuitPreference::Quit);
+}
@@ -0,0 +1,265 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "EnemyController.h"
+#include "GameplayContext.h"
+#include "BenchmarkDirector.generated.h"
+
+class ABenchmarkDirector;
+
+/** Marks the start or end of the physics tick groups so the director can time the physics step */
+USTRUCT()
+struct FBenchmarkPhysicsTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	ABenchmarkDirector* Target;
+
+	/** True for the tick in TG_StartPhysics, false for the one in TG_EndPhysics */
+	bool bIsStart;
+
+	FBenchmarkPhysicsTickFunction()
+		: Target(nullptr)
+		, bIsStart(false)
+	{
+	}
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBenchmarkPhysicsTickFunction> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/** The benchmarks the director can be asked for with -BenchScenario=, each a before and after pair of one change */
+UENUM(BlueprintType)
+enum class EBenchmarkScenario : uint8
+{
+	/** Spawners, parked vehicles and shooters together, as set by the individual -Bench options */
+	Mixed,
+	/** Enemies chasing the player through the flow field, or each calling MoveToActor before */
+	Pursuit,
+	/** Enemies chasing the player with the gameplay context's player pawn cache, or without it before */
+	PawnCache,
+	/** Parked vehicles and pursuers found through the possessable registry, or with an overlap sensor each before */
+	Sensors,
+	/** Bullets in flight through the bullet manager, or as projectile actors before */
+	Bullets,
+	/** Enemies watching the player through the perception manager, or with pawn sensing each before */
+	Perception
+};
+
+/**
+ * Runs a scripted performance scenario and writes a frame time report. The game mode spawns one when the
+ * game is started with -FirstAttemptBenchmark. It records frame, game thread, physics, garbage collection and
+ * pathfinding times for every frame after the warm up, writes a CSV of them and a JSON summary with p50/p95/p99,
+ * compares the summary against -BenchBaseline= if given and quits. Scripts/RunBenchmark.py runs a scenario
+ * before and after at each of its sizes and prints the comparison.
+ */
+UCLASS()
+class FIRSTATTEMPT_API ABenchmarkDirector : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	ABenchmarkDirector();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Which benchmark to set up. -BenchScenario= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	EBenchmarkScenario Scenario;
+
+	/** How many of the scenario's actors or bullets to run with, 0 for its usual size. -BenchSize= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	int32 ScenarioSize;
+
+	/** Run the scenario the way it was before its change, to record a baseline. -BenchBefore */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	bool bScenarioBefore;
+
+	/** Number of enemy spawners to place. -BenchSpawners= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	int32 NumSpawners;
+
+	/** Number of parked vehicles to place. -BenchVehicles= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	int32 NumVehicles;
+
+	/** Number of enemies that fire for the whole run. -BenchShooters= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	int32 NumShooters;
+
+	/** Number of enemies that chase the player for the whole run. -BenchPursuers= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	int32 NumPursuers;
+
+	/** How the pursuers find their way. -BenchPursuit=FlowField, PathQueue or MoveToActor */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	EEnemyPursuitMode PursuitMode;
+
+	/** Whether the gameplay context keeps the player pawn between possessions. -BenchNoPawnCache turns it off */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	bool bCachePlayerPawn;
+
+	/** Radius of the overlap sphere attached to every placed pawn, 0 for none. -BenchSensors= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float SensorRadius;
+
+	/** Number of bullets kept in flight. -BenchBullets= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	int32 NumBullets;
+
+	/** Fire the bullets through the bullet manager instead of projectile actors. -BenchBulletPath=Manager */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	bool bBulletsUseManager;
+
+	/** Height above the player start the bullets are fired at, clear of the level */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float BulletHeight;
+
+	/** Number of enemies standing watching the player's circle. -BenchWatchers= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	int32 NumWatchers;
+
+	/** Give the watchers their own pawn sensing instead of the perception manager. -BenchPerception=PawnSensing */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	bool bWatchersUsePawnSensing;
+
+	/** Seconds to run before recording starts, so pools and caches have filled. -BenchWarmup= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float WarmUpTime;
+
+	/** Seconds to record for. -BenchDuration= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float RecordTime;
+
+	/** How much slower than the baseline, in percent, a p50 or p95 can get before the run fails. -BenchThreshold= */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float RegressionThreshold;
+
+	/** Timings below this many milliseconds in the baseline are too noisy to compare */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float MinComparableMs;
+
+	/** Radius of the circle the player walks round */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float PlayerPathRadius;
+
+	/** Seconds for the player to go once round the circle */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float PlayerPathPeriod;
+
+	/** Distance between placed actors */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	float Spacing;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	TSubclassOf<class AEnemySpawner> SpawnerClass;
+
+	/** What the placed spawners spawn */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	TSubclassOf<class AThirdPersonCharacter> EnemyClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	TSubclassOf<class AThirdPersonVehicle> VehicleClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark")
+	TSubclassOf<class AThirdPersonCharacter> ShooterClass;
+
+	void OnPhysicsTick(bool bIsStart);
+
+private:
+	/** Where the game mode and its managers are reached from, bound once instead of a cast per call */
+	FGameplayContextHandle GameplayContext;
+
+	struct FFrameSample
+	{
+		float FrameMs;
+		float GameThreadMs;
+		float PhysicsMs;
+		float GCMs;
+		float PathfindingMs;
+	};
+
+	void ReadCommandLine();
+
+	/** Sets the counts and code paths for Scenario, which the individual -Bench options can then override */
+	void ApplyScenario();
+
+	void SpawnScenario();
+
+	/** Gives a placed pawn an overlap sphere like the ones SwitchPawns used to query, if SensorRadius is set */
+	void AttachSensor(APawn* Pawn) const;
+
+	/** Fires enough bullets to make up NumBullets in flight, a share of them each frame so they don't all expire together */
+	void KeepBulletsInFlight();
+
+	/** Walks the player round the circle and points the camera at the middle */
+	void DrivePlayer();
+
+	/** Game thread time spent finding paths this frame, plus any flow field rebuild that finished */
+	float GetPathfindingMs() const;
+
+	void OnPreGarbageCollect();
+
+	void OnPostGarbageCollect();
+
+	/** Writes the reports, checks the baseline and quits */
+	void FinishRun();
+
+	/** Adds Avg/P50/P95/P99 of one column of the samples to Metrics */
+	void AddMetric(const TSharedRef<class FJsonObject>& Metrics, const FString& Name, float FFrameSample::*Field) const;
+
+	/** Returns false if any metric in Summary is more than RegressionThreshold percent slower than in Baseline */
+	bool CompareWithBaseline(const TSharedRef<class FJsonObject>& Summary, const TSharedPtr<class FJsonObject>& Baseline) const;
+
+	FBenchmarkPhysicsTickFunction StartPhysicsTick;
+
+	FBenchmarkPhysicsTickFunction EndPhysicsTick;
+
+	TArray<FFrameSample> Samples;
+
+	/** Controllers of the enemies chasing the player, told where the player is every frame */
+	TArray<TWeakObjectPtr<AEnemyController>> Pursuers;
+
+	/** Where to write the report, without the extension. -BenchReport= */
+	FString ReportPath;
+
+	/** JSON summary from an earlier run to compare against. -BenchBaseline= */
+	FString BaselinePath;
+
+	FVector Center;
+
+	/** Where bullets are fired from and which way, the same for every run */
+	FRandomStream BulletStream;
+
+	double RunStartTime;
+
+	double LastTickTime;
+
+	double PhysicsStartTime;
+
+	double GCStartTime;
+
+	float CurrentPhysicsMs;
+
+	float CurrentGCMs;
+
+	bool bFinished;
+
+	FDelegateHandle PreGCHandle;
+
+	FDelegateHandle PostGCHandle;
+};
@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "BulletManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Projectile.h"
+#include "ThirdPersonVehicle.h"
+#include "ContentPreloader.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Bullet Manager Tick"), STAT_BulletManagerTick, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bullets In Flight"), STAT_BulletsInFlight, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bullet Traces"), STAT_BulletTraces, STATGROUP_FirstAttempt);
+DECLARE_MEMORY_STAT(TEXT("Bullet State Memory"), STAT_BulletStateMemory, STATGROUP_FirstAttempt);
+
+static const FName BulletCollisionProfile(TEXT("Projectile"));
+static const FName BulletTraceTag(TEXT("BulletTrace"));
+
+ABulletManager::ABulletManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	BulletInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("BulletInstances0"));
+	BulletInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	BulletInstances->CastShadow = false;
+	BulletInstances->SetMobility(EComponentMobility::Movable);
+	RootComponent = BulletInstances;
+
+	const AProjectile *DefaultProjectile = GetDefault<AProjectile>();
+	// Same sphere as AProjectile, drawn once for all bullets
+	BulletMeshAsset = DefaultProjectile->ProjectileMeshAsset;
+	BulletSpeed = DefaultProjectile->GetProjectileMovement() ? DefaultProjectile->GetProjectileMovement()->InitialSpeed : 3000.f;
+	BulletLifeSpan = DefaultProjectile->FlightLifeSpan;
+	MaxBullets = 32768;
+	NumInstances = 0;
+	NumVisibleInstances = 0;
+}
+
+void ABulletManager::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	if (BulletInstances->GetStaticMesh() == NULL)
+	{
+		BulletInstances->SetStaticMesh(AContentPreloader::Resolve(BulletMeshAsset));
+	}
+}
+
+void ABulletManager::GetContentAssets(TArray<FStringAssetReference>& OutAssets) const
+{
+	OutAssets.AddUnique(BulletMeshAsset.ToStringReference());
+}
+
+void ABulletManager::FireBullet(const FVector& Location, const FRotator& Rotation, AActor* BulletInstigator)
+{
+	if (MaxBullets <= 0)
+	{
+		return;
+	}
+	if (Positions.Num() >= MaxBullets)
+	{
+		// Removing by swapping mixes up the firing order, so the oldest bullet is the one with the least life left.
+		// It's only looked for when over budget, and the new bullet takes its slot
+		int32 Oldest = 0;
+		for (int32 i = 1; i < RemainingLife.Num(); ++i)
+		{
+			if (RemainingLife[i] < RemainingLife[Oldest])
+			{
+				Oldest = i;
+			}
+		}
+		Positions[Oldest] = Location;
+		Velocities[Oldest] = Rotation.Vector() * BulletSpeed;
+		RemainingLife[Oldest] = BulletLifeSpan;
+		Instigators[Oldest] = BulletInstigator;
+		return;
+	}
+	Positions.Add(Location);
+	Velocities.Add(Rotation.Vector() * BulletSpeed);
+	RemainingLife.Add(BulletLifeSpan);
+	Instigators.Add(BulletInstigator);
+}
+
+void ABulletManager::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_BulletManagerTick);
+	Super::Tick(DeltaSeconds);
+
+	UWorld *World = GetWorld();
+	FCollisionQueryParams QueryParams(BulletTraceTag, false, this);
+	int32 NumTraces = 0;
+
+	// Walk backwards so removing a bullet only disturbs entries we have already handled
+	for (int32 i = Positions.Num() - 1; i >= 0; i--)
+	{
+		RemainingLife[i] -= DeltaSeconds;
+		if (RemainingLife[i] <= 0.f)
+		{
+			RemoveBullet(i);
+			continue;
+		}
+
+		const FVector Start = Positions[i];
+		const FVector End = Start + Velocities[i] * DeltaSeconds;
+
+		QueryParams.ClearIgnoredActors();
+		QueryParams.AddIgnoredActor(this);
+		AActor *BulletInstigator = Instigators[i].Get();
+		if (BulletInstigator)
+		{
+			QueryParams.AddIgnoredActor(BulletInstigator);
+		}
+
+		FHitResult Hit;
+		NumTraces++;
+		if (World->LineTraceSingleByProfile(Hit, Start, End, BulletCollisionProfile, QueryParams))
+		{
+			// Same rule as AProjectile::OnHit, only push things that are simulating physics
+			UPrimitiveComponent *OtherComp = Hit.GetComponent();
+			if ((Hit.GetActor() != NULL) && (OtherComp != NULL) && OtherComp->IsSimulatingPhysics())
+			{
+				// A trace doesn't raise a hit on what it hits, so a parked car has to be woken here or the push does nothing
+				AThirdPersonVehicle *Vehicle = Cast<AThirdPersonVehicle>(Hit.GetActor());
+				if (Vehicle)
+				{
+					Vehicle->SetDormant(false);
+				}
+				OtherComp->AddImpulseAtLocation(Velocities[i] * 20.0f, Hit.ImpactPoint);
+			}
+			RemoveBullet(i);
+			continue;
+		}
+
+		Positions[i] = End;
+	}
+
+	UpdateInstances();
+
+	SET_DWORD_STAT(STAT_BulletsInFlight, Positions.Num());
+	SET_DWORD_STAT(STAT_BulletTraces, NumTraces);
+	SET_MEMORY_STAT(STAT_BulletStateMemory, Positions.GetAllocatedSize() + Velocities.GetAllocatedSize() + RemainingLife.GetAllocatedSize() + Instigators.GetAllocatedSize());
+}
+
+void ABulletManager::RemoveBullet(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	RemainingLife.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+}
+
+void ABulletManager::UpdateInstances()
+{
+	const int32 NumBullets = Positions.Num();
+	const FVector BulletScale(.3f, .3f, .3f);
+
+	while (NumInstances < NumBullets)
+	{
+		BulletInstances->AddInstanceWorldSpace(FTransform(FRotator::ZeroRotator, Positions[NumInstances], BulletScale));
+		NumInstances++;
+	}
+
+	// Update everything without dirtying the render state, then dirty it once at the end
+	for (int32 i = 0; i < NumBullets; i++)
+	{
+		BulletInstances->UpdateInstanceTransform(i, FTransform(FRotator::ZeroRotator, Positions[i], BulletScale), true, false, true);
+	}
+	for (int32 i = NumBullets; i < NumVisibleInstances; i++)
+	{
+		BulletInstances->UpdateInstanceTransform(i, FTransform(FRotator::ZeroRotator, GetActorLocation(), FVector::ZeroVector), true, false, true);
+	}
+	if (NumBullets > 0 || NumVisibleInstances > 0)
+	{
+		BulletInstances->MarkRenderStateDirty();
+	}
+	NumVisibleInstances = NumBullets;
+}
+
+int32 ABulletManager::GetNumBullets() const
+{
+	return Positions.Num();
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "PreloadedContent.h"
+#include "BulletManager.generated.h"
+
+class UInstancedStaticMeshComponent;
+
+/**
+ * Simulates every live bullet in one place instead of one AProjectile actor per shot.
+ * Bullets are stored as parallel arrays, moved in a single tick with a line trace each for collision
+ * and drawn through one instanced static mesh component.
+ */
+UCLASS()
+class FIRSTATTEMPT_API ABulletManager : public AInfo, public IPreloadedContent
+{
+	GENERATED_BODY()
+
+	/** Draws every live bullet */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Bullets, meta = (AllowPrivateAccess = "true"))
+	UInstancedStaticMeshComponent* BulletInstances;
+
+public:
+	ABulletManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+	/** Adds the soft referenced content the bullet manager needs to the list, for the content preloader */
+	virtual void GetContentAssets(TArray<FStringAssetReference>& OutAssets) const override;
+
+	/** Adds a bullet travelling along Rotation. The instigator is never hit by its own bullets */
+	void FireBullet(const FVector& Location, const FRotator& Rotation, AActor* BulletInstigator);
+
+	/** Number of bullets currently in flight */
+	UFUNCTION(BlueprintPure, Category = "Bullets")
+	int32 GetNumBullets() const;
+
+	/** Speed of every bullet, taken from AProjectile so both paths behave the same */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullets")
+	float BulletSpeed;
+
+	/** How long a bullet flies before it is removed */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullets")
+	float BulletLifeSpan;
+
+	/** Bullets fired past this many replace the oldest one */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullets")
+	int32 MaxBullets;
+
+	/** Mesh every bullet is drawn with, taken from AProjectile */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Bullets")
+	TAssetPtr<UStaticMesh> BulletMeshAsset;
+
+	/** Returns BulletInstances subobject **/
+	FORCEINLINE UInstancedStaticMeshComponent* GetBulletInstances() const { return BulletInstances; }
+
+private:
+	/** Removes bullet Index by swapping the last bullet into its place */
+	void RemoveBullet(int32 Index);
+
+	/** Pushes the simulated positions to the instanced mesh, hiding instances that are not in use */
+	void UpdateInstances();
+
+	// Bullet state, one entry per live bullet in each array
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> RemainingLife;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+
+	/** Instances added to the mesh component so far. Unused ones are scaled to zero rather than removed */
+	int32 NumInstances;
+
+	/** Instances that were showing a bullet after the last update */
+	int32 NumVisibleInstances;
+};
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "ContentPreloader.h"
+#include "ThirdPersonCharacter.h"
+#include "ThirdPersonVehicle.h"
+#include "Projectile.h"
+#include "Airplane.h"
+#include "BulletManager.h"
+#include "CrowdManager.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Content Blocking Loads"), STAT_ContentBlockingLoads, STATGROUP_FirstAttempt);
+DECLARE_MEMORY_STAT(TEXT("Preloaded Content Memory"), STAT_PreloadedContentMemory, STATGROUP_FirstAttempt);
+
+AContentPreloader::AContentPreloader()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	ManifestClasses.Add(AThirdPersonCharacter::StaticClass());
+	ManifestClasses.Add(AThirdPersonVehicle::StaticClass());
+	ManifestClasses.Add(AProjectile::StaticClass());
+	ManifestClasses.Add(ABulletManager::StaticClass());
+	ManifestClasses.Add(AAirplane::StaticClass());
+	ManifestClasses.Add(ACrowdManager::StaticClass());
+	PreloadStartTime = 0.0;
+	PreloadTime = 0.0;
+	bPreloadStarted = false;
+	bPreloadComplete = false;
+}
+
+UObject* AContentPreloader::LoadBlocking(const FStringAssetReference& Reference, UClass* AssetClass)
+{
+	// Anything that ends up here stalls the game thread, which is what the preload is there to avoid
+	UE_LOG(LogTemp, Log, TEXT("Content %s was needed before it was preloaded, loading it now"), *Reference.ToString());
+	INC_DWORD_STAT(STAT_ContentBlockingLoads);
+	return StaticLoadObject(AssetClass, nullptr, *Reference.ToString());
+}
+
+void AContentPreloader::GatherManifest()
+{
+	Manifest.Reset();
+	for (const TSubclassOf<AActor>& ManifestClass : ManifestClasses)
+	{
+		const AActor *DefaultActor = ManifestClass ? ManifestClass->GetDefaultObject<AActor>() : NULL;
+		const IPreloadedContent *Content = Cast<IPreloadedContent>(DefaultActor);
+		if (Content)
+		{
+			Content->GetContentAssets(Manifest);
+		}
+	}
+	for (const FStringAssetReference& Asset : ExtraAssets)
+	{
+		Manifest.AddUnique(Asset);
+	}
+	Manifest.RemoveAll([](const FStringAssetReference& Asset) { return !Asset.IsValid(); });
+}
+
+void AContentPreloader::StartPreload()
+{
+	if (bPreloadStarted)
+	{
+		return;
+	}
+	bPreloadStarted = true;
+	GatherManifest();
+	PreloadStartTime = FPlatformTime::Seconds();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("SyncContentLoad")))
+	{
+		// What the constructor hard references used to cost: everything loaded up front on the game thread
+		for (const FStringAssetReference& Asset : Manifest)
+		{
+			Streamable.SynchronousLoad(Asset);
+		}
+		OnPreloadComplete();
+		return;
+	}
+	Streamable.RequestAsyncLoad(Manifest, FStreamableDelegate::CreateUObject(this, &AContentPreloader::OnPreloadComplete));
+}
+
+void AContentPreloader::OnPreloadComplete()
+{
+	bPreloadComplete = true;
+	PreloadTime = FPlatformTime::Seconds() - PreloadStartTime;
+	ReportContent();
+
+	TArray<FSimpleDelegate> Delegates = MoveTemp(PendingDelegates);
+	for (const FSimpleDelegate& Delegate : Delegates)
+	{
+		Delegate.ExecuteIfBound();
+	}
+}
+
+void AContentPreloader::CallWhenLoaded(const FSimpleDelegate& Delegate)
+{
+	if (bPreloadComplete)
+	{
+		Delegate.ExecuteIfBound();
+	}
+	else
+	{
+		PendingDelegates.Add(Delegate);
+	}
+}
+
+bool AContentPreloader::IsPreloadComplete() const
+{
+	return bPreloadComplete;
+}
+
+void AContentPreloader::ReportContent() const
+{
+	const bool bSync = FParse::Param(FCommandLine::Get(), TEXT("SyncContentLoad"));
+	UE_LOG(LogTemp, Log, TEXT("Content preload (%s): %d assets in %.1f ms"), bSync ? TEXT("blocking") : TEXT("async"), Manifest.Num(), PreloadTime * 1000.0);
+
+	SIZE_T TotalBytes = 0;
+	for (const FStringAssetReference& Asset : Manifest)
+	{
+		UObject *Object = Asset.ResolveObject();
+		const SIZE_T Bytes = Object ? Object->GetResourceSizeBytes(EResourceSizeMode::Inclusive) : 0;
+		TotalBytes += Bytes;
+		UE_LOG(LogTemp, Log, TEXT("    %-70s %8.2f MB%s"), *Asset.ToString(), Bytes / (1024.0 * 1024.0), Object ? TEXT("") : TEXT(" (failed to load)"));
+	}
+	UE_LOG(LogTemp, Log, TEXT("    Total %.2f MB"), TotalBytes / (1024.0 * 1024.0));
+	SET_MEMORY_STAT(STAT_PreloadedContentMemory, TotalBytes);
+}
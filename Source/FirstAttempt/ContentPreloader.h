@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "Engine/StreamableManager.h"
+#include "ContentPreloader.generated.h"
+
+/**
+ * Streams in the meshes and anim blueprints the module's actors point at through soft references, so they
+ * load in the background while the level starts instead of all at once when the classes are loaded.
+ * The manifest is gathered from the default objects of ManifestClasses, through IPreloadedContent, plus any
+ * ExtraAssets. Everything it loads stays resident for the rest of the level. Run with -SyncContentLoad to load
+ * the manifest the old blocking way and compare the report.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AContentPreloader : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AContentPreloader();
+
+	/** Starts loading the manifest. Called by the game mode while the level is starting up */
+	void StartPreload();
+
+	/** Calls Delegate once the manifest has loaded, straight away if it already has */
+	void CallWhenLoaded(const FSimpleDelegate& Delegate);
+
+	UFUNCTION(BlueprintPure, Category = "Content")
+	bool IsPreloadComplete() const;
+
+	/** Returns the asset, loading it on the spot if the preload hasn't got to it yet */
+	template<class T>
+	static T* Resolve(const TAssetPtr<T>& Asset)
+	{
+		T *Loaded = Asset.Get();
+		if (Loaded == nullptr && !Asset.IsNull())
+		{
+			Loaded = Cast<T>(LoadBlocking(Asset.ToStringReference(), T::StaticClass()));
+		}
+		return Loaded;
+	}
+
+	/** Returns the class, loading it on the spot if the preload hasn't got to it yet */
+	template<class T>
+	static UClass* Resolve(const TAssetSubclassOf<T>& Class)
+	{
+		UClass *Loaded = Class.Get();
+		if (Loaded == nullptr && !Class.IsNull())
+		{
+			Loaded = Cast<UClass>(LoadBlocking(Class.ToStringReference(), UClass::StaticClass()));
+		}
+		return Loaded;
+	}
+
+	/** Actor classes whose content is preloaded, the ones that implement IPreloadedContent */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Content")
+	TArray<TSubclassOf<AActor>> ManifestClasses;
+
+	/** Other assets to preload */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Content")
+	TArray<FStringAssetReference> ExtraAssets;
+
+private:
+	/** Blocking load used when something needs an asset before the preload has finished */
+	static UObject* LoadBlocking(const FStringAssetReference& Reference, UClass* AssetClass);
+
+	void GatherManifest();
+
+	void OnPreloadComplete();
+
+	/** Logs how long the manifest took and how much memory it holds */
+	void ReportContent() const;
+
+	FStreamableManager Streamable;
+
+	TArray<FStringAssetReference> Manifest;
+
+	TArray<FSimpleDelegate> PendingDelegates;
+
+	double PreloadStartTime;
+
+	double PreloadTime;
+
+	bool bPreloadStarted;
+
+	bool bPreloadComplete;
+};
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "CorpseManager.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Corpse Manager Tick"), STAT_CorpseManagerTick, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ragdolls Simulating"), STAT_RagdollsSimulating, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Corpses"), STAT_Corpses, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Enemies"), STAT_PooledEnemies, STATGROUP_FirstAttempt);
+
+ACorpseManager::ACorpseManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Bodies don't need checking every frame
+	PrimaryActorTick.TickInterval = 0.25f;
+	MaxSimulatingRagdolls = 8;
+	SettledSpeed = 5.f;
+	OutOfViewTime = 2.f;
+	MinCorpseTime = 5.f;
+	CorpseLifeSpan = 30.f;
+	MaxPooledEnemies = 64;
+	NumSimulating = 0;
+}
+
+void ACorpseManager::AddCorpse(AThirdPersonCharacter* Character)
+{
+	if (Character)
+	{
+		FCorpse Corpse;
+		Corpse.Character = Character;
+		Corpse.DeathTime = GetWorld()->GetTimeSeconds();
+		Corpse.bAsleep = false;
+		Corpses.Add(Corpse);
+	}
+}
+
+void ACorpseManager::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_CorpseManagerTick);
+	Super::Tick(DeltaSeconds);
+
+	const float TimeSeconds = GetWorld()->GetTimeSeconds();
+
+	// Count from the newest body back so the oldest ones are the first to be put to sleep when over the cap
+	NumSimulating = 0;
+	for (int32 i = Corpses.Num() - 1; i >= 0; i--)
+	{
+		FCorpse& Corpse = Corpses[i];
+		AThirdPersonCharacter *Character = Corpse.Character.Get();
+		if (Character == NULL || Character->IsPendingKill())
+		{
+			Corpses.RemoveAt(i);
+			continue;
+		}
+
+		const float Age = TimeSeconds - Corpse.DeathTime;
+		const bool bOutOfView = !Character->GetMesh()->WasRecentlyRendered(OutOfViewTime);
+		if (Age >= CorpseLifeSpan || (Age >= MinCorpseTime && bOutOfView))
+		{
+			Corpses.RemoveAt(i);
+			Recycle(Character);
+			continue;
+		}
+
+		if (!Corpse.bAsleep)
+		{
+			const bool bSettled = Age >= 1.f && Character->GetMesh()->GetPhysicsLinearVelocity().Size() < SettledSpeed;
+			if (bSettled || NumSimulating >= MaxSimulatingRagdolls)
+			{
+				PutToSleep(Corpse);
+			}
+			else
+			{
+				NumSimulating++;
+			}
+		}
+	}
+
+	UpdateStats();
+}
+
+void ACorpseManager::PutToSleep(FCorpse& Corpse)
+{
+	AThirdPersonCharacter *Character = Corpse.Character.Get();
+	if (Character)
+	{
+		// Keep physics on so the pose stays where it fell, just stop paying for it
+		USkeletalMeshComponent *Mesh = Character->GetMesh();
+		Mesh->PutAllRigidBodiesToSleep();
+		Mesh->SetComponentTickEnabled(false);
+		Mesh->bPauseAnims = true;
+		Character->GetCharacterMovement()->SetComponentTickEnabled(false);
+		Corpse.bAsleep = true;
+	}
+}
+
+void ACorpseManager::Recycle(AThirdPersonCharacter* Character)
+{
+	if (Pool.Num() >= MaxPooledEnemies)
+	{
+		Character->Destroy();
+		return;
+	}
+	Character->ResetForReuse();
+	Pool.Add(Character);
+	UpdateStats();
+}
+
+AThirdPersonCharacter* ACorpseManager::AcquireEnemy(UClass* CharacterClass, const FVector& Location, const FRotator& Rotation)
+{
+	for (int32 i = Pool.Num() - 1; i >= 0; i--)
+	{
+		AThirdPersonCharacter *Character = Pool[i];
+		if (Character == NULL || Character->IsPendingKill())
+		{
+			Pool.RemoveAtSwap(i);
+			continue;
+		}
+		if (Character->GetClass() == CharacterClass)
+		{
+			Pool.RemoveAtSwap(i);
+			Character->Revive(Location, Rotation);
+			UpdateStats();
+			return Character;
+		}
+	}
+	return NULL;
+}
+
+int32 ACorpseManager::GetNumSimulatingRagdolls() const
+{
+	return NumSimulating;
+}
+
+int32 ACorpseManager::GetNumCorpses() const
+{
+	return Corpses.Num();
+}
+
+int32 ACorpseManager::GetNumPooled() const
+{
+	return Pool.Num();
+}
+
+void ACorpseManager::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_RagdollsSimulating, NumSimulating);
+	SET_DWORD_STAT(STAT_Corpses, Corpses.Num());
+	SET_DWORD_STAT(STAT_PooledEnemies, Pool.Num());
+}
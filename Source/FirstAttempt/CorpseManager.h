@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "CorpseManager.generated.h"
+
+class AThirdPersonCharacter;
+
+/**
+ * Looks after dead enemies. Only a few ragdolls are allowed to simulate at once, settled bodies are put to
+ * sleep and stop animating, and once a body is out of view or has been around long enough it is reset and
+ * kept in a pool that enemy spawners take characters from before spawning new ones.
+ */
+UCLASS()
+class FIRSTATTEMPT_API ACorpseManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	ACorpseManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Starts tracking an enemy that has just turned into a ragdoll */
+	void AddCorpse(AThirdPersonCharacter* Character);
+
+	/** Resets a character and keeps it for AcquireEnemy, or destroys it if the pool is full */
+	void Recycle(AThirdPersonCharacter* Character);
+
+	/** Brings a pooled character of exactly this class back to life at the given transform, or returns null */
+	AThirdPersonCharacter* AcquireEnemy(UClass* CharacterClass, const FVector& Location, const FRotator& Rotation);
+
+	/** Dead bodies still simulating physics */
+	UFUNCTION(BlueprintPure, Category = "Corpses")
+	int32 GetNumSimulatingRagdolls() const;
+
+	/** Dead bodies still in the world, asleep or not */
+	UFUNCTION(BlueprintPure, Category = "Corpses")
+	int32 GetNumCorpses() const;
+
+	/** Reset characters waiting to be spawned again */
+	UFUNCTION(BlueprintPure, Category = "Corpses")
+	int32 GetNumPooled() const;
+
+	/** Ragdolls allowed to simulate at the same time. The oldest ones past this are put to sleep */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Corpses")
+	int32 MaxSimulatingRagdolls;
+
+	/** A ragdoll moving slower than this, in cm/s, counts as settled */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Corpses")
+	float SettledSpeed;
+
+	/** Bodies that nobody has seen for this long, in seconds, are recycled */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Corpses")
+	float OutOfViewTime;
+
+	/** Bodies are never recycled before this many seconds so a kill can be seen */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Corpses")
+	float MinCorpseTime;
+
+	/** Bodies are recycled after this many seconds even if they are in view */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Corpses")
+	float CorpseLifeSpan;
+
+	/** Characters kept for reuse. Anything past this is destroyed instead */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Corpses")
+	int32 MaxPooledEnemies;
+
+private:
+	struct FCorpse
+	{
+		TWeakObjectPtr<AThirdPersonCharacter> Character;
+		float DeathTime;
+		bool bAsleep;
+	};
+
+	/** Stops the ragdoll simulating and animating while keeping its pose */
+	void PutToSleep(FCorpse& Corpse);
+
+	void UpdateStats() const;
+
+	/** Tracked bodies, oldest first */
+	TArray<FCorpse> Corpses;
+
+	UPROPERTY()
+	TArray<AThirdPersonCharacter*> Pool;
+
+	int32 NumSimulating;
+};
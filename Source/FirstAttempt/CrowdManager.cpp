@@ -0,0 +1,349 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "CrowdManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Async/ParallelFor.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptGameModeBase.h"
+#include "CorpseManager.h"
+#include "SpawnScheduler.h"
+#include "FlowFieldManager.h"
+#include "AI/Navigation/NavigationSystem.h"
+#include "ContentPreloader.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Simulate"), STAT_CrowdSimulate, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("Crowd Promote And Demote"), STAT_CrowdPromote, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("Crowd Instances"), STAT_CrowdInstances, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Agents"), STAT_CrowdAgents, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Promoted"), STAT_CrowdPromoted, STATGROUP_FirstAttempt);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Swaps"), STAT_CrowdSwaps, STATGROUP_FirstAttempt);
+
+/** Agents handed to each worker in the simulate pass */
+static const int32 AgentsPerBatch = 256;
+
+ACrowdManager::ACrowdManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	AgentInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("AgentInstances0"));
+	AgentInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	AgentInstances->SetMobility(EComponentMobility::Movable);
+	RootComponent = AgentInstances;
+
+	// Soft reference to the stand in mesh, streamed in by the content preloader and applied in OnConstruction
+	AgentMeshAsset = TAssetPtr<UStaticMesh>(FStringAssetReference(TEXT("/Game/StarterContent/Shapes/Shape_NarrowCapsule.Shape_NarrowCapsule")));
+	PromotionRadius = 4000.f;
+	DemotionRadius = 5000.f;
+	ChaseRadius = 10000.f;
+	WalkSpeed = 300.f;
+	TurnRate = 90.f;
+	MaxSwapsPerFrame = 4;
+	PromotionSearchRadius = 100.f;
+	NumInstances = 0;
+	NumVisibleInstances = 0;
+}
+
+void ACrowdManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void ACrowdManager::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	if (AgentInstances->GetStaticMesh() == NULL)
+	{
+		AgentInstances->SetStaticMesh(AContentPreloader::Resolve(AgentMeshAsset));
+	}
+}
+
+void ACrowdManager::GetContentAssets(TArray<FStringAssetReference>& OutAssets) const
+{
+	OutAssets.AddUnique(AgentMeshAsset.ToStringReference());
+}
+
+void ACrowdManager::AddAgent(TSubclassOf<AThirdPersonCharacter> CharacterClass, const FVector& Location, float Heading)
+{
+	if (CharacterClass == NULL)
+	{
+		return;
+	}
+	int32 ClassIndex = AgentClasses.Find(CharacterClass);
+	if (ClassIndex == INDEX_NONE)
+	{
+		if (!ensureMsgf(AgentClasses.Num() <= MAX_uint8, TEXT("Crowd only supports %d enemy classes"), MAX_uint8 + 1))
+		{
+			return;
+		}
+		ClassIndex = AgentClasses.Add(CharacterClass);
+	}
+	FAgent Agent;
+	Agent.Location = Location;
+	Agent.Heading = Heading;
+	Agent.State = EAgentState::Wandering;
+	Agent.ClassIndex = (uint8)ClassIndex;
+	Agents.Add(Agent);
+}
+
+void ACrowdManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	PlayerLocations.Reset();
+	if (GameplayContext.IsValid())
+	{
+		for (const APawn *PlayerPawn : GameplayContext->GetPlayerPawns())
+		{
+			PlayerLocations.Add(PlayerPawn->GetActorLocation());
+		}
+	}
+	if (PlayerLocations.Num() > 0)
+	{
+		SimulateAgents(DeltaSeconds, PlayerLocations);
+		PromoteAndDemote(PlayerLocations);
+	}
+	UpdateInstances();
+	UpdateStats();
+}
+
+void ACrowdManager::SimulateAgents(float DeltaSeconds, const TArray<FVector>& InPlayerLocations)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_CrowdSimulate);
+
+	const float PromotionRadiusSq = FMath::Square(PromotionRadius);
+	const float ChaseRadiusSq = FMath::Square(ChaseRadius);
+	const float MaxTurn = TurnRate * DeltaSeconds;
+	const float Step = WalkSpeed * DeltaSeconds;
+	const float TimeSeconds = GetWorld()->GetTimeSeconds();
+	const int32 NumAgents = Agents.Num();
+	const int32 NumBatches = FMath::DivideAndRoundUp(NumAgents, AgentsPerBatch);
+
+	// The flow field's grid knows which cells the navmesh joins, so agents stay on it without a query each.
+	// Until the grid is ready agents stand still
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	const AFlowFieldManager *FlowField = GameMode ? GameMode->GetFlowFieldManager() : NULL;
+	const bool bCanMove = FlowField && FlowField->IsGridReady();
+
+	// Every agent only writes its own record and the grid is only read, so batches can run on any thread without locking
+	ParallelFor(NumBatches, [&](int32 BatchIndex)
+	{
+		const int32 First = BatchIndex * AgentsPerBatch;
+		const int32 Last = FMath::Min(First + AgentsPerBatch, NumAgents);
+		for (int32 i = First; i < Last; i++)
+		{
+			FAgent& Agent = Agents[i];
+			FVector ToPlayer = InPlayerLocations[0] - Agent.Location;
+			float DistSq = ToPlayer.SizeSquared2D();
+			for (int32 Player = 1; Player < InPlayerLocations.Num(); Player++)
+			{
+				const FVector ToOther = InPlayerLocations[Player] - Agent.Location;
+				if (ToOther.SizeSquared2D() < DistSq)
+				{
+					ToPlayer = ToOther;
+					DistSq = ToOther.SizeSquared2D();
+				}
+			}
+			if (!bCanMove)
+			{
+				Agent.State = (DistSq < PromotionRadiusSq) ? EAgentState::Promote : EAgentState::Wandering;
+				continue;
+			}
+
+			float DesiredHeading;
+			if (DistSq < ChaseRadiusSq)
+			{
+				Agent.State = (DistSq < PromotionRadiusSq) ? EAgentState::Promote : EAgentState::Chasing;
+				// Go round walls the way the flow field says, straight at the player where it has nothing
+				FVector FlowDirection;
+				const FVector Direction = FlowField->GetFlowDirection(Agent.Location, FlowDirection) ? FlowDirection : ToPlayer;
+				DesiredHeading = FMath::RadiansToDegrees(FMath::Atan2(Direction.Y, Direction.X));
+			}
+			else
+			{
+				// Wander without touching the shared random stream: a slow turn that differs per agent
+				Agent.State = EAgentState::Wandering;
+				DesiredHeading = Agent.Heading + FMath::Sin(TimeSeconds * 0.3f + i * 1.7f) * 45.f;
+			}
+
+			const float Turn = FMath::Clamp(FRotator::NormalizeAxis(DesiredHeading - Agent.Heading), -MaxTurn, MaxTurn);
+			Agent.Heading = FRotator::NormalizeAxis(Agent.Heading + Turn);
+			float Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Agent.Heading));
+			const FVector NewLocation(Agent.Location.X + Cos * Step, Agent.Location.Y + Sin * Step, Agent.Location.Z);
+			float HeightChange;
+			if (FlowField->CanStep(Agent.Location, NewLocation, HeightChange))
+			{
+				Agent.Location = NewLocation;
+				Agent.Location.Z += HeightChange;
+			}
+			else
+			{
+				// Walked into a wall or a ledge, turn away and try again next frame
+				Agent.Heading = FRotator::NormalizeAxis(Agent.Heading + 90.f + (i & 1) * 180.f);
+			}
+		}
+	}, NumBatches <= 1);
+}
+
+void ACrowdManager::PromoteAndDemote(const TArray<FVector>& InPlayerLocations)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_CrowdPromote);
+
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	ACorpseManager *CorpseManager = GameMode ? GameMode->GetCorpseManager() : NULL;
+	ASpawnScheduler *SpawnScheduler = GameMode ? GameMode->GetSpawnScheduler() : NULL;
+	int32 SwapsLeft = MaxSwapsPerFrame;
+
+	// Characters that have wandered off go back into the crowd. Dead ones are the corpse manager's problem now
+	const float DemotionRadiusSq = FMath::Square(DemotionRadius);
+	for (int32 i = Promoted.Num() - 1; i >= 0; i--)
+	{
+		AThirdPersonCharacter *Character = Promoted[i].Character.Get();
+		if (Character == NULL || Character->IsPendingKill() || Character->GetIsDead())
+		{
+			Promoted.RemoveAtSwap(i);
+			continue;
+		}
+		if (SwapsLeft == 0)
+		{
+			continue;
+		}
+		const FVector Location = Character->GetActorLocation();
+		bool bFarFromAll = true;
+		for (const FVector& PlayerLocation : InPlayerLocations)
+		{
+			bFarFromAll &= FVector::DistSquared2D(Location, PlayerLocation) > DemotionRadiusSq;
+		}
+		if (bFarFromAll)
+		{
+			FAgent Agent;
+			Agent.Location = Character->GetActorLocation();
+			Agent.Heading = Character->GetActorRotation().Yaw;
+			Agent.State = EAgentState::Wandering;
+			Agent.ClassIndex = Promoted[i].ClassIndex;
+			Agents.Add(Agent);
+			Promoted.RemoveAtSwap(i);
+			if (SpawnScheduler)
+			{
+				SpawnScheduler->RemoveLiveEnemy(Character);
+			}
+			if (CorpseManager)
+			{
+				CorpseManager->Recycle(Character);
+			}
+			else
+			{
+				Character->Destroy();
+			}
+			SwapsLeft--;
+			INC_DWORD_STAT(STAT_CrowdSwaps);
+		}
+	}
+
+	// Promoted characters count against the spawn scheduler's cap like spawned ones. At the cap agents stay
+	// in the crowd, still marked, until a character dies or is demoted
+	for (int32 i = Agents.Num() - 1; i >= 0 && SwapsLeft > 0; i--)
+	{
+		if (Agents[i].State != EAgentState::Promote)
+		{
+			continue;
+		}
+		if (SpawnScheduler && !SpawnScheduler->HasRoomForEnemy())
+		{
+			break;
+		}
+		AThirdPersonCharacter *Character = SpawnCharacter(Agents[i]);
+		if (Character)
+		{
+			if (SpawnScheduler)
+			{
+				SpawnScheduler->AddLiveEnemy(Character);
+			}
+			FPromotedAgent PromotedAgent;
+			PromotedAgent.Character = Character;
+			PromotedAgent.ClassIndex = Agents[i].ClassIndex;
+			Promoted.Add(PromotedAgent);
+			Agents.RemoveAtSwap(i);
+			INC_DWORD_STAT(STAT_CrowdSwaps);
+		}
+		SwapsLeft--;
+	}
+}
+
+AThirdPersonCharacter* ACrowdManager::SpawnCharacter(const FAgent& Agent)
+{
+	UClass *CharacterClass = *AgentClasses[Agent.ClassIndex];
+	const FRotator Rotation(0.f, Agent.Heading, 0.f);
+
+	// Stand the character on the navmesh under the agent. Agents only move on the flow field grid, which is
+	// coarser than the navmesh, so an agent off it stays an agent rather than be dropped in a wall
+	UNavigationSystem *NavSys = UNavigationSystem::GetCurrent<UNavigationSystem>(GetWorld());
+	const ACharacter *CharacterDefaults = GetDefault<ACharacter>(CharacterClass);
+	const float HalfHeight = CharacterDefaults->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	FNavLocation NavLocation;
+	if (NavSys == NULL || !NavSys->ProjectPointToNavigation(Agent.Location, NavLocation, FVector(PromotionSearchRadius, PromotionSearchRadius, HalfHeight * 2.f)))
+	{
+		return NULL;
+	}
+	const FVector Location = NavLocation.Location + FVector(0.f, 0.f, HalfHeight);
+
+	// Reuse a recycled body if there is one before paying for a fresh character
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	ACorpseManager *CorpseManager = GameMode ? GameMode->GetCorpseManager() : NULL;
+	AThirdPersonCharacter *Character = CorpseManager ? CorpseManager->AcquireEnemy(CharacterClass, Location, Rotation) : NULL;
+	if (Character == NULL)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		Character = GetWorld()->SpawnActor<AThirdPersonCharacter>(CharacterClass, Location, Rotation, SpawnParams);
+	}
+	return Character;
+}
+
+void ACrowdManager::UpdateInstances()
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_CrowdInstances);
+
+	const int32 NumAgents = Agents.Num();
+	while (NumInstances < NumAgents)
+	{
+		AgentInstances->AddInstanceWorldSpace(FTransform(FRotator(0.f, Agents[NumInstances].Heading, 0.f), Agents[NumInstances].Location));
+		NumInstances++;
+	}
+
+	// Update everything without dirtying the render state, then dirty it once at the end
+	for (int32 i = 0; i < NumAgents; i++)
+	{
+		AgentInstances->UpdateInstanceTransform(i, FTransform(FRotator(0.f, Agents[i].Heading, 0.f), Agents[i].Location), true, false, true);
+	}
+	for (int32 i = NumAgents; i < NumVisibleInstances; i++)
+	{
+		AgentInstances->UpdateInstanceTransform(i, FTransform(FRotator::ZeroRotator, GetActorLocation(), FVector::ZeroVector), true, false, true);
+	}
+	if (NumAgents > 0 || NumVisibleInstances > 0)
+	{
+		AgentInstances->MarkRenderStateDirty();
+	}
+	NumVisibleInstances = NumAgents;
+}
+
+int32 ACrowdManager::GetNumAgents() const
+{
+	return Agents.Num();
+}
+
+int32 ACrowdManager::GetNumPromoted() const
+{
+	return Promoted.Num();
+}
+
+void ACrowdManager::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_CrowdAgents, Agents.Num());
+	SET_DWORD_STAT(STAT_CrowdPromoted, Promoted.Num());
+}
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "GameplayContext.h"
+#include "PreloadedContent.h"
+#include "CrowdManager.generated.h"
+
+class AThirdPersonCharacter;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Lets far away enemies exist as plain records instead of characters, so spawners can fill a level with
+ * thousands of them. Agents are moved in one parallel pass and drawn through one instanced mesh. They only
+ * step between cells of the flow field grid that the navmesh joins and chase along the flow field. An agent
+ * that comes within PromotionRadius of any player is swapped for a real AThirdPersonCharacter, taken from
+ * the corpse manager's pool when there is one, and a character that gets beyond DemotionRadius of all of them is
+ * turned back into an agent. Promoted characters count against the spawn scheduler's MaxLiveEnemies, and no
+ * agent is promoted while it is reached.
+ */
+UCLASS()
+class FIRSTATTEMPT_API ACrowdManager : public AInfo, public IPreloadedContent
+{
+	GENERATED_BODY()
+
+	/** Draws every agent */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Crowd, meta = (AllowPrivateAccess = "true"))
+	UInstancedStaticMeshComponent* AgentInstances;
+
+public:
+	ACrowdManager();
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+	/** Adds the soft referenced content the crowd needs to the list, for the content preloader */
+	virtual void GetContentAssets(TArray<FStringAssetReference>& OutAssets) const override;
+
+	/** Adds an agent that turns into a CharacterClass when the player gets close */
+	void AddAgent(TSubclassOf<AThirdPersonCharacter> CharacterClass, const FVector& Location, float Heading);
+
+	/** Agents that are only records */
+	UFUNCTION(BlueprintPure, Category = "Crowd")
+	int32 GetNumAgents() const;
+
+	/** Agents currently standing in as characters */
+	UFUNCTION(BlueprintPure, Category = "Crowd")
+	int32 GetNumPromoted() const;
+
+	/** Agents closer than this to the player become characters */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Crowd")
+	float PromotionRadius;
+
+	/** Characters further than this from the player go back to being agents. Kept above PromotionRadius so they don't flicker */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Crowd")
+	float DemotionRadius;
+
+	/** Agents closer than this walk towards the player, the rest wander */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Crowd")
+	float ChaseRadius;
+
+	/** How fast agents walk, in cm/s */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Crowd")
+	float WalkSpeed;
+
+	/** How fast agents turn, in degrees per second */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Crowd")
+	float TurnRate;
+
+	/** Promotions and demotions allowed per frame, since each one moves a character */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Crowd")
+	int32 MaxSwapsPerFrame;
+
+	/** How far sideways a promoted agent's character may be moved to stand on the navmesh */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Crowd")
+	float PromotionSearchRadius;
+
+	/** Stand in mesh every agent is drawn with */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Crowd")
+	TAssetPtr<UStaticMesh> AgentMeshAsset;
+
+	/** Returns AgentInstances subobject **/
+	FORCEINLINE UInstancedStaticMeshComponent* GetAgentInstances() const { return AgentInstances; }
+
+private:
+	enum class EAgentState : uint8
+	{
+		Wandering,
+		Chasing,
+		/** Close enough to a player to become a character */
+		Promote
+	};
+
+	/** Everything about an agent. Kept small so the whole crowd stays in a few cache lines per hundred */
+	struct FAgent
+	{
+		FVector Location;
+		/** Yaw in degrees */
+		float Heading;
+		EAgentState State;
+		/** Index into AgentClasses */
+		uint8 ClassIndex;
+	};
+
+	struct FPromotedAgent
+	{
+		TWeakObjectPtr<AThirdPersonCharacter> Character;
+		uint8 ClassIndex;
+	};
+
+	/** Moves every agent, chasing the nearest of PlayerLocations, and marks the ones close enough to promote */
+	void SimulateAgents(float DeltaSeconds, const TArray<FVector>& InPlayerLocations);
+
+	/** Swaps marked agents for characters and characters far from every player for agents, within MaxSwapsPerFrame */
+	void PromoteAndDemote(const TArray<FVector>& InPlayerLocations);
+
+	/** Character for a promoted agent, standing on the navmesh under it. Null if there is no navmesh nearby */
+	AThirdPersonCharacter* SpawnCharacter(const FAgent& Agent);
+
+	/** Pushes agent transforms to the instanced mesh, hiding instances that are not in use */
+	void UpdateInstances();
+
+	void UpdateStats() const;
+
+	FGameplayContextHandle GameplayContext;
+
+	/** Scratch list of where every player is this tick */
+	TArray<FVector> PlayerLocations;
+
+	TArray<FAgent> Agents;
+
+	TArray<FPromotedAgent> Promoted;
+
+	/** Character classes agents turn into. Agents store an index so the records stay small */
+	UPROPERTY()
+	TArray<TSubclassOf<AThirdPersonCharacter>> AgentClasses;
+
+	/** Instances added to the mesh component so far. Unused ones are scaled to zero rather than removed */
+	int32 NumInstances;
+
+	/** Instances that were showing an agent after the last update */
+	int32 NumVisibleInstances;
+};
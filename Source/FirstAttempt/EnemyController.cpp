@@ -1,25 +1,301 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#include "FirstAttempt.h"
-#include "EnemyController.h"
-#include "ThirdPersonCharacter.h"
-/*
-void AEnemyController::BeginPlay()
-{
-	SetFocus(GetPawn());
-	MoveToActor(GetPawn());
-	//Possess()
-	UE_LOG(LogTemp, Warning, TEXT("Ok"));
-}
-
-void AEnemyController::OnPossess(APawn *PossessedPawn)
-{
-	UE_LOG(LogTemp, Warning, TEXT("Fuck"));
-	AThirdPersonCharacter *PossessedCharacter = Cast<AThirdPersonCharacter>(PossessedPawn);
-	if (PossessedCharacter)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("Shit"));
-		PossessedCharacter->StartShooting();
-	}
-}
-*/
\ No newline at end of file
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "EnemyController.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptGameModeBase.h"
+#include "PathRequestManager.h"
+#include "FlowFieldManager.h"
+#include "PerceptionManager.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Think"), STAT_EnemyThink, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("Enemy Pursuit"), STAT_EnemyPursuit, STATGROUP_FirstAttempt);
+
+AEnemyController::AEnemyController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	ThinkInterval = 0.25f;
+	EngageRange = 1500.f;
+	LoseTargetTime = 5.f;
+	RepathDistance = 300.f;
+	FleeRange = 1500.f;
+	FleeSpeed = 1000.f;
+	FleeDistance = 2000.f;
+	FleeTime = 2.f;
+	PursuitMode = EEnemyPursuitMode::FlowField;
+	FlowFieldLookAhead = 8;
+	State = EEnemyState::Idle;
+	Target = NULL;
+	LastSeenTime = -BIG_NUMBER;
+	LastSeenLocation = FVector::ZeroVector;
+	PathGoal = FVector(BIG_NUMBER);
+	bPathPending = false;
+	StateStartTime = 0.f;
+}
+
+void AEnemyController::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AEnemyController::Possess(APawn* InPawn)
+{
+	Super::Possess(InPawn);
+	SetActorTickInterval(ThinkInterval);
+	ResetState();
+}
+
+void AEnemyController::UnPossess()
+{
+	ResetState();
+	Super::UnPossess();
+}
+
+void AEnemyController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	if (GetPawn())
+	{
+		Think();
+	}
+}
+
+void AEnemyController::OnSeeTarget(APawn* InTarget)
+{
+	Target = InTarget;
+	LastSeenTime = GetWorld()->GetTimeSeconds();
+	LastSeenLocation = InTarget->GetActorLocation();
+}
+
+EEnemyState AEnemyController::GetState() const
+{
+	return State;
+}
+
+bool AEnemyController::IsThreatened() const
+{
+	const FVector ToPawn = GetPawn()->GetActorLocation() - Target->GetActorLocation();
+	return ToPawn.SizeSquared() <= FMath::Square(FleeRange) && FVector::DotProduct(Target->GetVelocity(), ToPawn.GetSafeNormal()) >= FleeSpeed;
+}
+
+void AEnemyController::Think()
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_EnemyThink);
+	const AThirdPersonCharacter *Character = Cast<AThirdPersonCharacter>(GetPawn());
+	const float TimeSeconds = GetWorld()->GetTimeSeconds();
+	if ((Character && Character->GetIsDead()) || Target == NULL || Target->IsPendingKill() || TimeSeconds - LastSeenTime > LoseTargetTime)
+	{
+		SetState(EEnemyState::Idle);
+		return;
+	}
+
+	// Keep running until far enough or out of time, rather than turning back the moment the target slows
+	if (State == EEnemyState::Flee && TimeSeconds - StateStartTime < FleeTime)
+	{
+		return;
+	}
+	if (IsThreatened())
+	{
+		SetState(EEnemyState::Flee);
+		return;
+	}
+	// Only stand and shoot at what was seen since the last sighting was due, otherwise go and look
+	const bool bInSight = TimeSeconds - LastSeenTime <= GetSightWindow();
+	const float DistanceSq = FVector::DistSquared(GetPawn()->GetActorLocation(), LastSeenLocation);
+	if (bInSight && DistanceSq <= FMath::Square(EngageRange))
+	{
+		SetState(EEnemyState::Engage);
+		return;
+	}
+	SetState(EEnemyState::Pursue);
+	UpdatePursuit();
+}
+
+float AEnemyController::GetSightWindow() const
+{
+	// Sightings come at most every SensingInterval and are seen at the next think. The trace budget can hold one
+	// back a few frames more, so an engaged enemy gets another think before it gives up and goes looking
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APerceptionManager *PerceptionManager = GameMode ? GameMode->GetPerceptionManager() : NULL;
+	const float SensingInterval = PerceptionManager ? PerceptionManager->SensingInterval : 0.f;
+	const float Hysteresis = State == EEnemyState::Engage ? ThinkInterval : 0.f;
+	return SensingInterval + ThinkInterval + Hysteresis;
+}
+
+void AEnemyController::UpdatePursuit()
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_EnemyPursuit);
+	switch (PursuitMode)
+	{
+	case EEnemyPursuitMode::FlowField:
+		if (FollowFlowField())
+		{
+			break;
+		}
+		// Not the player, or off the field, fall back to a path
+	case EEnemyPursuitMode::PathQueue:
+		if (!bPathPending && FVector::DistSquared(PathGoal, LastSeenLocation) > FMath::Square(RepathDistance))
+		{
+			RequestPathTo(LastSeenLocation);
+		}
+		break;
+	case EEnemyPursuitMode::MoveToActor:
+		MoveToActor(Target);
+		break;
+	}
+}
+
+bool AEnemyController::FollowFlowField()
+{
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	AFlowFieldManager *FlowField = GameMode ? GameMode->GetFlowFieldManager() : NULL;
+	if (FlowField == NULL || !FlowField->IsFieldTarget(Target))
+	{
+		return false;
+	}
+	const FVector Start = GetPawn()->GetNavAgentLocation();
+	FlowPoints.Reset();
+	FlowPoints.Add(Start);
+	if (!FlowField->TracePath(Start, Target, FlowFieldLookAhead, FlowPoints))
+	{
+		return false;
+	}
+	// In the target's cell the field has nothing more to say, go straight for it
+	if (FlowPoints.Num() < 2)
+	{
+		FlowPoints.Add(LastSeenLocation);
+	}
+	CancelPathRequest();
+	PathGoal = FVector(BIG_NUMBER);
+	MoveAlong(FlowPoints);
+	return true;
+}
+
+void AEnemyController::SetState(EEnemyState NewState)
+{
+	if (NewState == State)
+	{
+		return;
+	}
+	State = NewState;
+	StateStartTime = GetWorld()->GetTimeSeconds();
+
+	switch (NewState)
+	{
+	case EEnemyState::Idle:
+		Target = NULL;
+		ClearFocus(EAIFocusPriority::Gameplay);
+		StopMovement();
+		SetShooting(false);
+		break;
+	case EEnemyState::Pursue:
+		SetFocus(Target);
+		SetShooting(false);
+		PathGoal = FVector(BIG_NUMBER);
+		break;
+	case EEnemyState::Engage:
+		SetFocus(Target);
+		StopMovement();
+		SetShooting(true);
+		break;
+	case EEnemyState::Flee:
+	{
+		ClearFocus(EAIFocusPriority::Gameplay);
+		SetShooting(false);
+		// Sideways off the target's line is quicker out of the way than straight ahead of it
+		const FVector Heading = Target->GetVelocity().GetSafeNormal2D();
+		const FVector Side = FVector::CrossProduct(Heading, FVector::UpVector);
+		const FVector ToPawn = GetPawn()->GetActorLocation() - Target->GetActorLocation();
+		const float Sign = FVector::DotProduct(ToPawn, Side) >= 0.f ? 1.f : -1.f;
+		RequestPathTo(GetPawn()->GetActorLocation() + Side * Sign * FleeDistance);
+		break;
+	}
+	}
+}
+
+void AEnemyController::RequestPathTo(const FVector& Goal)
+{
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APathRequestManager *PathRequestManager = GameMode ? GameMode->GetPathRequestManager() : NULL;
+	PathGoal = Goal;
+	if (PathRequestManager)
+	{
+		bPathPending = true;
+		PathRequestManager->RequestPath(this, Goal);
+	}
+	else
+	{
+		MoveToLocation(Goal);
+	}
+}
+
+void AEnemyController::OnPathReady(const TArray<FVector>& Points, bool bSuccess)
+{
+	bPathPending = false;
+	if ((State != EEnemyState::Pursue && State != EEnemyState::Flee) || GetPawn() == NULL)
+	{
+		return;
+	}
+	if (!bSuccess || Points.Num() < 2)
+	{
+		// Try again next think
+		PathGoal = FVector(BIG_NUMBER);
+		return;
+	}
+
+	// The path may have been found for another enemy nearby, so start it where this one stands
+	TArray<FVector> PathPoints = Points;
+	PathPoints[0] = GetPawn()->GetNavAgentLocation();
+	MoveAlong(PathPoints);
+}
+
+void AEnemyController::MoveAlong(const TArray<FVector>& Points)
+{
+	FNavPathSharedPtr Path = MakeShareable(new FNavigationPath(Points, NULL));
+	FAIMoveRequest MoveRequest(Points.Last());
+	MoveRequest.SetAcceptanceRadius(50.f);
+	RequestMove(MoveRequest, Path);
+}
+
+void AEnemyController::CancelPathRequest()
+{
+	if (!bPathPending)
+	{
+		return;
+	}
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APathRequestManager *PathRequestManager = GameMode ? GameMode->GetPathRequestManager() : NULL;
+	if (PathRequestManager)
+	{
+		PathRequestManager->CancelRequest(this);
+	}
+	bPathPending = false;
+}
+
+void AEnemyController::ResetState()
+{
+	CancelPathRequest();
+	PathGoal = FVector(BIG_NUMBER);
+	LastSeenTime = -BIG_NUMBER;
+	SetState(EEnemyState::Idle);
+	StopMovement();
+}
+
+void AEnemyController::SetShooting(bool bShooting)
+{
+	AThirdPersonCharacter *Character = Cast<AThirdPersonCharacter>(GetPawn());
+	if (Character == NULL)
+	{
+		return;
+	}
+	if (bShooting)
+	{
+		Character->StartShooting();
+	}
+	else
+	{
+		Character->StopShooting();
+	}
+}
@@ -1,22 +1,156 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "AIController.h"
-#include "EnemyController.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class FIRSTATTEMPT_API AEnemyController : public AAIController
-{
-	GENERATED_BODY()
-
-public:
-
-protected:
-	//virtual void BeginPlay();
-	
-	//virtual void OnPossess(APawn *PossesedPawn);
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "AIController.h"
+#include "GameplayContext.h"
+#include "EnemyController.generated.h"
+
+UENUM(BlueprintType)
+enum class EEnemyState : uint8
+{
+	/** No target, standing still */
+	Idle,
+	/** Walking to where the target was last seen */
+	Pursue,
+	/** Close enough to the target to stand and shoot */
+	Engage,
+	/** Getting out of the way of a target coming at it fast */
+	Flee
+};
+
+UENUM(BlueprintType)
+enum class EEnemyPursuitMode : uint8
+{
+	/** Follow the shared flow field to the player, asking the path request manager for anything else */
+	FlowField,
+	/** Ask the path request manager for every path */
+	PathQueue,
+	/** MoveToActor every think, each enemy finding its own path. Kept to compare the others against */
+	MoveToActor
+};
+
+/**
+ * Runs an enemy as a small state machine, thinking a few times a second rather than every frame. The perception
+ * manager tells it when its character sees the player through OnSeeTarget. Paths go through the path request
+ * manager instead of MoveToActor, so they are found off the game thread, a few per frame, and shared between
+ * enemies chasing the same target. Enemies chasing the player follow the flow field instead when there is one.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AEnemyController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AEnemyController();
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	virtual void Possess(APawn* InPawn) override;
+
+	virtual void UnPossess() override;
+
+	/** Called through the character while it can see Target */
+	void OnSeeTarget(APawn* Target);
+
+	/** Called by the path request manager with the path asked for last, empty if none was found */
+	void OnPathReady(const TArray<FVector>& Points, bool bSuccess);
+
+	/** Forgets the target and stops, for when the character is parked for reuse */
+	void ResetState();
+
+	UFUNCTION(BlueprintPure, Category = "AI")
+	EEnemyState GetState() const;
+
+	/** How often the state machine runs, in seconds */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float ThinkInterval;
+
+	/** Stops and shoots once the target is this close and in sight */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float EngageRange;
+
+	/** Gives up on a target that hasn't been seen for this long, in seconds */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float LoseTargetTime;
+
+	/** Asks for a new path once the target has moved this far from the end of the current one */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float RepathDistance;
+
+	/** Runs from a target within this distance coming towards it faster than FleeSpeed */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float FleeRange;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float FleeSpeed;
+
+	/** How far to run, and for how long at least, in seconds */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float FleeDistance;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float FleeTime;
+
+	/** How Pursue finds its way */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	EEnemyPursuitMode PursuitMode;
+
+	/** Cells of the flow field walked ahead each think */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	int32 FlowFieldLookAhead;
+
+private:
+	/** Picks the state for this think and updates the path */
+	void Think();
+
+	/** Leaves the current state and enters NewState */
+	void SetState(EEnemyState NewState);
+
+	/** Whether the target is close and coming at the pawn fast */
+	bool IsThreatened() const;
+
+	/** How long after the last sighting the target still counts as in sight */
+	float GetSightWindow() const;
+
+	/** Keeps the pawn heading for the target while pursuing */
+	void UpdatePursuit();
+
+	/** Moves along the flow field for the next few cells. Returns false if the field doesn't cover the pawn or target */
+	bool FollowFlowField();
+
+	/** Asks the path request manager for a path to Goal, unless one is already on its way */
+	void RequestPathTo(const FVector& Goal);
+
+	/** Drops any path being waited for */
+	void CancelPathRequest();
+
+	/** Follows Points from where the pawn stands */
+	void MoveAlong(const TArray<FVector>& Points);
+
+	void SetShooting(bool bShooting);
+
+	/** Where the game mode and its managers are reached from, bound once instead of a cast per call */
+	FGameplayContextHandle GameplayContext;
+
+	EEnemyState State;
+
+	UPROPERTY()
+	APawn *Target;
+
+	float LastSeenTime;
+
+	FVector LastSeenLocation;
+
+	/** Where the path being followed or waited for ends */
+	FVector PathGoal;
+
+	bool bPathPending;
+
+	float StateStartTime;
+
+	/** Scratch list of flow field points */
+	TArray<FVector> FlowPoints;
+};
@@ -0,0 +1,298 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "EnemySignificanceManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Tick"), STAT_SignificanceTick, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies LOD High"), STAT_EnemiesLODHigh, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies LOD Medium"), STAT_EnemiesLODMedium, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies LOD Low"), STAT_EnemiesLODLow, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies LOD Dormant"), STAT_EnemiesLODDormant, STATGROUP_FirstAttempt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Enemy Ticks Skipped Per Second"), STAT_EnemyTicksSkipped, STATGROUP_FirstAttempt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Enemy Tick Cost (ms)"), STAT_EnemyTickCostMs, STATGROUP_FirstAttempt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Enemy Tick Ms Saved Per Frame"), STAT_EnemyTickMsSaved, STATGROUP_FirstAttempt);
+
+AEnemySignificanceManager::AEnemySignificanceManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickInterval = 0.1f;
+	MaxSignificanceDistance = 10000.f;
+	VisibleBonus = 0.5f;
+	ShootingBonus = 0.5f;
+	SkippedTicksPerSecond = 0.f;
+	MeasuredTickCycles = 0;
+	NumMeasuredTicks = 0;
+	AverageTickMs = 0.f;
+	EstimatedSavedMsPerFrame = 0.f;
+	bSignificanceEnabled = true;
+	FMemory::Memzero(BucketCounts);
+
+	LODSettings.SetNum(4);
+	LODSettings[(int32)EEnemySignificance::High].MinScore = 1.f;
+	LODSettings[(int32)EEnemySignificance::High].NonRenderedAnimUpdateRate = 2;
+
+	LODSettings[(int32)EEnemySignificance::Medium].MinScore = 0.6f;
+	LODSettings[(int32)EEnemySignificance::Medium].TickInterval = 1.f / 30.f;
+	LODSettings[(int32)EEnemySignificance::Medium].AnimTickInterval = 1.f / 30.f;
+	LODSettings[(int32)EEnemySignificance::Medium].NetUpdateFrequency = 15.f;
+
+	LODSettings[(int32)EEnemySignificance::Low].MinScore = 0.25f;
+	LODSettings[(int32)EEnemySignificance::Low].TickInterval = 0.1f;
+	LODSettings[(int32)EEnemySignificance::Low].AnimTickInterval = 0.2f;
+	LODSettings[(int32)EEnemySignificance::Low].NonRenderedAnimUpdateRate = 8;
+	LODSettings[(int32)EEnemySignificance::Low].NetUpdateFrequency = 5.f;
+
+	LODSettings[(int32)EEnemySignificance::Dormant].MinScore = 0.f;
+	LODSettings[(int32)EEnemySignificance::Dormant].TickInterval = 0.5f;
+	LODSettings[(int32)EEnemySignificance::Dormant].AnimTickInterval = 1.f;
+	LODSettings[(int32)EEnemySignificance::Dormant].NonRenderedAnimUpdateRate = 16;
+	LODSettings[(int32)EEnemySignificance::Dormant].bKinematicPathFollow = true;
+	LODSettings[(int32)EEnemySignificance::Dormant].NetUpdateFrequency = 2.f;
+}
+
+void AEnemySignificanceManager::AddCharacter(AThirdPersonCharacter* Character)
+{
+	if (Character == NULL)
+	{
+		return;
+	}
+	RemoveCharacter(Character);
+	Character->GetMesh()->bEnableUpdateRateOptimizations = true;
+	FManagedCharacter Managed;
+	Managed.Character = Character;
+	Managed.Bucket = EEnemySignificance::High;
+	Characters.Add(Managed);
+}
+
+void AEnemySignificanceManager::RemoveCharacter(AThirdPersonCharacter* Character)
+{
+	for (int32 i = Characters.Num() - 1; i >= 0; i--)
+	{
+		if (Characters[i].Character == Character)
+		{
+			if (Characters[i].Bucket != EEnemySignificance::High)
+			{
+				ApplyBucket(Character, EEnemySignificance::High);
+			}
+			Characters.RemoveAtSwap(i);
+		}
+	}
+}
+
+void AEnemySignificanceManager::SetSignificanceEnabled(bool bEnabled)
+{
+	bSignificanceEnabled = bEnabled;
+	if (!bSignificanceEnabled)
+	{
+		for (FManagedCharacter& Managed : Characters)
+		{
+			AThirdPersonCharacter *Character = Managed.Character.Get();
+			if (Character && Managed.Bucket != EEnemySignificance::High)
+			{
+				ApplyBucket(Character, EEnemySignificance::High);
+				Managed.Bucket = EEnemySignificance::High;
+			}
+		}
+		UpdateStats();
+	}
+}
+
+float AEnemySignificanceManager::ScoreCharacter(const AThirdPersonCharacter* Character, const TArray<FVector>& InPlayerLocations) const
+{
+	const FVector Location = Character->GetActorLocation();
+	float DistanceSq = MAX_flt;
+	for (const FVector& PlayerLocation : InPlayerLocations)
+	{
+		DistanceSq = FMath::Min(DistanceSq, FVector::DistSquared(Location, PlayerLocation));
+	}
+	float Score = 1.f - FMath::Clamp(FMath::Sqrt(DistanceSq) / MaxSignificanceDistance, 0.f, 1.f);
+	if (Character->GetMesh()->WasRecentlyRendered(0.2f))
+	{
+		Score += VisibleBonus;
+	}
+	if (Character->GetIsShooting())
+	{
+		Score += ShootingBonus;
+	}
+	return Score;
+}
+
+EEnemySignificance AEnemySignificanceManager::GetBucketForScore(float Score) const
+{
+	for (int32 i = 0; i < LODSettings.Num(); i++)
+	{
+		if (Score >= LODSettings[i].MinScore)
+		{
+			return (EEnemySignificance)i;
+		}
+	}
+	return EEnemySignificance::Dormant;
+}
+
+void AEnemySignificanceManager::ApplyBucket(AThirdPersonCharacter* Character, EEnemySignificance Bucket) const
+{
+	if (!LODSettings.IsValidIndex((int32)Bucket))
+	{
+		return;
+	}
+	const FEnemyLODSettings& Settings = LODSettings[(int32)Bucket];
+	USkeletalMeshComponent *Mesh = Character->GetMesh();
+	UCharacterMovementComponent *Movement = Character->GetCharacterMovement();
+
+	Character->SetActorTickInterval(Settings.TickInterval);
+	Character->NetUpdateFrequency = Settings.NetUpdateFrequency;
+	Movement->SetComponentTickInterval(Settings.TickInterval);
+	Movement->SetComponentTickEnabled(!Settings.bKinematicPathFollow);
+
+	Mesh->SetComponentTickInterval(Settings.AnimTickInterval);
+	Mesh->MeshComponentUpdateFlag = (Bucket == EEnemySignificance::High) ? EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones : EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered;
+	if (Mesh->AnimUpdateRateParams)
+	{
+		Mesh->AnimUpdateRateParams->BaseNonRenderedUpdateRate = Settings.NonRenderedAnimUpdateRate;
+	}
+}
+
+void AEnemySignificanceManager::FollowPathKinematic(AThirdPersonCharacter* Character, float DeltaSeconds) const
+{
+	AAIController *AIController = Cast<AAIController>(Character->GetController());
+	UPathFollowingComponent *PathFollowing = AIController ? AIController->GetPathFollowingComponent() : NULL;
+	if (PathFollowing == NULL || !PathFollowing->GetPath().IsValid())
+	{
+		return;
+	}
+	const TArray<FNavPathPoint>& PathPoints = PathFollowing->GetPath()->GetPathPoints();
+	const int32 NextIndex = PathFollowing->GetNextPathIndex();
+	if (!PathPoints.IsValidIndex(NextIndex))
+	{
+		return;
+	}
+
+	// Path points sit on the navmesh, keep the capsule standing on top of them
+	const FVector Location = Character->GetActorLocation();
+	FVector Target = PathPoints[NextIndex].Location;
+	Target.Z += Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const FVector ToTarget = Target - Location;
+	const float Step = Character->GetCharacterMovement()->MaxWalkSpeed * DeltaSeconds;
+	const FVector NewLocation = (ToTarget.Size() <= Step) ? Target : Location + ToTarget.GetSafeNormal() * Step;
+	const FRotator NewRotation(0.f, ToTarget.Rotation().Yaw, 0.f);
+	Character->SetActorLocationAndRotation(NewLocation, NewRotation, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
+void AEnemySignificanceManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AEnemySignificanceManager::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_SignificanceTick);
+	Super::Tick(DeltaSeconds);
+
+	if (!bSignificanceEnabled)
+	{
+		return;
+	}
+
+	PlayerLocations.Reset();
+	if (GameplayContext.IsValid())
+	{
+		for (const APawn *PlayerPawn : GameplayContext->GetPlayerPawns())
+		{
+			PlayerLocations.Add(PlayerPawn->GetActorLocation());
+		}
+	}
+	else if (const APawn *PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0))
+	{
+		PlayerLocations.Add(PlayerPawn->GetActorLocation());
+	}
+
+	for (int32 i = Characters.Num() - 1; i >= 0; i--)
+	{
+		FManagedCharacter& Managed = Characters[i];
+		AThirdPersonCharacter *Character = Managed.Character.Get();
+		if (Character == NULL)
+		{
+			Characters.RemoveAtSwap(i);
+			continue;
+		}
+
+		// Whoever a player is driving, and bodies the corpse manager looks after, always run at full rate
+		EEnemySignificance Bucket = EEnemySignificance::High;
+		if (PlayerLocations.Num() > 0 && !Character->IsPlayerControlled() && !Character->GetIsDead())
+		{
+			Bucket = GetBucketForScore(ScoreCharacter(Character, PlayerLocations));
+		}
+		if (Bucket != Managed.Bucket)
+		{
+			ApplyBucket(Character, Bucket);
+			Managed.Bucket = Bucket;
+		}
+		if (LODSettings.IsValidIndex((int32)Bucket) && LODSettings[(int32)Bucket].bKinematicPathFollow)
+		{
+			FollowPathKinematic(Character, DeltaSeconds);
+		}
+	}
+
+	UpdateStats();
+}
+
+void AEnemySignificanceManager::UpdateStats()
+{
+	FMemory::Memzero(BucketCounts);
+	SkippedTicksPerSecond = 0.f;
+
+	// Three ticking things per character: the actor, its movement and its mesh
+	const float DeltaSeconds = FMath::Max(GetWorld()->GetDeltaSeconds(), SMALL_NUMBER);
+	const float FullRate = 3.f / DeltaSeconds;
+	for (const FManagedCharacter& Managed : Characters)
+	{
+		BucketCounts[(int32)Managed.Bucket]++;
+		if (LODSettings.IsValidIndex((int32)Managed.Bucket) && Managed.Bucket != EEnemySignificance::High)
+		{
+			const FEnemyLODSettings& Settings = LODSettings[(int32)Managed.Bucket];
+			const float ActorRate = (Settings.TickInterval > 0.f) ? 1.f / Settings.TickInterval : FullRate / 3.f;
+			const float MovementRate = Settings.bKinematicPathFollow ? 0.f : ActorRate;
+			const float AnimRate = (Settings.AnimTickInterval > 0.f) ? 1.f / Settings.AnimTickInterval : FullRate / 3.f;
+			SkippedTicksPerSecond += FMath::Max(0.f, FullRate - ActorRate - MovementRate - AnimRate);
+		}
+	}
+
+	// Smoothed so a single slow tick, or an update with no ticks in it, doesn't swing the estimate
+	if (NumMeasuredTicks > 0)
+	{
+		const float SampleMs = (float)(MeasuredTickCycles * FPlatformTime::GetSecondsPerCycle() * 1000.0) / NumMeasuredTicks;
+		AverageTickMs = (AverageTickMs > 0.f) ? FMath::Lerp(AverageTickMs, SampleMs, 0.2f) : SampleMs;
+		MeasuredTickCycles = 0;
+		NumMeasuredTicks = 0;
+	}
+	EstimatedSavedMsPerFrame = SkippedTicksPerSecond * DeltaSeconds * AverageTickMs;
+
+	SET_DWORD_STAT(STAT_EnemiesLODHigh, BucketCounts[(int32)EEnemySignificance::High]);
+	SET_DWORD_STAT(STAT_EnemiesLODMedium, BucketCounts[(int32)EEnemySignificance::Medium]);
+	SET_DWORD_STAT(STAT_EnemiesLODLow, BucketCounts[(int32)EEnemySignificance::Low]);
+	SET_DWORD_STAT(STAT_EnemiesLODDormant, BucketCounts[(int32)EEnemySignificance::Dormant]);
+	SET_FLOAT_STAT(STAT_EnemyTicksSkipped, SkippedTicksPerSecond);
+	SET_FLOAT_STAT(STAT_EnemyTickCostMs, AverageTickMs);
+	SET_FLOAT_STAT(STAT_EnemyTickMsSaved, EstimatedSavedMsPerFrame);
+}
+
+int32 AEnemySignificanceManager::GetNumInBucket(EEnemySignificance Bucket) const
+{
+	return BucketCounts[(int32)Bucket];
+}
+
+float AEnemySignificanceManager::GetSkippedTicksPerSecond() const
+{
+	return SkippedTicksPerSecond;
+}
+
+float AEnemySignificanceManager::GetEstimatedSavedMsPerFrame() const
+{
+	return EstimatedSavedMsPerFrame;
+}
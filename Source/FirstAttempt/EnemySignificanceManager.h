@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "GameplayContext.h"
+#include "EnemySignificanceManager.generated.h"
+
+class AThirdPersonCharacter;
+
+/** How much update work an enemy gets, from full rate down to a cheap kinematic path follow */
+UENUM(BlueprintType)
+enum class EEnemySignificance : uint8
+{
+	High,
+	Medium,
+	Low,
+	Dormant
+};
+
+/** Update rates used for one significance bucket */
+USTRUCT(BlueprintType)
+struct FEnemyLODSettings
+{
+	GENERATED_BODY()
+
+	/** Lowest score, from 0 to 2, that puts an enemy in this bucket */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance")
+	float MinScore;
+
+	/** Tick interval for the actor and its movement component, 0 is every frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance")
+	float TickInterval;
+
+	/** Tick interval for the skeletal mesh, which drives the anim blueprint */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance")
+	float AnimTickInterval;
+
+	/** Update rate used by the mesh's update rate optimisations when it is not rendered */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance")
+	int32 NonRenderedAnimUpdateRate;
+
+	/** Skip character movement entirely and slide the actor along its current path instead */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance")
+	bool bKinematicPathFollow;
+
+	/** How often a server sends the enemy to clients, per second. Keeps bandwidth for the enemies that matter */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Significance")
+	float NetUpdateFrequency;
+
+	FEnemyLODSettings()
+		: MinScore(0.f)
+		, TickInterval(0.f)
+		, AnimTickInterval(0.f)
+		, NonRenderedAnimUpdateRate(4)
+		, bKinematicPathFollow(false)
+		, NetUpdateFrequency(30.f)
+	{
+	}
+};
+
+/**
+ * Scores every enemy by distance to the nearest player, whether it was rendered recently and whether it is
+ * shooting, and turns down tick rates, animation updates and movement simulation for the ones that matter least.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AEnemySignificanceManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AEnemySignificanceManager();
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	void AddCharacter(AThirdPersonCharacter* Character);
+
+	/** Stops managing the character, putting it back to full update rates */
+	void RemoveCharacter(AThirdPersonCharacter* Character);
+
+	/** Turns the manager on or off. Turning it off puts every character back to full update rates */
+	UFUNCTION(BlueprintCallable, Category = "Significance")
+	void SetSignificanceEnabled(bool bEnabled);
+
+	/** Number of characters in the given bucket after the last update */
+	UFUNCTION(BlueprintPure, Category = "Significance")
+	int32 GetNumInBucket(EEnemySignificance Bucket) const;
+
+	/** Actor, movement and mesh ticks per second skipped compared to running everyone at full rate */
+	UFUNCTION(BlueprintPure, Category = "Significance")
+	float GetSkippedTicksPerSecond() const;
+
+	/**
+	 * Game thread time the skipped ticks would have cost each frame, in milliseconds: skipped ticks times the
+	 * measured average enemy actor tick. Movement and mesh ticks are costed the same as the actor's
+	 */
+	UFUNCTION(BlueprintPure, Category = "Significance")
+	float GetEstimatedSavedMsPerFrame() const;
+
+	/** Called by managed characters with how long one of their actor ticks took */
+	FORCEINLINE void AddMeasuredTick(uint32 Cycles)
+	{
+		MeasuredTickCycles += Cycles;
+		NumMeasuredTicks++;
+	}
+
+	/** Settings for each bucket, indexed by EEnemySignificance */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Significance")
+	TArray<FEnemyLODSettings> LODSettings;
+
+	/** Distance at which the distance part of the score reaches zero */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Significance")
+	float MaxSignificanceDistance;
+
+	/** Score added when the enemy was rendered recently */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Significance")
+	float VisibleBonus;
+
+	/** Score added when the enemy is shooting */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Significance")
+	float ShootingBonus;
+
+private:
+	/** Where the player pawns are cached between possessions */
+	FGameplayContextHandle GameplayContext;
+
+	/** Scratch list of where every player is this tick */
+	TArray<FVector> PlayerLocations;
+
+	struct FManagedCharacter
+	{
+		TWeakObjectPtr<AThirdPersonCharacter> Character;
+		EEnemySignificance Bucket;
+	};
+
+	/** Scored against the nearest of PlayerLocations */
+	float ScoreCharacter(const AThirdPersonCharacter* Character, const TArray<FVector>& InPlayerLocations) const;
+
+	EEnemySignificance GetBucketForScore(float Score) const;
+
+	void ApplyBucket(AThirdPersonCharacter* Character, EEnemySignificance Bucket) const;
+
+	/** Moves a character that has movement switched off towards the next point on its path */
+	void FollowPathKinematic(AThirdPersonCharacter* Character, float DeltaSeconds) const;
+
+	void UpdateStats();
+
+	TArray<FManagedCharacter> Characters;
+
+	int32 BucketCounts[4];
+
+	float SkippedTicksPerSecond;
+
+	/** Actor tick time reported by characters since the last UpdateStats */
+	uint64 MeasuredTickCycles;
+	int32 NumMeasuredTicks;
+
+	/** Average actor tick cost, smoothed over updates */
+	float AverageTickMs;
+
+	float EstimatedSavedMsPerFrame;
+
+	bool bSignificanceEnabled;
+};
@@ -1,73 +1,302 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#include "FirstAttempt.h"
-#include "EnemySpawner.h"
-#include "Kismet/KismetMathLibrary.h"
-#include "ThirdPersonCharacter.h"
-
-
-// Sets default values
-AEnemySpawner::AEnemySpawner()
-{
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
-	WhereToSpawn = CreateDefaultSubobject<UBoxComponent>(TEXT("WhereToSpawn"));
-	RootComponent = WhereToSpawn;
-	MinSpawnDelay = 2.5;
-	MaxSpawnDelay = 5;
-}
-
-// Called when the game starts or when spawned
-void AEnemySpawner::BeginPlay()
-{
-	Super::BeginPlay();
-}
-
-// Called every frame
-void AEnemySpawner::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
-FVector AEnemySpawner::GetRandomPointInVolume()
-{
-	FVector SpawnOrigin = WhereToSpawn->Bounds.Origin;
-	FVector SpawnExtent = WhereToSpawn->Bounds.BoxExtent;
-	return UKismetMathLibrary::RandomPointInBoundingBox(SpawnOrigin, SpawnExtent);
-}
-
-void AEnemySpawner::SpawnPickup()
-{
-	if (WhatToSpawn != NULL)
-	{
-		UWorld *World = GetWorld();
-		if (World)
-		{
-			FActorSpawnParameters SpawnParams;
-			SpawnParams.Owner = this;
-			SpawnParams.Instigator = Instigator;
-			FVector SpawnLocation = GetRandomPointInVolume();
-			
-			FRotator SpawnRotation;
-			SpawnRotation.Yaw = FMath::FRand() * 360;
-			SpawnRotation.Roll = 0;
-			SpawnRotation.Pitch = 0;
-			const AThirdPersonCharacter *SpawnedPickup = World->SpawnActor<AThirdPersonCharacter>(WhatToSpawn, SpawnLocation, SpawnRotation, SpawnParams);
-			SpawnDelay = FMath::FRandRange(MinSpawnDelay, MaxSpawnDelay);
-			GetWorldTimerManager().SetTimer(SpawnTimer, this, &AEnemySpawner::SpawnPickup, SpawnDelay, false);
-		}
-	}
-}
-
-void AEnemySpawner::SetSpawningActive(bool bShouldSpawn)
-{
-	if (bShouldSpawn)
-	{
-		SpawnDelay = FMath::FRandRange(MinSpawnDelay, MaxSpawnDelay);
-		GetWorldTimerManager().SetTimer(SpawnTimer, this, &AEnemySpawner::SpawnPickup, SpawnDelay, false);
-	}
-	else
-	{
-		GetWorldTimerManager().ClearTimer(SpawnTimer);
-	}
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "EnemySpawner.h"
+#include "AI/Navigation/NavigationSystem.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptGameModeBase.h"
+#include "SpawnScheduler.h"
+#include "CorpseManager.h"
+#include "CrowdManager.h"
+#include "ReplayRecorder.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("SpawnPickup"), STAT_SpawnPickup, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("Spawn Point Refresh"), STAT_SpawnPointRefresh, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Points Rejected"), STAT_SpawnPointsRejected, STATGROUP_FirstAttempt);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawns Without Cached Point"), STAT_SpawnsWithoutCachedPoint, STATGROUP_FirstAttempt);
+
+/** How far above and below a sampled point to look for navmesh */
+static const float NavProjectionHeight = 500.f;
+
+
+// Sets default values
+AEnemySpawner::AEnemySpawner()
+{
+	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = false;
+	WhereToSpawn = CreateDefaultSubobject<UBoxComponent>(TEXT("WhereToSpawn"));
+	RootComponent = WhereToSpawn;
+	MinSpawnDelay = 2.5;
+	MaxSpawnDelay = 5;
+	bSpawnAsCrowd = false;
+	CrowdSize = 1000;
+	WaveSize = 1;
+	SpawnPointCacheSize = 32;
+	MaxSamplesPerSpawnPoint = 4;
+	SpawnPointOrigin = FVector::ZeroVector;
+	SpawnPointScale = 1.f;
+	RefreshCursor = 0;
+	NumRejectedSpawnPoints = 0;
+}
+
+void AEnemySpawner::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+// Called when the game starts or when spawned
+void AEnemySpawner::BeginPlay()
+{
+	Super::BeginPlay();
+	if (bSpawnAsCrowd && WhatToSpawn != NULL)
+	{
+		AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+		ACrowdManager *CrowdManager = GameMode ? GameMode->GetCrowdManager() : NULL;
+		if (CrowdManager)
+		{
+			// Place the whole crowd in two bulk draws
+			FFastRandomStream& Random = GameMode->GetRandomStream(ERandomStream::Crowd);
+			TArray<FVector> Locations;
+			Random.GetPointsInBox(WhereToSpawn->Bounds.Origin, WhereToSpawn->Bounds.BoxExtent, CrowdSize, Locations);
+			TArray<float> Headings;
+			Headings.SetNumUninitialized(CrowdSize);
+			Random.GetFractions(Headings.GetData(), CrowdSize, 0.f, 360.f);
+			for (int32 i = 0; i < CrowdSize; i++)
+			{
+				CrowdManager->AddAgent(WhatToSpawn, Locations[i], Headings[i]);
+			}
+		}
+	}
+	else
+	{
+		BuildSpawnPointCache();
+	}
+}
+
+// Called every frame
+void AEnemySpawner::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+}
+
+FFastRandomStream& AEnemySpawner::GetSpawnRandomStream() const
+{
+	// Spawners in a world run by another game mode still need somewhere to draw from, seeded the same every run
+	static FRandomStreams FallbackStreams;
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	return GameMode ? GameMode->GetRandomStream(ERandomStream::Spawning) : FallbackStreams.Get(ERandomStream::Spawning);
+}
+
+FVector AEnemySpawner::GetRandomPointInVolume()
+{
+	return GetSpawnRandomStream().GetPointInBox(WhereToSpawn->Bounds.Origin, WhereToSpawn->Bounds.BoxExtent);
+}
+
+float AEnemySpawner::GetRandomSpawnDelay() const
+{
+	return GetSpawnRandomStream().FRandRange(MinSpawnDelay, MaxSpawnDelay);
+}
+
+void AEnemySpawner::GetSpawnCapsule(float& OutRadius, float& OutHalfHeight) const
+{
+	const ACharacter *DefaultCharacter = WhatToSpawn ? WhatToSpawn->GetDefaultObject<ACharacter>() : NULL;
+	OutRadius = DefaultCharacter ? DefaultCharacter->GetCapsuleComponent()->GetScaledCapsuleRadius() : 42.f;
+	OutHalfHeight = DefaultCharacter ? DefaultCharacter->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() : 96.f;
+}
+
+bool AEnemySpawner::IsSpawnPointClear(const FVector& Location) const
+{
+	float Radius, HalfHeight;
+	GetSpawnCapsule(Radius, HalfHeight);
+	FCollisionQueryParams Params(FName(TEXT("SpawnPointCheck")), false, this);
+	return !GetWorld()->OverlapBlockingTestByChannel(Location, FQuat::Identity, ECC_Pawn, FCollisionShape::MakeCapsule(Radius, HalfHeight), Params);
+}
+
+bool AEnemySpawner::SampleSpawnPoint(FVector& OutLocation)
+{
+	UNavigationSystem *NavSys = UNavigationSystem::GetCurrent<UNavigationSystem>(GetWorld());
+	if (NavSys == NULL)
+	{
+		return false;
+	}
+	// Snap a random point to the navmesh below or above it, so the enemy starts on the ground it will walk on
+	const FVector Point = GetRandomPointInVolume();
+	FNavLocation NavLocation;
+	float Radius, HalfHeight;
+	GetSpawnCapsule(Radius, HalfHeight);
+	if (NavSys->ProjectPointToNavigation(Point, NavLocation, FVector(Radius, Radius, WhereToSpawn->Bounds.BoxExtent.Z + NavProjectionHeight)))
+	{
+		const FVector Location = NavLocation.Location + FVector(0.f, 0.f, HalfHeight + 2.f);
+		if (IsSpawnPointClear(Location))
+		{
+			OutLocation = Location;
+			return true;
+		}
+	}
+	NumRejectedSpawnPoints++;
+	INC_DWORD_STAT(STAT_SpawnPointsRejected);
+	return false;
+}
+
+AEnemySpawner::FCachedSpawnPoint AEnemySpawner::PackSpawnPoint(const FVector& Location) const
+{
+	const FVector Offset = (Location - SpawnPointOrigin) / SpawnPointScale;
+	FCachedSpawnPoint Point;
+	Point.X = (int16)FMath::Clamp(FMath::RoundToInt(Offset.X), (int32)MIN_int16, (int32)MAX_int16);
+	Point.Y = (int16)FMath::Clamp(FMath::RoundToInt(Offset.Y), (int32)MIN_int16, (int32)MAX_int16);
+	Point.Z = (int16)FMath::Clamp(FMath::RoundToInt(Offset.Z), (int32)MIN_int16, (int32)MAX_int16);
+	return Point;
+}
+
+FVector AEnemySpawner::UnpackSpawnPoint(const FCachedSpawnPoint& Point) const
+{
+	return SpawnPointOrigin + FVector(Point.X, Point.Y, Point.Z) * SpawnPointScale;
+}
+
+void AEnemySpawner::BuildSpawnPointCache()
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_SpawnPointRefresh);
+	SpawnPoints.Reset();
+	RefreshCursor = 0;
+	SpawnPointOrigin = WhereToSpawn->Bounds.Origin;
+	// Leave room for the navmesh projection going past the top or bottom of the volume
+	const FVector Reach = WhereToSpawn->Bounds.BoxExtent + FVector(0.f, 0.f, NavProjectionHeight + 200.f);
+	SpawnPointScale = FMath::Max(1.f, Reach.GetMax() / MAX_int16);
+
+	SpawnPoints.Reserve(SpawnPointCacheSize);
+	const int32 MaxSamples = SpawnPointCacheSize * MaxSamplesPerSpawnPoint;
+	FVector Location;
+	for (int32 i = 0; i < MaxSamples && SpawnPoints.Num() < SpawnPointCacheSize; i++)
+	{
+		if (SampleSpawnPoint(Location))
+		{
+			SpawnPoints.Add(PackSpawnPoint(Location));
+		}
+	}
+	if (SpawnPoints.Num() < SpawnPointCacheSize)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s found %d of %d spawn points, check it overlaps the navmesh"), *GetName(), SpawnPoints.Num(), SpawnPointCacheSize);
+	}
+}
+
+void AEnemySpawner::RefreshSpawnPoints(int32 NumChecks)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_SpawnPointRefresh);
+	FVector Location;
+	// Replace points used by earlier waves first
+	while (NumChecks > 0 && SpawnPoints.Num() < SpawnPointCacheSize)
+	{
+		if (SampleSpawnPoint(Location))
+		{
+			SpawnPoints.Add(PackSpawnPoint(Location));
+		}
+		NumChecks--;
+	}
+	// Then recheck the oldest points, something may have moved onto them since
+	while (NumChecks > 0 && SpawnPoints.Num() > 0)
+	{
+		RefreshCursor = RefreshCursor % SpawnPoints.Num();
+		if (IsSpawnPointClear(UnpackSpawnPoint(SpawnPoints[RefreshCursor])))
+		{
+			RefreshCursor++;
+		}
+		else
+		{
+			NumRejectedSpawnPoints++;
+			INC_DWORD_STAT(STAT_SpawnPointsRejected);
+			SpawnPoints.RemoveAtSwap(RefreshCursor);
+		}
+		NumChecks--;
+	}
+}
+
+void AEnemySpawner::SpawnWave(int32 NumEnemies, TArray<AThirdPersonCharacter*>& OutSpawned)
+{
+	// Draw the whole wave's points at once, each from a random slot so waves don't all start in one corner
+	TArray<FVector> Locations;
+	Locations.Reserve(NumEnemies);
+	FFastRandomStream& Random = GetSpawnRandomStream();
+	while (Locations.Num() < NumEnemies && SpawnPoints.Num() > 0)
+	{
+		const int32 Index = Random.RandRange(0, SpawnPoints.Num() - 1);
+		Locations.Add(UnpackSpawnPoint(SpawnPoints[Index]));
+		SpawnPoints.RemoveAtSwap(Index);
+	}
+	// Out of checked points, fall back to unchecked ones rather than skipping the wave
+	while (Locations.Num() < NumEnemies)
+	{
+		Locations.Add(GetRandomPointInVolume());
+		INC_DWORD_STAT(STAT_SpawnsWithoutCachedPoint);
+	}
+
+	for (const FVector& Location : Locations)
+	{
+		AThirdPersonCharacter *Enemy = SpawnPickup(Location);
+		if (Enemy)
+		{
+			OutSpawned.Add(Enemy);
+		}
+	}
+}
+
+int32 AEnemySpawner::GetNumCachedSpawnPoints() const
+{
+	return SpawnPoints.Num();
+}
+
+int32 AEnemySpawner::GetNumRejectedSpawnPoints() const
+{
+	return NumRejectedSpawnPoints;
+}
+
+AThirdPersonCharacter* AEnemySpawner::SpawnPickup(const FVector& SpawnLocation)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_SpawnPickup);
+	AThirdPersonCharacter *SpawnedPickup = NULL;
+	if (WhatToSpawn != NULL)
+	{
+		UWorld *World = GetWorld();
+		if (World)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.Owner = this;
+			SpawnParams.Instigator = Instigator;
+
+			FRotator SpawnRotation;
+			SpawnRotation.Yaw = GetSpawnRandomStream().FRandRange(0.f, 360.f);
+			SpawnRotation.Roll = 0;
+			SpawnRotation.Pitch = 0;
+
+			// Reuse a recycled body if there is one before paying for a fresh character
+			AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+			ACorpseManager *CorpseManager = GameMode ? GameMode->GetCorpseManager() : NULL;
+			if (CorpseManager)
+			{
+				SpawnedPickup = CorpseManager->AcquireEnemy(*WhatToSpawn, SpawnLocation, SpawnRotation);
+			}
+			if (SpawnedPickup == NULL)
+			{
+				SpawnedPickup = World->SpawnActor<AThirdPersonCharacter>(WhatToSpawn, SpawnLocation, SpawnRotation, SpawnParams);
+			}
+			AReplayRecorder *ReplayRecorder = GameMode ? GameMode->GetReplayRecorder() : NULL;
+			if (ReplayRecorder && SpawnedPickup)
+			{
+				ReplayRecorder->RecordSpawn(this, SpawnLocation, SpawnRotation.Yaw);
+			}
+		}
+	}
+	return SpawnedPickup;
+}
+
+void AEnemySpawner::SetSpawningActive(bool bShouldSpawn)
+{
+	// Spawn timing is owned by the scheduler so spawns from every spawner can share one budget
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	ASpawnScheduler *SpawnScheduler = GameMode ? GameMode->GetSpawnScheduler() : NULL;
+	if (SpawnScheduler)
+	{
+		SpawnScheduler->SetSpawnerActive(this, bShouldSpawn);
+	}
+}
\ No newline at end of file
@@ -1,50 +1,141 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "GameFramework/Actor.h"
-#include "EnemySpawner.generated.h"
-
-UCLASS()
-class FIRSTATTEMPT_API AEnemySpawner : public AActor
-{
-	GENERATED_BODY()
-	
-public:	
-	// Sets default values for this actor's properties
-	AEnemySpawner();
-
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawning")
-	TSubclassOf<class AThirdPersonCharacter> WhatToSpawn;
-
-	FTimerHandle SpawnTimer;
-	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Spawning")
-	float MinSpawnDelay;
-	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Spawning")
-	float MaxSpawnDelay;
-
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	UFUNCTION(BlueprintCallable, Category = "Spawning")
-	void SetSpawningActive(bool bShouldSpawn);
-
-	FORCEINLINE class UBoxComponent* GetWhereToSpawn() const { return WhereToSpawn; }
-
-	UFUNCTION(BlueprintPure, Category = "Spawning")
-	FVector GetRandomPointInVolume();
-
-private:
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Spawning", meta = (AllowPrivateAccess = "true"))
-	class UBoxComponent *WhereToSpawn;
-
-	void SpawnPickup();
-
-	float SpawnDelay;
-
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "GameplayContext.h"
+#include "EnemySpawner.generated.h"
+
+UCLASS()
+class FIRSTATTEMPT_API AEnemySpawner : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	AEnemySpawner();
+
+protected:
+	virtual void PostInitializeComponents() override;
+
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawning")
+	TSubclassOf<class AThirdPersonCharacter> WhatToSpawn;
+
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Spawning")
+	float MinSpawnDelay;
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Spawning")
+	float MaxSpawnDelay;
+
+	/** Fill the volume with CrowdSize crowd agents at the start instead of spawning characters over time */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawning")
+	bool bSpawnAsCrowd;
+
+	/** Agents added when spawning as a crowd */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawning", meta = (EditCondition = "bSpawnAsCrowd", ClampMin = "0"))
+	int32 CrowdSize;
+
+	/** Enemies spawned together each time the spawn delay runs out */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawning", meta = (ClampMin = "1"))
+	int32 WaveSize;
+
+	/** Spawn points checked against the navmesh and collision ahead of time and kept ready */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning", meta = (ClampMin = "0"))
+	int32 SpawnPointCacheSize;
+
+	/** Random points tried for each cache slot when filling the cache, before giving up on the slot */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spawning", meta = (ClampMin = "1"))
+	int32 MaxSamplesPerSpawnPoint;
+
+public:	
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	UFUNCTION(BlueprintCallable, Category = "Spawning")
+	void SetSpawningActive(bool bShouldSpawn);
+
+	FORCEINLINE class UBoxComponent* GetWhereToSpawn() const { return WhereToSpawn; }
+
+	/** Whether this spawner hands its enemies to the crowd manager rather than the spawn scheduler */
+	FORCEINLINE bool IsCrowdSpawner() const { return bSpawnAsCrowd; }
+
+	FORCEINLINE void SetWhatToSpawn(TSubclassOf<class AThirdPersonCharacter> NewWhatToSpawn) { WhatToSpawn = NewWhatToSpawn; }
+
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	FVector GetRandomPointInVolume();
+
+	/** Picks how long to wait before the next spawn, between MinSpawnDelay and MaxSpawnDelay */
+	float GetRandomSpawnDelay() const;
+
+	/**
+	 * Tries to spawn NumEnemies enemies at cached spawn points, drawing every point in one go, and adds the ones
+	 * that spawned to OutSpawned. Called by the spawn scheduler when it is this spawner's turn.
+	 */
+	void SpawnWave(int32 NumEnemies, TArray<class AThirdPersonCharacter*>& OutSpawned);
+
+	/** Fills the spawn point cache from scratch. Done at BeginPlay, call again after moving or resizing the volume or changing WhatToSpawn */
+	void BuildSpawnPointCache();
+
+	/** Tops the cache back up and rechecks cached points, trying at most NumChecks points. Called by the spawn scheduler every few frames */
+	void RefreshSpawnPoints(int32 NumChecks);
+
+	FORCEINLINE int32 GetWaveSize() const { return WaveSize; }
+
+	/** Validated spawn points ready to use */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	int32 GetNumCachedSpawnPoints() const;
+
+	/** Points that failed the navmesh or collision check, when sampled or when rechecked */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	int32 GetNumRejectedSpawnPoints() const;
+
+private:
+	/** A spawn point as an offset from SpawnPointOrigin in SpawnPointScale units, half the size of an FVector */
+	struct FCachedSpawnPoint
+	{
+		int16 X;
+		int16 Y;
+		int16 Z;
+	};
+
+	/** The game mode's spawning stream, so spawn timing and placement repeat for a given seed */
+	class FFastRandomStream& GetSpawnRandomStream() const;
+
+	/** Spawns one enemy at Location, from the corpse manager's pool if it has one */
+	class AThirdPersonCharacter* SpawnPickup(const FVector& Location);
+
+	/** Tries one random point in the volume. On success OutLocation is where the enemy's capsule would go */
+	bool SampleSpawnPoint(FVector& OutLocation);
+
+	/** Whether an enemy's capsule fits at Location */
+	bool IsSpawnPointClear(const FVector& Location) const;
+
+	FCachedSpawnPoint PackSpawnPoint(const FVector& Location) const;
+
+	FVector UnpackSpawnPoint(const FCachedSpawnPoint& Point) const;
+
+	/** Capsule size of WhatToSpawn, which spawn points are checked with */
+	void GetSpawnCapsule(float& OutRadius, float& OutHalfHeight) const;
+
+	/** Where the game mode and its managers are reached from, bound once instead of a cast per call */
+	FGameplayContextHandle GameplayContext;
+
+	TArray<FCachedSpawnPoint> SpawnPoints;
+
+	/** Middle of the volume when the cache was built */
+	FVector SpawnPointOrigin;
+
+	/** Centimetres per packed unit, so the whole volume fits in 16 bits */
+	float SpawnPointScale;
+
+	/** Next cached point RefreshSpawnPoints rechecks */
+	int32 RefreshCursor;
+
+	int32 NumRejectedSpawnPoints;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Spawning", meta = (AllowPrivateAccess = "true"))
+	class UBoxComponent *WhereToSpawn;
+
+};
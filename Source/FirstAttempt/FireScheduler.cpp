@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "FireScheduler.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fire Scheduler Tick"), STAT_FireSchedulerTick, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Scheduled Shooters"), STAT_ScheduledShooters, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Shots Per Frame"), STAT_ShotsPerFrame, STATGROUP_FirstAttempt);
+
+/** Shortest gap between shots, so a zero fire rate can't keep a shooter at the top of the heap forever */
+static const float MinFireInterval = 0.01f;
+
+AFireScheduler::AFireScheduler()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	NextTicket = 0;
+	NumShooters = 0;
+	ShotsLastFrame = 0;
+}
+
+int32 AFireScheduler::StartFiring(AThirdPersonCharacter* Shooter, float FirstShotTime)
+{
+	FScheduledShot Shot;
+	Shot.FireTime = FirstShotTime;
+	// Tickets only need to differ from whatever the shooter held before, so wrapping round is fine
+	Shot.Ticket = NextTicket;
+	NextTicket = (NextTicket == MAX_int32) ? 0 : NextTicket + 1;
+	Shot.Shooter = Shooter;
+	Schedule.HeapPush(Shot);
+	NumShooters++;
+	SET_DWORD_STAT(STAT_ScheduledShooters, NumShooters);
+	return Shot.Ticket;
+}
+
+void AFireScheduler::StopFiring(int32 Ticket)
+{
+	// The shooter has already dropped the ticket, so its entry is skipped when it comes up
+	if (Ticket != INDEX_NONE)
+	{
+		NumShooters--;
+		SET_DWORD_STAT(STAT_ScheduledShooters, NumShooters);
+	}
+}
+
+void AFireScheduler::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_FireSchedulerTick);
+	Super::Tick(DeltaSeconds);
+
+	const float TimeSeconds = GetWorld()->GetTimeSeconds();
+	ShotsLastFrame = 0;
+	while (Schedule.Num() > 0 && Schedule.HeapTop().FireTime <= TimeSeconds)
+	{
+		FScheduledShot Shot;
+		Schedule.HeapPop(Shot, false);
+
+		AThirdPersonCharacter *Shooter = Shot.Shooter.Get();
+		if (Shooter == NULL || Shooter->GetFireTicket() != Shot.Ticket)
+		{
+			continue;
+		}
+
+		Shooter->FireShot();
+		ShotsLastFrame++;
+
+		// The shot may have stopped the shooter, otherwise go again after its fire rate. A long hitch skips
+		// the missed shots rather than firing them all at once
+		if (Shooter->GetFireTicket() == Shot.Ticket)
+		{
+			const float Interval = FMath::Max(Shooter->FireRate, MinFireInterval);
+			Shot.FireTime += Interval;
+			if (Shot.FireTime <= TimeSeconds)
+			{
+				Shot.FireTime = TimeSeconds + Interval;
+			}
+			Schedule.HeapPush(Shot);
+		}
+	}
+	SET_DWORD_STAT(STAT_ShotsPerFrame, ShotsLastFrame);
+	SET_DWORD_STAT(STAT_ScheduledShooters, NumShooters);
+}
+
+void AFireScheduler::GetShootersDueBy(float Time, TArray<AThirdPersonCharacter*>& OutShooters) const
+{
+	// Walk the heap from the top, a shot later than Time means everything under it is later too
+	TArray<int32, TInlineAllocator<64>> Stack;
+	if (Schedule.Num() > 0)
+	{
+		Stack.Add(0);
+	}
+	while (Stack.Num() > 0)
+	{
+		const int32 Index = Stack.Pop(false);
+		const FScheduledShot& Shot = Schedule[Index];
+		if (Shot.FireTime > Time)
+		{
+			continue;
+		}
+		AThirdPersonCharacter *Shooter = Shot.Shooter.Get();
+		if (Shooter && Shooter->GetFireTicket() == Shot.Ticket)
+		{
+			OutShooters.Add(Shooter);
+		}
+		for (int32 Child = Index * 2 + 1; Child <= Index * 2 + 2 && Child < Schedule.Num(); Child++)
+		{
+			Stack.Add(Child);
+		}
+	}
+}
+
+int32 AFireScheduler::GetNumShooters() const
+{
+	return NumShooters;
+}
+
+int32 AFireScheduler::GetShotsLastFrame() const
+{
+	return ShotsLastFrame;
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "FireScheduler.generated.h"
+
+class AThirdPersonCharacter;
+
+/**
+ * Fires every shooting character's weapon from one place instead of a looping timer per character.
+ * Shooters wait in a min-heap keyed on when their next shot is due, and every shot due in a frame is fired
+ * in one pass. Starting is a heap push. Stopping only invalidates the shooter's ticket, and the stale entry
+ * is dropped when it reaches the top of the heap.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AFireScheduler : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AFireScheduler();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Schedules Shooter's first shot at FirstShotTime, world time in seconds. Returns the ticket to stop it with */
+	int32 StartFiring(AThirdPersonCharacter* Shooter, float FirstShotTime);
+
+	/** Stops the shooter holding Ticket from firing again */
+	void StopFiring(int32 Ticket);
+
+	/** Adds every shooter with a shot due at or before Time, world time in seconds, to OutShooters */
+	void GetShootersDueBy(float Time, TArray<AThirdPersonCharacter*>& OutShooters) const;
+
+	/** Shooters currently scheduled */
+	UFUNCTION(BlueprintPure, Category = "Shooting")
+	int32 GetNumShooters() const;
+
+	/** Shots fired during the last tick */
+	UFUNCTION(BlueprintPure, Category = "Shooting")
+	int32 GetShotsLastFrame() const;
+
+private:
+	struct FScheduledShot
+	{
+		float FireTime;
+		int32 Ticket;
+		TWeakObjectPtr<AThirdPersonCharacter> Shooter;
+
+		/** Orders the heap so the earliest shot is on top */
+		bool operator<(const FScheduledShot& Other) const
+		{
+			return FireTime < Other.FireTime;
+		}
+	};
+
+	/** Shots waiting to fire, as a heap */
+	TArray<FScheduledShot> Schedule;
+
+	int32 NextTicket;
+
+	int32 NumShooters;
+
+	int32 ShotsLastFrame;
+};
@@ -1,5 +1,5 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#include "FirstAttempt.h"
-
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FirstAttempt, "FirstAttempt" );
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FirstAttempt, "FirstAttempt" );
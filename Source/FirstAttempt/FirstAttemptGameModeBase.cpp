@@ -1,65 +1,292 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#include "FirstAttempt.h"
-#include "FirstAttemptGameModeBase.h"
-#include "Kismet/GameplayStatics.h"
-#include "Blueprint/UserWidget.h"
-#include "ThirdPersonCharacter.h"
-#include "EnemySpawner.h"
-
-AFirstAttemptGameModeBase::AFirstAttemptGameModeBase()
-{
-	DefaultPawnClass = AThirdPersonCharacter::StaticClass();
-}
-
-void AFirstAttemptGameModeBase::BeginPlay()
-{
-	TArray<AActor*> FoundActors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AEnemySpawner::StaticClass(), FoundActors);
-	for (int i = 0; i < FoundActors.Num(); i++)
-	{
-		AEnemySpawner *EnemyMaker = Cast<AEnemySpawner>(FoundActors[i]);
-		if (EnemyMaker)
-		{
-			//SpawnVolumeActors.AddUnique(SpawnVolumeActor);
-			EnemyMaker->SetSpawningActive(true);
-		}
-	}
-	if (HUDWidgetClass != nullptr)
-	{
-		CurrentWidget = CreateWidget<UUserWidget>(GetWorld(), HUDWidgetClass);
-		if (CurrentWidget != nullptr)
-		{
-			CurrentWidget->AddToViewport();
-		}
-	}
-	GetWorldTimerManager().SetTimer(TimeElapsedHandle, this, &AFirstAttemptGameModeBase::IncrementTimeElapsed, 1, true);
-}
-
-int AFirstAttemptGameModeBase::GetKillCount()
-{
-	return KillCount;
-}
-
-FString AFirstAttemptGameModeBase::GetTimeElapsed()
-{
-	FString TimeElapsedString;
-	int Minutes = TimeElapsed / 60;
-	if (Minutes < 10)
-	{
-		TimeElapsedString.Append(TEXT("0"));
-	}
-	TimeElapsedString.Append(FString::FromInt(Minutes) + TEXT(":"));
-	int Seconds = TimeElapsed % 60;
-	if (Seconds < 10)
-	{
-		TimeElapsedString.Append(TEXT("0"));
-	}
-	TimeElapsedString.Append(FString::FromInt(Seconds));
-	return TimeElapsedString;
-}
-
-void AFirstAttemptGameModeBase::EndGame()
-{
-	GetWorldTimerManager().ClearTimer(TimeElapsedHandle);
-}
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "FirstAttemptGameModeBase.h"
+#include "FirstAttemptGameState.h"
+#include "Kismet/GameplayStatics.h"
+#include "ThirdPersonCharacter.h"
+#include "EnemySpawner.h"
+#include "ProjectilePool.h"
+#include "BulletManager.h"
+#include "FireScheduler.h"
+#include "MuzzleCache.h"
+#include "SpawnScheduler.h"
+#include "CorpseManager.h"
+#include "CrowdManager.h"
+#include "PerceptionManager.h"
+#include "EnemySignificanceManager.h"
+#include "PathRequestManager.h"
+#include "FlowFieldManager.h"
+#include "PossessableRegistry.h"
+#include "BenchmarkDirector.h"
+#include "ReplayRecorder.h"
+#include "FirstAttemptPlayerController.h"
+#include "ContentPreloader.h"
+#include "GameplayEventBus.h"
+#include "GameFramework/PlayerStart.h"
+
+AFirstAttemptGameModeBase::AFirstAttemptGameModeBase()
+{
+	DefaultPawnClass = AThirdPersonCharacter::StaticClass();
+	GameStateClass = AFirstAttemptGameState::StaticClass();
+	PlayerControllerClass = AFirstAttemptPlayerController::StaticClass();
+	ProjectilePoolClass = AProjectilePool::StaticClass();
+	BulletManagerClass = ABulletManager::StaticClass();
+	FireSchedulerClass = AFireScheduler::StaticClass();
+	MuzzleCacheClass = AMuzzleCache::StaticClass();
+	SpawnSchedulerClass = ASpawnScheduler::StaticClass();
+	CorpseManagerClass = ACorpseManager::StaticClass();
+	CrowdManagerClass = ACrowdManager::StaticClass();
+	PerceptionManagerClass = APerceptionManager::StaticClass();
+	SignificanceManagerClass = AEnemySignificanceManager::StaticClass();
+	PathRequestManagerClass = APathRequestManager::StaticClass();
+	FlowFieldManagerClass = AFlowFieldManager::StaticClass();
+	PossessableRegistryClass = APossessableRegistry::StaticClass();
+	BenchmarkDirectorClass = ABenchmarkDirector::StaticClass();
+	ReplayRecorderClass = AReplayRecorder::StaticClass();
+	ContentPreloaderClass = AContentPreloader::StaticClass();
+	GameplayEventBusClass = AGameplayEventBus::StaticClass();
+	bUseBulletManager = false;
+	GameplayContext.GameMode = this;
+}
+
+void AFirstAttemptGameModeBase::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+	// The recorder seeds the random stream, so it has to be up before any actor begins play
+	if (ReplayRecorderClass != nullptr && AReplayRecorder::IsRequested())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		ReplayRecorder = GetWorld()->SpawnActor<AReplayRecorder>(ReplayRecorderClass, SpawnParams);
+	}
+	// A replay brings its own seed, otherwise take one from the command line so runs can be repeated
+	int32 RandomSeed = 0;
+	if (ReplayRecorder && (ReplayRecorder->IsRecording() || ReplayRecorder->IsPlayingBack()))
+	{
+		RandomSeed = ReplayRecorder->GetSeed();
+	}
+	else if (!FParse::Value(FCommandLine::Get(), TEXT("RandomSeed="), RandomSeed))
+	{
+		RandomSeed = (int32)FPlatformTime::Cycles();
+	}
+	RandomStreams.Initialize((uint32)RandomSeed);
+	UE_LOG(LogTemp, Log, TEXT("Random streams seeded with %d, pass -RandomSeed=%d to repeat this run"), RandomSeed, RandomSeed);
+	// Start streaming in character, vehicle and projectile content while the rest of the level starts up
+	AContentPreloader *Preloader = GetContentPreloader();
+	if (Preloader)
+	{
+		Preloader->StartPreload();
+	}
+}
+
+void AFirstAttemptGameModeBase::BeginPlay()
+{
+	// Warm up the projectile pool before anyone starts shooting, once the projectile mesh is in so it doesn't block
+	AContentPreloader *Preloader = GetContentPreloader();
+	if (Preloader)
+	{
+		Preloader->CallWhenLoaded(FSimpleDelegate::CreateUObject(this, &AFirstAttemptGameModeBase::WarmUpProjectiles));
+	}
+	else
+	{
+		WarmUpProjectiles();
+	}
+	// Score and corpses follow the kills published on the event bus
+	AGameplayEventBus *EventBus = GetGameplayEventBus();
+	if (EventBus)
+	{
+		EventBus->OnGameplayEvents().AddUObject(this, &AFirstAttemptGameModeBase::HandleGameplayEvents);
+	}
+	// Hand every spawner to the scheduler so they share one population cap and spawn budget. Crowd spawners fill the crowd manager themselves
+	ASpawnScheduler *Scheduler = GetSpawnScheduler();
+	TArray<AActor*> FoundActors;
+	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AEnemySpawner::StaticClass(), FoundActors);
+	for (int i = 0; i < FoundActors.Num(); i++)
+	{
+		AEnemySpawner *EnemyMaker = Cast<AEnemySpawner>(FoundActors[i]);
+		if (EnemyMaker && Scheduler && !EnemyMaker->IsCrowdSpawner())
+		{
+			//SpawnVolumeActors.AddUnique(SpawnVolumeActor);
+			Scheduler->SetSpawnerActive(EnemyMaker, true);
+		}
+	}
+	GetWorldTimerManager().SetTimer(TimeElapsedHandle, this, &AFirstAttemptGameModeBase::IncrementTimeElapsed, 1, true);
+	// Headless performance runs build their scenario round the first player start
+	if (BenchmarkDirectorClass != nullptr && FParse::Param(FCommandLine::Get(), TEXT("FirstAttemptBenchmark")))
+	{
+		TArray<AActor*> PlayerStarts;
+		UGameplayStatics::GetAllActorsOfClass(GetWorld(), APlayerStart::StaticClass(), PlayerStarts);
+		const FVector Location = (PlayerStarts.Num() > 0) ? PlayerStarts[0]->GetActorLocation() : FVector::ZeroVector;
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		BenchmarkDirector = GetWorld()->SpawnActor<ABenchmarkDirector>(BenchmarkDirectorClass, Location, FRotator::ZeroRotator, SpawnParams);
+	}
+}
+
+void AFirstAttemptGameModeBase::WarmUpProjectiles()
+{
+	if (bUseBulletManager)
+	{
+		GetBulletManager();
+	}
+	else
+	{
+		GetProjectilePool();
+	}
+}
+
+void AFirstAttemptGameModeBase::HandleGameplayEvents(const TArray<FGameplayEvent>& Events)
+{
+	for (const FGameplayEvent& Event : Events)
+	{
+		switch (Event.Type)
+		{
+		case EGameplayEventType::EnemyKilled:
+		{
+			IncrementKillCount(1);
+			ACorpseManager *Corpses = GetCorpseManager();
+			AThirdPersonCharacter *Victim = Cast<AThirdPersonCharacter>(Event.Victim.Get());
+			if (Corpses && Victim)
+			{
+				Corpses->AddCorpse(Victim);
+			}
+			break;
+		}
+		case EGameplayEventType::PlayerKilled:
+			EndGame();
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void AFirstAttemptGameModeBase::IncrementKillCount(int Amount)
+{
+	AFirstAttemptGameState *FirstAttemptGameState = GetGameState<AFirstAttemptGameState>();
+	if (FirstAttemptGameState)
+	{
+		FirstAttemptGameState->IncrementKillCount(Amount);
+	}
+}
+
+int AFirstAttemptGameModeBase::GetKillCount()
+{
+	AFirstAttemptGameState *FirstAttemptGameState = GetGameState<AFirstAttemptGameState>();
+	return FirstAttemptGameState ? FirstAttemptGameState->GetKillCount() : 0;
+}
+
+void AFirstAttemptGameModeBase::IncrementTimeElapsed()
+{
+	AFirstAttemptGameState *FirstAttemptGameState = GetGameState<AFirstAttemptGameState>();
+	if (FirstAttemptGameState)
+	{
+		FirstAttemptGameState->IncrementTimeElapsed();
+	}
+}
+
+FString AFirstAttemptGameModeBase::GetTimeElapsed()
+{
+	AFirstAttemptGameState *FirstAttemptGameState = GetGameState<AFirstAttemptGameState>();
+	return FirstAttemptGameState ? FirstAttemptGameState->GetTimeElapsed() : FString(TEXT("00:00"));
+}
+
+void AFirstAttemptGameModeBase::EndGame()
+{
+	GetWorldTimerManager().ClearTimer(TimeElapsedHandle);
+}
+
+template<class T>
+T* AFirstAttemptGameModeBase::GetOrSpawnManager(T*& Cached, TSubclassOf<T> Class)
+{
+	if (Cached == nullptr && Class != nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		Cached = GetWorld()->SpawnActor<T>(Class, SpawnParams);
+	}
+	return Cached;
+}
+
+AProjectilePool* AFirstAttemptGameModeBase::GetProjectilePool()
+{
+	return GetOrSpawnManager(ProjectilePool, ProjectilePoolClass);
+}
+
+ABulletManager* AFirstAttemptGameModeBase::GetBulletManager()
+{
+	return GetOrSpawnManager(BulletManager, BulletManagerClass);
+}
+
+AFireScheduler* AFirstAttemptGameModeBase::GetFireScheduler()
+{
+	return GetOrSpawnManager(FireScheduler, FireSchedulerClass);
+}
+
+AMuzzleCache* AFirstAttemptGameModeBase::GetMuzzleCache()
+{
+	return GetOrSpawnManager(MuzzleCache, MuzzleCacheClass);
+}
+
+ASpawnScheduler* AFirstAttemptGameModeBase::GetSpawnScheduler()
+{
+	return GetOrSpawnManager(SpawnScheduler, SpawnSchedulerClass);
+}
+
+ACorpseManager* AFirstAttemptGameModeBase::GetCorpseManager()
+{
+	return GetOrSpawnManager(CorpseManager, CorpseManagerClass);
+}
+
+ACrowdManager* AFirstAttemptGameModeBase::GetCrowdManager()
+{
+	return GetOrSpawnManager(CrowdManager, CrowdManagerClass);
+}
+
+APerceptionManager* AFirstAttemptGameModeBase::GetPerceptionManager()
+{
+	return GetOrSpawnManager(PerceptionManager, PerceptionManagerClass);
+}
+
+AEnemySignificanceManager* AFirstAttemptGameModeBase::GetSignificanceManager()
+{
+	return GetOrSpawnManager(SignificanceManager, SignificanceManagerClass);
+}
+
+APathRequestManager* AFirstAttemptGameModeBase::GetPathRequestManager()
+{
+	return GetOrSpawnManager(PathRequestManager, PathRequestManagerClass);
+}
+
+AFlowFieldManager* AFirstAttemptGameModeBase::GetFlowFieldManager()
+{
+	return GetOrSpawnManager(FlowFieldManager, FlowFieldManagerClass);
+}
+
+APossessableRegistry* AFirstAttemptGameModeBase::GetPossessableRegistry()
+{
+	return GetOrSpawnManager(PossessableRegistry, PossessableRegistryClass);
+}
+
+AContentPreloader* AFirstAttemptGameModeBase::GetContentPreloader()
+{
+	return GetOrSpawnManager(ContentPreloader, ContentPreloaderClass);
+}
+
+AGameplayEventBus* AFirstAttemptGameModeBase::GetGameplayEventBus()
+{
+	return GetOrSpawnManager(GameplayEventBus, GameplayEventBusClass);
+}
+
+void AFirstAttemptGameModeBase::SetEnemySignificanceEnabled(bool bEnabled)
+{
+	AEnemySignificanceManager *Manager = GetSignificanceManager();
+	if (Manager)
+	{
+		Manager->SetSignificanceEnabled(bEnabled);
+	}
+}
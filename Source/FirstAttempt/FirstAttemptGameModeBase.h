@@ -1,41 +1,234 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "GameFramework/GameModeBase.h"
-#include "FirstAttemptGameModeBase.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class FIRSTATTEMPT_API AFirstAttemptGameModeBase : public AGameModeBase
-{
-	GENERATED_BODY()
-	
-	
-public:
-	AFirstAttemptGameModeBase();
-
-	FORCEINLINE void IncrementKillCount(int Amount) { KillCount += Amount; }
-	UFUNCTION(BlueprintPure, Category = "Score")
-	int GetKillCount();
-
-	FORCEINLINE void IncrementTimeElapsed() { TimeElapsed++; }
-	UFUNCTION(BlueprintPure, Category = "Score")
-	FString GetTimeElapsed();
-	UFUNCTION(BlueprintCallable, Category = "GameEnd")
-	void EndGame();
-protected:
-	virtual void BeginPlay();
-	
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "HUD", meta = (BlueprintProtected = "true"))
-	TSubclassOf<class UUserWidget> HUDWidgetClass;
-	UPROPERTY()
-	class UUserWidget *CurrentWidget;
-
-private:
-	int KillCount;
-	int TimeElapsed;
-	FTimerHandle TimeElapsedHandle;
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/GameModeBase.h"
+#include "GameplayContext.h"
+#include "RandomStreams.h"
+#include "FirstAttemptGameModeBase.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class FIRSTATTEMPT_API AFirstAttemptGameModeBase : public AGameModeBase
+{
+	GENERATED_BODY()
+	
+	
+public:
+	AFirstAttemptGameModeBase();
+
+	/** Score and time live on the game state so they replicate. These pass through to it */
+	void IncrementKillCount(int Amount);
+	UFUNCTION(BlueprintPure, Category = "Score")
+	int GetKillCount();
+
+	void IncrementTimeElapsed();
+	UFUNCTION(BlueprintPure, Category = "Score")
+	FString GetTimeElapsed();
+	UFUNCTION(BlueprintCallable, Category = "GameEnd")
+	void EndGame();
+
+	/** Returns the pool projectiles are fired from, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Projectiles")
+	class AProjectilePool* GetProjectilePool();
+
+	/** Returns the manager that simulates bullets in bulk, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Projectiles")
+	class ABulletManager* GetBulletManager();
+
+	/** Returns the scheduler every enemy spawner goes through, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	class ASpawnScheduler* GetSpawnScheduler();
+
+	/** Returns the manager that puts dead enemies to sleep and recycles them, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	class ACorpseManager* GetCorpseManager();
+
+	/** Returns the scheduler that fires every shooting character's weapon, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Projectiles")
+	class AFireScheduler* GetFireScheduler();
+
+	/** Returns the cache of muzzle positions for shooting characters, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Projectiles")
+	class AMuzzleCache* GetMuzzleCache();
+
+	/** Returns the manager that does sight checks for every character, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Perception")
+	class APerceptionManager* GetPerceptionManager();
+
+	/** Returns the manager that turns down update rates for unimportant enemies, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Significance")
+	class AEnemySignificanceManager* GetSignificanceManager();
+
+	/** Returns the queue enemy controllers request paths through, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	class APathRequestManager* GetPathRequestManager();
+
+	/** Returns the flow field enemies chase the player with, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	class AFlowFieldManager* GetFlowFieldManager();
+
+	/** Returns the registry of pawns the player can switch into, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Possession")
+	class APossessableRegistry* GetPossessableRegistry();
+
+	/** Returns the preloader that streams in the module's content, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Content")
+	class AContentPreloader* GetContentPreloader();
+
+	/** Returns the manager that runs far away enemies as a lightweight crowd, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	class ACrowdManager* GetCrowdManager();
+
+	/** Returns the bus kills and deaths are published on, spawning it the first time it is needed */
+	UFUNCTION(BlueprintPure, Category = "Events")
+	class AGameplayEventBus* GetGameplayEventBus();
+
+	/** Console command to switch enemy significance LOD on and off when comparing frame times */
+	UFUNCTION(Exec)
+	void SetEnemySignificanceEnabled(bool bEnabled);
+
+	/** Returns the replay recorder, which only exists when the game was started with -RecordReplay or -PlayReplay */
+	FORCEINLINE class AReplayRecorder* GetReplayRecorder() const { return ReplayRecorder; }
+
+	/** Cached player pawn and frame timing for this world. Gameplay classes reach it through an FGameplayContextHandle */
+	FORCEINLINE FGameplayContext& GetGameplayContext() { return GameplayContext; }
+
+	/** This world's random stream for one system. Seeded in InitGame, so a given seed replays the same spawns */
+	FORCEINLINE FFastRandomStream& GetRandomStream(ERandomStream Stream) { return RandomStreams.Get(Stream); }
+
+	/** Seed every random stream was derived from */
+	FORCEINLINE uint64 GetRandomSeed() const { return RandomStreams.GetSeed(); }
+
+	/** Whether shots should go through the bullet manager instead of firing projectile actors */
+	FORCEINLINE bool IsUsingBulletManager() const { return bUseBulletManager; }
+	/** Widget every local player controller puts on screen. Read from the class defaults on clients, which have no game mode */
+	FORCEINLINE TSubclassOf<class UUserWidget> GetHUDWidgetClass() const { return HUDWidgetClass; }
+protected:
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void BeginPlay();
+
+	/** Spawns the projectile pool or bullet manager so they are ready before anyone shoots */
+	void WarmUpProjectiles();
+
+	/** Keeps score and hands dead enemies to the corpse manager */
+	void HandleGameplayEvents(const TArray<struct FGameplayEvent>& Events);
+	
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "HUD", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class UUserWidget> HUDWidgetClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Projectiles", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AProjectilePool> ProjectilePoolClass;
+
+	/** Simulate and draw all shots in one bullet manager instead of one projectile actor per shot */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Projectiles", meta = (BlueprintProtected = "true"))
+	bool bUseBulletManager;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Projectiles", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class ABulletManager> BulletManagerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Projectiles", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AFireScheduler> FireSchedulerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Projectiles", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AMuzzleCache> MuzzleCacheClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spawning", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class ASpawnScheduler> SpawnSchedulerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spawning", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class ACorpseManager> CorpseManagerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Spawning", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class ACrowdManager> CrowdManagerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Perception", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class APerceptionManager> PerceptionManagerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Significance", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AEnemySignificanceManager> SignificanceManagerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AI", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class APathRequestManager> PathRequestManagerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AI", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AFlowFieldManager> FlowFieldManagerClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Possession", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class APossessableRegistry> PossessableRegistryClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Content", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AContentPreloader> ContentPreloaderClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Events", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AGameplayEventBus> GameplayEventBusClass;
+
+	/** Spawned at the player start when the game is run with -FirstAttemptBenchmark */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Benchmark", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class ABenchmarkDirector> BenchmarkDirectorClass;
+
+	/** Spawned in InitGame when the game is run with -RecordReplay or -PlayReplay */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Replay", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class AReplayRecorder> ReplayRecorderClass;
+
+private:
+	FGameplayContext GameplayContext;
+
+	FRandomStreams RandomStreams;
+
+	FTimerHandle TimeElapsedHandle;
+
+	/** Spawns the manager of the given class into Cached the first time it's asked for */
+	template<class T>
+	T* GetOrSpawnManager(T*& Cached, TSubclassOf<T> Class);
+
+	UPROPERTY()
+	class AProjectilePool *ProjectilePool;
+
+	UPROPERTY()
+	class ABulletManager *BulletManager;
+
+	UPROPERTY()
+	class AFireScheduler *FireScheduler;
+
+	UPROPERTY()
+	class AMuzzleCache *MuzzleCache;
+
+	UPROPERTY()
+	class ASpawnScheduler *SpawnScheduler;
+
+	UPROPERTY()
+	class ACorpseManager *CorpseManager;
+
+	UPROPERTY()
+	class ACrowdManager *CrowdManager;
+
+	UPROPERTY()
+	class APerceptionManager *PerceptionManager;
+
+	UPROPERTY()
+	class AEnemySignificanceManager *SignificanceManager;
+
+	UPROPERTY()
+	class APathRequestManager *PathRequestManager;
+
+	UPROPERTY()
+	class AFlowFieldManager *FlowFieldManager;
+
+	UPROPERTY()
+	class APossessableRegistry *PossessableRegistry;
+
+	UPROPERTY()
+	class ABenchmarkDirector *BenchmarkDirector;
+
+	UPROPERTY()
+	class AReplayRecorder *ReplayRecorder;
+
+	UPROPERTY()
+	class AContentPreloader *ContentPreloader;
+
+	UPROPERTY()
+	class AGameplayEventBus *GameplayEventBus;
+};
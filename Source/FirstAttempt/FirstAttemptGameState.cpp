@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "FirstAttemptGameState.h"
+#include "FirstAttemptPlayerController.h"
+#include "Net/UnrealNetwork.h"
+
+AFirstAttemptGameState::AFirstAttemptGameState()
+{
+	KillCount = 0;
+	TimeElapsed = 0;
+}
+
+void AFirstAttemptGameState::BeginPlay()
+{
+	Super::BeginPlay();
+	// Headless multiplayer runs log the net report every few seconds so it ends up in the server log
+	float ReportInterval = 0.f;
+	if (HasAuthority() && FParse::Value(FCommandLine::Get(), TEXT("NetReportInterval="), ReportInterval) && ReportInterval > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(NetReportHandle, FTimerDelegate::CreateStatic(&AFirstAttemptGameState::ReportNetStats, GetWorld()), ReportInterval, true);
+	}
+}
+
+void AFirstAttemptGameState::ReceivedGameModeClass()
+{
+	Super::ReceivedGameModeClass();
+	// Controllers that began play before the game state replicated couldn't find the HUD class then
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		AFirstAttemptPlayerController *PlayerController = Cast<AFirstAttemptPlayerController>(It->Get());
+		if (PlayerController)
+		{
+			PlayerController->CreateHUDWidget();
+		}
+	}
+}
+
+void AFirstAttemptGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(AFirstAttemptGameState, KillCount);
+	DOREPLIFETIME(AFirstAttemptGameState, TimeElapsed);
+}
+
+int32 AFirstAttemptGameState::GetKillCount() const
+{
+	return KillCount;
+}
+
+FString AFirstAttemptGameState::GetTimeElapsed() const
+{
+	FString TimeElapsedString;
+	int Minutes = TimeElapsed / 60;
+	if (Minutes < 10)
+	{
+		TimeElapsedString.Append(TEXT("0"));
+	}
+	TimeElapsedString.Append(FString::FromInt(Minutes) + TEXT(":"));
+	int Seconds = TimeElapsed % 60;
+	if (Seconds < 10)
+	{
+		TimeElapsedString.Append(TEXT("0"));
+	}
+	TimeElapsedString.Append(FString::FromInt(Seconds));
+	return TimeElapsedString;
+}
+
+void AFirstAttemptGameState::ReportNetStats(UWorld* World)
+{
+	UNetDriver *NetDriver = World ? World->GetNetDriver() : NULL;
+	if (NetDriver == NULL)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Net report: not running a networked game"));
+		return;
+	}
+	const ENetMode NetMode = World->GetNetMode();
+	UE_LOG(LogTemp, Log, TEXT("Net report: %s, frame %.2f ms, %d clients"), NetMode == NM_DedicatedServer ? TEXT("dedicated server") : (NetMode == NM_Client ? TEXT("client") : TEXT("listen server")),
+		FPlatformTime::ToMilliseconds(GGameThreadTime), NetDriver->ClientConnections.Num());
+	for (UNetConnection *Connection : NetDriver->ClientConnections)
+	{
+		if (Connection)
+		{
+			UE_LOG(LogTemp, Log, TEXT("    %-24s out %6.1f KB/s, in %6.1f KB/s, ping %4.0f ms"), *Connection->LowLevelGetRemoteAddress(),
+				Connection->OutBytesPerSecond / 1024.f, Connection->InBytesPerSecond / 1024.f, Connection->PlayerController && Connection->PlayerController->PlayerState ? Connection->PlayerController->PlayerState->ExactPing : 0.f);
+		}
+	}
+	if (UNetConnection *ServerConnection = NetDriver->ServerConnection)
+	{
+		UE_LOG(LogTemp, Log, TEXT("    to server: out %6.1f KB/s, in %6.1f KB/s"), ServerConnection->OutBytesPerSecond / 1024.f, ServerConnection->InBytesPerSecond / 1024.f);
+	}
+}
+
+static FAutoConsoleCommandWithWorld NetReportCommand(
+	TEXT("FirstAttempt.NetReport"),
+	TEXT("Logs bandwidth for each client connection and the server frame time"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&AFirstAttemptGameState::ReportNetStats));
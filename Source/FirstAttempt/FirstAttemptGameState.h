@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/GameStateBase.h"
+#include "FirstAttemptGameState.generated.h"
+
+/**
+ * Score and match time, replicated to every client. The game mode changes them on the server and the HUD
+ * reads them from here so it works the same on clients, where there is no game mode. Also tells local player
+ * controllers to create the HUD once the game mode class it comes from is known.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AFirstAttemptGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	AFirstAttemptGameState();
+
+	virtual void BeginPlay() override;
+	virtual void ReceivedGameModeClass() override;
+
+	FORCEINLINE void IncrementKillCount(int32 Amount) { KillCount += Amount; }
+
+	FORCEINLINE void IncrementTimeElapsed() { TimeElapsed++; }
+
+	UFUNCTION(BlueprintPure, Category = "Score")
+	int32 GetKillCount() const;
+
+	/** Match time as mm:ss */
+	UFUNCTION(BlueprintPure, Category = "Score")
+	FString GetTimeElapsed() const;
+
+	/** Logs each client connection's bandwidth and the server's frame time for the world */
+	static void ReportNetStats(UWorld* World);
+
+private:
+	UPROPERTY(Replicated)
+	int32 KillCount;
+
+	/** Seconds since the match started */
+	UPROPERTY(Replicated)
+	int32 TimeElapsed;
+
+	FTimerHandle NetReportHandle;
+};
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "FirstAttemptPlayerController.h"
+#include "FirstAttemptGameModeBase.h"
+#include "ReplayRecorder.h"
+#include "Blueprint/UserWidget.h"
+
+AFirstAttemptPlayerController::AFirstAttemptPlayerController()
+{
+	bReplayingInput = false;
+	HUDWidget = NULL;
+}
+
+void AFirstAttemptPlayerController::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AFirstAttemptPlayerController::BeginPlay()
+{
+	Super::BeginPlay();
+	// On a client the game state may not be here yet, it calls back when it is
+	CreateHUDWidget();
+}
+
+void AFirstAttemptPlayerController::CreateHUDWidget()
+{
+	if (HUDWidget != NULL || !IsLocalPlayerController())
+	{
+		return;
+	}
+	const AGameStateBase *GameState = GetWorld()->GetGameState();
+	const AFirstAttemptGameModeBase *GameModeDefaults = GameState ? GameState->GetDefaultGameMode<AFirstAttemptGameModeBase>() : NULL;
+	if (GameModeDefaults == NULL || GameModeDefaults->GetHUDWidgetClass() == nullptr)
+	{
+		return;
+	}
+	HUDWidget = CreateWidget<UUserWidget>(this, GameModeDefaults->GetHUDWidgetClass());
+	if (HUDWidget != NULL)
+	{
+		HUDWidget->AddToViewport();
+	}
+}
+
+AReplayRecorder* AFirstAttemptPlayerController::GetReplayRecorder() const
+{
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	return GameMode ? GameMode->GetReplayRecorder() : NULL;
+}
+
+void AFirstAttemptPlayerController::PlayerTick(float DeltaTime)
+{
+	// Replayed input has to be in before PlayerTick processes this frame's input
+	AReplayRecorder *Recorder = GetReplayRecorder();
+	if (Recorder)
+	{
+		Recorder->OnPlayerTick(this, DeltaTime);
+	}
+	Super::PlayerTick(DeltaTime);
+}
+
+void AFirstAttemptPlayerController::Possess(APawn* InPawn)
+{
+	Super::Possess(InPawn);
+	if (GameplayContext.IsValid())
+	{
+		GameplayContext->InvalidatePlayerPawn();
+	}
+	AReplayRecorder *Recorder = GetReplayRecorder();
+	if (Recorder)
+	{
+		Recorder->RecordPossess(InPawn);
+	}
+}
+
+void AFirstAttemptPlayerController::UnPossess()
+{
+	Super::UnPossess();
+	if (GameplayContext.IsValid())
+	{
+		GameplayContext->InvalidatePlayerPawn();
+	}
+}
+
+bool AFirstAttemptPlayerController::InputKey(FKey Key, EInputEvent EventType, float AmountDepressed, bool bGamepad)
+{
+	AReplayRecorder *Recorder = GetReplayRecorder();
+	if (Recorder && Recorder->IsPlayingBack() && !bReplayingInput)
+	{
+		return true;
+	}
+	if (Recorder && Recorder->IsRecording())
+	{
+		Recorder->RecordInputKey(Key, EventType, AmountDepressed, bGamepad);
+	}
+	return Super::InputKey(Key, EventType, AmountDepressed, bGamepad);
+}
+
+bool AFirstAttemptPlayerController::InputAxis(FKey Key, float Delta, float DeltaTime, int32 NumSamples, bool bGamepad)
+{
+	AReplayRecorder *Recorder = GetReplayRecorder();
+	if (Recorder && Recorder->IsPlayingBack() && !bReplayingInput)
+	{
+		return true;
+	}
+	if (Recorder && Recorder->IsRecording())
+	{
+		Recorder->RecordInputAxis(Key, Delta, DeltaTime, NumSamples, bGamepad);
+	}
+	return Super::InputAxis(Key, Delta, DeltaTime, NumSamples, bGamepad);
+}
+
+void AFirstAttemptPlayerController::ReplayInputKey(const FKey& Key, EInputEvent EventType, float AmountDepressed, bool bGamepad)
+{
+	TGuardValue<bool> ReplayingGuard(bReplayingInput, true);
+	InputKey(Key, EventType, AmountDepressed, bGamepad);
+}
+
+void AFirstAttemptPlayerController::ReplayInputAxis(const FKey& Key, float Delta, float DeltaTime, int32 NumSamples, bool bGamepad)
+{
+	TGuardValue<bool> ReplayingGuard(bReplayingInput, true);
+	InputAxis(Key, Delta, DeltaTime, NumSamples, bGamepad);
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/PlayerController.h"
+#include "GameplayContext.h"
+#include "FirstAttemptPlayerController.generated.h"
+
+/**
+ * Player controller for the module. Hands the player's input and possessions to the replay recorder when a
+ * replay is being recorded, and while one is playing back ignores the real input in favour of the recorded one.
+ * Local controllers put the game mode's HUD widget on screen, on clients as well as on the server.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AFirstAttemptPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	AFirstAttemptPlayerController();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void PlayerTick(float DeltaTime) override;
+	virtual void Possess(APawn* InPawn) override;
+	virtual void UnPossess() override;
+	virtual bool InputKey(FKey Key, EInputEvent EventType, float AmountDepressed, bool bGamepad) override;
+	virtual bool InputAxis(FKey Key, float Delta, float DeltaTime, int32 NumSamples, bool bGamepad) override;
+
+	/** Feeds in a key event read back from a replay */
+	void ReplayInputKey(const FKey& Key, EInputEvent EventType, float AmountDepressed, bool bGamepad);
+
+	/** Feeds in an axis event read back from a replay */
+	void ReplayInputAxis(const FKey& Key, float Delta, float DeltaTime, int32 NumSamples, bool bGamepad);
+
+	/**
+	 * Puts the HUD on screen if this is a local controller and it isn't there yet. The widget class comes from the
+	 * game mode's defaults through the game state, so on a client this waits for the game state to arrive
+	 */
+	void CreateHUDWidget();
+
+private:
+	class AReplayRecorder* GetReplayRecorder() const;
+
+	FGameplayContextHandle GameplayContext;
+
+	/** Set while a replayed event is going through InputKey or InputAxis, so it isn't swallowed */
+	bool bReplayingInput;
+
+	UPROPERTY()
+	class UUserWidget *HUDWidget;
+};
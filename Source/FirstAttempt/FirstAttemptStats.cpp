@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "FirstAttemptStats.h"
+
+#if FIRSTATTEMPT_TIMINGS
+
+namespace
+{
+	TArray<FGameplayTimingCounter*> Counters;
+	int32 HistoryIndex = 0;
+	int32 FramesRecorded = 0;
+}
+
+FGameplayTimingCounter* FGameplayTimings::FindOrAddCounter(const TCHAR* Name)
+{
+	check(IsInGameThread());
+	for (FGameplayTimingCounter *Counter : Counters)
+	{
+		if (FCString::Strcmp(Counter->Name, Name) == 0)
+		{
+			return Counter;
+		}
+	}
+	if (Counters.Num() == 0)
+	{
+		FCoreDelegates::OnEndFrame.AddStatic(&FGameplayTimings::EndFrame);
+	}
+	// Counters live for the whole run, the macro keeps a pointer to them in a function static
+	FGameplayTimingCounter *Counter = new FGameplayTimingCounter();
+	FMemory::Memzero(*Counter);
+	Counter->Name = Name;
+	Counters.Add(Counter);
+	return Counter;
+}
+
+void FGameplayTimings::EndFrame()
+{
+	for (FGameplayTimingCounter *Counter : Counters)
+	{
+		Counter->HistoryCycles[HistoryIndex] = Counter->FrameCycles;
+		Counter->HistoryCalls[HistoryIndex] = Counter->FrameCalls;
+		Counter->FrameCycles = 0;
+		Counter->FrameCalls = 0;
+	}
+	HistoryIndex = (HistoryIndex + 1) % FGameplayTimingCounter::HistoryFrames;
+	FramesRecorded = FMath::Min(FramesRecorded + 1, (int32)FGameplayTimingCounter::HistoryFrames);
+}
+
+void FGameplayTimings::DumpSummary()
+{
+	struct FSummaryLine
+	{
+		const TCHAR* Name;
+		double AverageMs;
+		double WorstMs;
+		double AverageCalls;
+	};
+	TArray<FSummaryLine> Lines;
+	for (const FGameplayTimingCounter *Counter : Counters)
+	{
+		FSummaryLine Line;
+		Line.Name = Counter->Name;
+		Line.AverageMs = 0.0;
+		Line.WorstMs = 0.0;
+		Line.AverageCalls = 0.0;
+		for (int32 i = 0; i < FramesRecorded; i++)
+		{
+			const double Ms = FPlatformTime::ToMilliseconds(Counter->HistoryCycles[i]);
+			Line.AverageMs += Ms;
+			Line.WorstMs = FMath::Max(Line.WorstMs, Ms);
+			Line.AverageCalls += Counter->HistoryCalls[i];
+		}
+		if (FramesRecorded > 0)
+		{
+			Line.AverageMs /= FramesRecorded;
+			Line.AverageCalls /= FramesRecorded;
+		}
+		Lines.Add(Line);
+	}
+	Lines.Sort([](const FSummaryLine& A, const FSummaryLine& B) { return A.AverageMs > B.AverageMs; });
+
+	UE_LOG(LogTemp, Display, TEXT("FirstAttempt timings over the last %d frames:"), FramesRecorded);
+	UE_LOG(LogTemp, Display, TEXT("%-40s %10s %10s %10s"), TEXT("Scope"), TEXT("Avg ms"), TEXT("Worst ms"), TEXT("Calls"));
+	for (const FSummaryLine& Line : Lines)
+	{
+		UE_LOG(LogTemp, Display, TEXT("%-40s %10.3f %10.3f %10.1f"), Line.Name, Line.AverageMs, Line.WorstMs, Line.AverageCalls);
+	}
+}
+
+static FAutoConsoleCommand GameplayTimingSummaryCommand(
+	TEXT("FirstAttempt.Summary"),
+	TEXT("Logs the time each FirstAttempt gameplay system took per frame over the last couple of seconds"),
+	FConsoleCommandDelegate::CreateStatic(&FGameplayTimings::DumpSummary));
+
+#endif
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Stats/Stats.h"
+
+/** Stat group for the gameplay systems in this module. View in game with "stat FirstAttempt" */
+DECLARE_STATS_GROUP(TEXT("FirstAttempt"), STATGROUP_FirstAttempt, STATCAT_Advanced);
+
+/** Rolling per system timings for the FirstAttempt.Summary console command. Left out of shipping builds */
+#define FIRSTATTEMPT_TIMINGS !UE_BUILD_SHIPPING
+
+#if FIRSTATTEMPT_TIMINGS
+
+/** Time spent in one instrumented scope over the last few seconds of frames */
+struct FGameplayTimingCounter
+{
+	enum { HistoryFrames = 120 };
+
+	const TCHAR* Name;
+
+	uint32 FrameCycles;
+	uint32 FrameCalls;
+
+	uint32 HistoryCycles[HistoryFrames];
+	uint32 HistoryCalls[HistoryFrames];
+};
+
+/** Keeps every timing counter and rolls them over at the end of each frame. Game thread only */
+class FIRSTATTEMPT_API FGameplayTimings
+{
+public:
+	/** Returns the counter with this name, creating it the first time */
+	static FGameplayTimingCounter* FindOrAddCounter(const TCHAR* Name);
+
+	/** Logs average, worst and call count per frame for every counter, slowest first */
+	static void DumpSummary();
+
+private:
+	static void EndFrame();
+};
+
+/** Adds the time until the end of the enclosing scope to a counter */
+struct FGameplayTimingScope
+{
+	FGameplayTimingScope(FGameplayTimingCounter* InCounter)
+		: Counter(InCounter)
+		, StartCycles(FPlatformTime::Cycles())
+	{
+	}
+
+	~FGameplayTimingScope()
+	{
+		Counter->FrameCycles += FPlatformTime::Cycles() - StartCycles;
+		Counter->FrameCalls++;
+	}
+
+private:
+	FGameplayTimingCounter* Counter;
+	uint32 StartCycles;
+};
+
+/** SCOPE_CYCLE_COUNTER that also feeds the FirstAttempt.Summary console command */
+#define FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	static FGameplayTimingCounter* PREPROCESSOR_JOIN(TimingCounter_, __LINE__) = FGameplayTimings::FindOrAddCounter(TEXT(#Stat)); \
+	FGameplayTimingScope PREPROCESSOR_JOIN(TimingScope_, __LINE__)(PREPROCESSOR_JOIN(TimingCounter_, __LINE__))
+
+#else
+
+#define FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(Stat) SCOPE_CYCLE_COUNTER(Stat)
+
+#endif
@@ -0,0 +1,507 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "FlowFieldManager.h"
+#include "AI/Navigation/NavigationSystem.h"
+#include "AI/Navigation/NavMeshBoundsVolume.h"
+#include "Async/Async.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flow Field Tick"), STAT_FlowFieldTick, STATGROUP_FirstAttempt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Flow Field Rebuild (ms)"), STAT_FlowFieldRebuildMs, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Flow Field Rebuilds"), STAT_FlowFieldRebuilds, STATGROUP_FirstAttempt);
+
+/** Heights value of a cell with no navmesh */
+static const float NoHeight = MAX_flt;
+
+/** Directions value of a cell with nowhere to go */
+static const uint8 NoDirection = 0xFF;
+
+/** Owners value of a cell that can't reach any target, which also caps the number of targets */
+static const uint8 NoOwner = 0xFF;
+
+/** The eight neighbours of a cell, going round from +X */
+static const int32 NeighbourX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int32 NeighbourY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+/** Cost of a step to each neighbour, diagonals about root two times a straight step */
+static const int32 StepCost[8] = { 10, 14, 10, 14, 10, 14, 10, 14 };
+
+AFlowFieldManager::AFlowFieldManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	CellSize = 200.f;
+	MaxCellsPerSide = 512;
+	MaxStepHeight = 100.f;
+	GridOrigin = FVector2D::ZeroVector;
+	SizeX = 0;
+	SizeY = 0;
+	bGridReady = false;
+	SampleZ = 0.f;
+	SampleHalfHeight = 0.f;
+	NumWalkableCells = 0;
+	NumLinks = 0;
+	NumRebuilds = 0;
+	LastRebuildMs = 0.f;
+	RebuildMsLastFrame = 0.f;
+}
+
+void AFlowFieldManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AFlowFieldManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FBox Bounds(ForceInit);
+	for (TActorIterator<ANavMeshBoundsVolume> It(GetWorld()); It; ++It)
+	{
+		Bounds += It->GetComponentsBoundingBox(true);
+	}
+	if (!Bounds.IsValid)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Flow field: the level has no nav mesh bounds volume, enemies will find their own paths"));
+		return;
+	}
+
+	const FVector Size = Bounds.GetSize();
+	CellSize = FMath::Max(CellSize, FMath::Max(Size.X, Size.Y) / MaxCellsPerSide);
+	SizeX = FMath::Max(1, FMath::CeilToInt(Size.X / CellSize));
+	SizeY = FMath::Max(1, FMath::CeilToInt(Size.Y / CellSize));
+	GridOrigin = FVector2D(Bounds.Min.X, Bounds.Min.Y);
+	SampleZ = Bounds.GetCenter().Z;
+	SampleHalfHeight = Bounds.GetExtent().Z;
+	Heights.Init(NoHeight, SizeX * SizeY);
+	Links.Init(0, SizeX * SizeY);
+}
+
+void AFlowFieldManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The workers write into this actor, let them finish first
+	if (PendingRebuild.IsValid())
+	{
+		PendingRebuild.Wait();
+	}
+	if (PendingGridSetup.IsValid())
+	{
+		PendingGridSetup.Wait();
+		PendingGridSetup = TFuture<float>();
+		UNavigationSystem *NavSys = UNavigationSystem::GetCurrent<UNavigationSystem>(GetWorld());
+		if (NavSys)
+		{
+			NavSys->RemoveNavigationBuildLock(ENavigationBuildLock::Custom);
+		}
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AFlowFieldManager::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_FlowFieldTick);
+	Super::Tick(DeltaSeconds);
+
+	RebuildMsLastFrame = 0.f;
+	if (!bGridReady)
+	{
+		UpdateGridSetup();
+		return;
+	}
+
+	if (PendingRebuild.IsValid())
+	{
+		if (!PendingRebuild.IsReady())
+		{
+			return;
+		}
+		LastRebuildMs = PendingRebuild.Get();
+		RebuildMsLastFrame = LastRebuildMs;
+		PendingRebuild = TFuture<float>();
+		Swap(Directions, PendingDirections);
+		Swap(Costs, PendingCosts);
+		Swap(Owners, PendingOwners);
+		FieldTargetCells = PendingTargetCells;
+		FieldTargets = PendingTargets;
+		NumRebuilds++;
+		SET_FLOAT_STAT(STAT_FlowFieldRebuildMs, LastRebuildMs);
+		SET_DWORD_STAT(STAT_FlowFieldRebuilds, NumRebuilds);
+	}
+
+	// Only a player moving into another cell, or coming or going, changes the field. Players off the navmesh
+	// or sharing a cell with another aren't targets until they move
+	TargetCells.Reset();
+	Targets.Reset();
+	if (GameplayContext.IsValid())
+	{
+		for (APawn *PlayerPawn : GameplayContext->GetPlayerPawns())
+		{
+			const int32 TargetCell = GetCellIndex(PlayerPawn->GetNavAgentLocation());
+			if (TargetCell != INDEX_NONE && Heights[TargetCell] != NoHeight && !TargetCells.Contains(TargetCell) && Targets.Num() < NoOwner)
+			{
+				TargetCells.Add(TargetCell);
+				Targets.Add(PlayerPawn);
+			}
+		}
+	}
+	if (Targets.Num() > 0 && (TargetCells != FieldTargetCells || Targets != FieldTargets))
+	{
+		StartRebuild(TargetCells, Targets);
+	}
+}
+
+void AFlowFieldManager::UpdateGridSetup()
+{
+	UNavigationSystem *NavSys = UNavigationSystem::GetCurrent<UNavigationSystem>(GetWorld());
+	if (NavSys == NULL || Heights.Num() == 0)
+	{
+		return;
+	}
+	if (PendingGridSetup.IsValid())
+	{
+		if (!PendingGridSetup.IsReady())
+		{
+			return;
+		}
+		const float SetupMs = PendingGridSetup.Get();
+		PendingGridSetup = TFuture<float>();
+		NavSys->RemoveNavigationBuildLock(ENavigationBuildLock::Custom);
+		bGridReady = true;
+		UE_LOG(LogTemp, Log, TEXT("Flow field: %d x %d cells of %.0f, %d walkable, %d links, set up in %.0f ms"), SizeX, SizeY, CellSize, NumWalkableCells, NumLinks, SetupMs);
+		return;
+	}
+
+	// Hundreds of thousands of navmesh queries on a big level, which would take the game thread tens of seconds
+	// a batch a frame. The worker only reads the navmesh, so wait for any build to finish and hold off the next
+	// one until it is done
+	if (NavSys->IsNavigationBuildInProgress())
+	{
+		return;
+	}
+	NavSys->AddNavigationBuildLock(ENavigationBuildLock::Custom);
+	PendingGridSetup = Async<float>(EAsyncExecution::ThreadPool, [this, NavSys]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		SampleCells(NavSys);
+		LinkCells();
+		return (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	});
+}
+
+void AFlowFieldManager::SampleCells(UNavigationSystem* NavSys)
+{
+	const FVector Extent(CellSize * 0.5f, CellSize * 0.5f, SampleHalfHeight);
+	for (int32 Cell = 0; Cell < Heights.Num(); Cell++)
+	{
+		const FVector Centre(GridOrigin.X + (Cell % SizeX + 0.5f) * CellSize, GridOrigin.Y + (Cell / SizeX + 0.5f) * CellSize, SampleZ);
+		FNavLocation NavLocation;
+		if (NavSys->ProjectPointToNavigation(Centre, NavLocation, Extent))
+		{
+			Heights[Cell] = NavLocation.Location.Z;
+			NumWalkableCells++;
+		}
+	}
+}
+
+void AFlowFieldManager::LinkCells()
+{
+	// Only half the directions are cast from each cell, the other half are the same links seen from the neighbour
+	for (int32 Cell = 0; Cell < Links.Num(); Cell++)
+	{
+		const float Height = Heights[Cell];
+		if (Height == NoHeight)
+		{
+			continue;
+		}
+		const int32 X = Cell % SizeX;
+		const int32 Y = Cell / SizeX;
+		for (int32 Direction = 0; Direction < 4; Direction++)
+		{
+			const int32 NX = X + NeighbourX[Direction];
+			const int32 NY = Y + NeighbourY[Direction];
+			if (NX < 0 || NY < 0 || NX >= SizeX || NY >= SizeY)
+			{
+				continue;
+			}
+			const int32 Neighbour = NY * SizeX + NX;
+			if (Heights[Neighbour] == NoHeight || FMath::Abs(Heights[Neighbour] - Height) > MaxStepHeight)
+			{
+				continue;
+			}
+			// No cutting corners past a cell with no navmesh
+			if ((Direction & 1) != 0 && (Heights[Y * SizeX + NX] == NoHeight || Heights[NY * SizeX + X] == NoHeight))
+			{
+				continue;
+			}
+			// Both cells can be on the navmesh with a wall between them
+			FVector HitLocation;
+			if (UNavigationSystem::NavigationRaycast(this, GetCellLocation(Cell), GetCellLocation(Neighbour), HitLocation))
+			{
+				continue;
+			}
+			Links[Cell] |= 1 << Direction;
+			Links[Neighbour] |= 1 << ((Direction + 4) & 7);
+			NumLinks++;
+		}
+	}
+}
+
+void AFlowFieldManager::StartRebuild(const TArray<int32>& NewTargetCells, const TArray<APawn*>& NewTargets)
+{
+	PendingTargetCells = NewTargetCells;
+	PendingTargets = NewTargets;
+	// Only a single target that moved on from a single target can reuse the old field
+	const int32 PreviousTargetCell = (NewTargetCells.Num() == 1 && FieldTargetCells.Num() == 1) ? FieldTargetCells[0] : INDEX_NONE;
+	PendingRebuild = Async<float>(EAsyncExecution::ThreadPool, [this, PreviousTargetCell]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		BuildField(PendingTargetCells, PreviousTargetCell, PendingDirections, PendingCosts, PendingOwners);
+		return (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	});
+}
+
+void AFlowFieldManager::BuildField(const TArray<int32>& InTargetCells, int32 PreviousTargetCell, TArray<uint8>& OutDirections, TArray<int32>& OutCosts, TArray<uint8>& OutOwners) const
+{
+	const int32 NumCells = Links.Num();
+
+	// Distance from the nearest target to every cell. Steps are the same both ways, so this is also the distance to it
+	struct FOpenCell
+	{
+		int32 Cost;
+		int32 Index;
+
+		bool operator<(const FOpenCell& Other) const
+		{
+			return Cost < Other.Cost;
+		}
+	};
+	OutCosts.Init(MAX_int32, NumCells);
+	OutDirections.Init(NoDirection, NumCells);
+	OutOwners.Init(NoOwner, NumCells);
+	TArray<FOpenCell> Open;
+	for (int32 Target = 0; Target < InTargetCells.Num(); Target++)
+	{
+		OutCosts[InTargetCells[Target]] = 0;
+		OutOwners[InTargetCells[Target]] = (uint8)Target;
+		Open.HeapPush(FOpenCell{ 0, InTargetCells[Target] });
+	}
+
+	// Cells whose way to the old target went through the new one are just as far from it, less the step between the
+	// two, and still point the right way. Only the cells round them need searching again
+	TArray<bool> Kept;
+	const int32 TargetCell = InTargetCells[0];
+	const int32 MoveDirection = InTargetCells.Num() == 1 ? GetLinkDirection(PreviousTargetCell, TargetCell) : INDEX_NONE;
+	if (MoveDirection != INDEX_NONE && Costs.Num() == NumCells && Directions.Num() == NumCells && Costs[TargetCell] == StepCost[MoveDirection])
+	{
+		const int32 MoveCost = StepCost[MoveDirection];
+		// 0 not worked out yet, 1 goes through the new target, 2 doesn't
+		TArray<uint8> Through;
+		Through.Init(0, NumCells);
+		Through[TargetCell] = 1;
+		Through[PreviousTargetCell] = 2;
+		TArray<int32> Chain;
+		for (int32 Index = 0; Index < NumCells; Index++)
+		{
+			// Follow the old field until a cell that has been worked out, then the whole way there gets its answer
+			int32 Cell = Index;
+			while (Through[Cell] == 0 && Directions[Cell] != NoDirection)
+			{
+				Chain.Add(Cell);
+				Cell += NeighbourY[Directions[Cell]] * SizeX + NeighbourX[Directions[Cell]];
+			}
+			const uint8 Answer = Through[Cell] == 0 ? 2 : Through[Cell];
+			Through[Index] = Answer;
+			for (const int32 ChainCell : Chain)
+			{
+				Through[ChainCell] = Answer;
+			}
+			Chain.Reset();
+		}
+
+		Kept.Init(false, NumCells);
+		Open.Reset();
+		for (int32 Index = 0; Index < NumCells; Index++)
+		{
+			if (Through[Index] != 1 || Index == TargetCell)
+			{
+				continue;
+			}
+			Kept[Index] = true;
+			OutCosts[Index] = Costs[Index] - MoveCost;
+			OutDirections[Index] = Directions[Index];
+			OutOwners[Index] = 0;
+		}
+		Kept[TargetCell] = true;
+		// The search starts from every kept cell that borders one that isn't
+		for (int32 Index = 0; Index < NumCells; Index++)
+		{
+			if (!Kept[Index])
+			{
+				continue;
+			}
+			for (int32 Direction = 0; Direction < 8; Direction++)
+			{
+				if ((Links[Index] & (1 << Direction)) != 0 && !Kept[Index + NeighbourY[Direction] * SizeX + NeighbourX[Direction]])
+				{
+					Open.HeapPush(FOpenCell{ OutCosts[Index], Index });
+					break;
+				}
+			}
+		}
+	}
+
+	while (Open.Num() > 0)
+	{
+		FOpenCell Cell;
+		Open.HeapPop(Cell, false);
+		if (Cell.Cost > OutCosts[Cell.Index])
+		{
+			continue;
+		}
+		for (int32 Direction = 0; Direction < 8; Direction++)
+		{
+			if ((Links[Cell.Index] & (1 << Direction)) == 0)
+			{
+				continue;
+			}
+			const int32 Neighbour = Cell.Index + NeighbourY[Direction] * SizeX + NeighbourX[Direction];
+			const int32 NewCost = Cell.Cost + StepCost[Direction];
+			if (NewCost < OutCosts[Neighbour])
+			{
+				OutCosts[Neighbour] = NewCost;
+				OutOwners[Neighbour] = OutOwners[Cell.Index];
+				Open.HeapPush(FOpenCell{ NewCost, Neighbour });
+			}
+		}
+	}
+
+	// Every other reachable cell points at the neighbour its shortest way goes through, so following the
+	// directions always walks a shortest way, which the next rebuild relies on. Where two targets are just as
+	// far the way may end at the other one than OutOwners says, either is as near
+	for (int32 Index = 0; Index < NumCells; Index++)
+	{
+		if (OutCosts[Index] == MAX_int32 || OutCosts[Index] == 0 || (Kept.Num() > 0 && Kept[Index]))
+		{
+			continue;
+		}
+		int32 BestCost = MAX_int32;
+		for (int32 Direction = 0; Direction < 8; Direction++)
+		{
+			if ((Links[Index] & (1 << Direction)) == 0)
+			{
+				continue;
+			}
+			const int32 NeighbourCost = OutCosts[Index + NeighbourY[Direction] * SizeX + NeighbourX[Direction]];
+			if (NeighbourCost != MAX_int32 && NeighbourCost + StepCost[Direction] < BestCost)
+			{
+				BestCost = NeighbourCost + StepCost[Direction];
+				OutDirections[Index] = (uint8)Direction;
+			}
+		}
+	}
+}
+
+int32 AFlowFieldManager::GetLinkDirection(int32 FromCell, int32 ToCell) const
+{
+	if (FromCell == INDEX_NONE || ToCell == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+	const int32 DeltaX = ToCell % SizeX - FromCell % SizeX;
+	const int32 DeltaY = ToCell / SizeX - FromCell / SizeX;
+	for (int32 Direction = 0; Direction < 8; Direction++)
+	{
+		if (NeighbourX[Direction] == DeltaX && NeighbourY[Direction] == DeltaY)
+		{
+			return (Links[FromCell] & (1 << Direction)) != 0 ? Direction : INDEX_NONE;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 AFlowFieldManager::GetCellIndex(const FVector& Location) const
+{
+	const int32 X = FMath::FloorToInt((Location.X - GridOrigin.X) / CellSize);
+	const int32 Y = FMath::FloorToInt((Location.Y - GridOrigin.Y) / CellSize);
+	if (X < 0 || Y < 0 || X >= SizeX || Y >= SizeY)
+	{
+		return INDEX_NONE;
+	}
+	return Y * SizeX + X;
+}
+
+FVector AFlowFieldManager::GetCellLocation(int32 Index) const
+{
+	return FVector(GridOrigin.X + (Index % SizeX + 0.5f) * CellSize, GridOrigin.Y + (Index / SizeX + 0.5f) * CellSize, Heights[Index]);
+}
+
+bool AFlowFieldManager::CanStep(const FVector& From, const FVector& To, float& OutHeightChange) const
+{
+	OutHeightChange = 0.f;
+	const int32 FromCell = IsGridReady() ? GetCellIndex(From) : INDEX_NONE;
+	const int32 ToCell = IsGridReady() ? GetCellIndex(To) : INDEX_NONE;
+	if (FromCell == INDEX_NONE || ToCell == INDEX_NONE)
+	{
+		return false;
+	}
+	if (FromCell == ToCell || Heights[FromCell] == NoHeight)
+	{
+		return true;
+	}
+	if (GetLinkDirection(FromCell, ToCell) == INDEX_NONE)
+	{
+		return false;
+	}
+	OutHeightChange = Heights[ToCell] - Heights[FromCell];
+	return true;
+}
+
+bool AFlowFieldManager::GetFlowDirection(const FVector& Location, FVector& OutDirection) const
+{
+	const int32 Index = IsReady() ? GetCellIndex(Location) : INDEX_NONE;
+	if (Index == INDEX_NONE || Directions[Index] == NoDirection)
+	{
+		return false;
+	}
+	const int32 Direction = Directions[Index];
+	OutDirection = FVector(NeighbourX[Direction], NeighbourY[Direction], 0.f).GetSafeNormal();
+	return true;
+}
+
+bool AFlowFieldManager::TracePath(const FVector& Location, const APawn* Target, int32 MaxPoints, TArray<FVector>& OutPoints) const
+{
+	int32 Index = IsReady() ? GetCellIndex(Location) : INDEX_NONE;
+	if (Index == INDEX_NONE || Owners[Index] == NoOwner || FieldTargets[Owners[Index]] != Target)
+	{
+		return false;
+	}
+	for (int32 i = 0; i < MaxPoints && Costs[Index] != 0; i++)
+	{
+		const int32 Direction = Directions[Index];
+		Index += NeighbourY[Direction] * SizeX + NeighbourX[Direction];
+		OutPoints.Add(GetCellLocation(Index));
+	}
+	return true;
+}
+
+int32 AFlowFieldManager::GetNumWalkableCells() const
+{
+	// Still being counted on the worker until then
+	return bGridReady ? NumWalkableCells : 0;
+}
+
+int32 AFlowFieldManager::GetNumRebuilds() const
+{
+	return NumRebuilds;
+}
+
+float AFlowFieldManager::GetLastRebuildMs() const
+{
+	return LastRebuildMs;
+}
+
+float AFlowFieldManager::GetRebuildMsLastFrame() const
+{
+	return RebuildMsLastFrame;
+}
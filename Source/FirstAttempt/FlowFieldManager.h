@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "GameplayContext.h"
+#include "Async/Future.h"
+#include "FlowFieldManager.generated.h"
+
+class UNavigationSystem;
+
+/**
+ * Keeps one flow field leading every walkable cell of the level to the nearest player, so any number of enemies
+ * can chase the players by looking up their cell instead of each finding a path. The level's navmesh bounds are
+ * cut into a grid of CellSize cells and each cell is checked against the navmesh once, then each pair of
+ * neighbouring cells is raycast along the navmesh so the field never leads through a wall. That setup runs once
+ * on a worker thread, with navmesh building held off until it is done. After that, whenever a player moves into
+ * another cell the distance and direction of every cell are worked out again on a worker thread and swapped in
+ * when done, the old field staying in use meanwhile. When there is one player and they only stepped into a
+ * neighbouring cell, cells whose way led through that cell keep their direction and only the rest are searched
+ * again.
+ * The grid is a single layer, so levels with walkable floors above each other only get the nearest one.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AFlowFieldManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AFlowFieldManager();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Whether there is a field to follow yet */
+	FORCEINLINE bool IsReady() const { return FieldTargets.Num() > 0; }
+
+	/** Whether the current field leads to Pawn from anywhere */
+	FORCEINLINE bool IsFieldTarget(const APawn* Pawn) const { return FieldTargets.Contains(Pawn); }
+
+	/** Whether every cell has been checked against the navmesh and linked to its neighbours, so CanStep can answer */
+	FORCEINLINE bool IsGridReady() const { return bGridReady; }
+
+	/**
+	 * Whether a move from From to To stays on cells the navmesh joins: the same cell, or a linked neighbour.
+	 * OutHeightChange is how far the navmesh rises on the way. A move from a cell with no navmesh is always
+	 * allowed so whatever is there can walk back on. Only reads the grid, so it is safe from worker threads
+	 */
+	bool CanStep(const FVector& From, const FVector& To, float& OutHeightChange) const;
+
+	/** Which way to go from Location towards the nearest target, false if it is off the grid, can't reach one or is in a target's cell */
+	bool GetFlowDirection(const FVector& Location, FVector& OutDirection) const;
+
+	/**
+	 * Follows the field from Location for up to MaxPoints cells, adding the middle of each cell on the navmesh to
+	 * OutPoints. Returns false if Location is off the grid, can't reach a target or the field leads it to a target
+	 * other than Target.
+	 */
+	bool TracePath(const FVector& Location, const APawn* Target, int32 MaxPoints, TArray<FVector>& OutPoints) const;
+
+	/** Cells the navmesh covers, 0 until the grid is set up */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	int32 GetNumWalkableCells() const;
+
+	/** Times the field has been worked out again */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	int32 GetNumRebuilds() const;
+
+	/** Worker thread time of the last rebuild, in milliseconds */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	float GetLastRebuildMs() const;
+
+	/** Worker thread time of a rebuild swapped in during the last tick, 0 if none was */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	float GetRebuildMsLastFrame() const;
+
+	/** Size of a grid cell. Grown if the level needs more than MaxCellsPerSide cells across */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AI")
+	float CellSize;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AI")
+	int32 MaxCellsPerSide;
+
+	/** Neighbouring cells further apart in height than this aren't connected */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float MaxStepHeight;
+
+private:
+	/** Starts setting the grid up on a worker thread once the navmesh is built, and finishes once it is done */
+	void UpdateGridSetup();
+
+	/** Checks every cell against the navmesh and fills in Heights. Runs on a worker thread */
+	void SampleCells(UNavigationSystem* NavSys);
+
+	/** Raycasts from every cell to its neighbours and fills in Links. Runs on a worker thread */
+	void LinkCells();
+
+	/** Starts working out the field for the target cells, one for each of NewTargets, on a worker thread */
+	void StartRebuild(const TArray<int32>& NewTargetCells, const TArray<APawn*>& NewTargets);
+
+	/**
+	 * Fills OutDirections, OutCosts and OutOwners for the target cells. With a single target, reuses the current field
+	 * where it can when PreviousTargetCell is next to it. Runs on a worker thread and only reads Links and the current
+	 * Directions and Costs
+	 */
+	void BuildField(const TArray<int32>& InTargetCells, int32 PreviousTargetCell, TArray<uint8>& OutDirections, TArray<int32>& OutCosts, TArray<uint8>& OutOwners) const;
+
+	/** Direction of the link from one cell to the next one over, INDEX_NONE if they aren't linked neighbours */
+	int32 GetLinkDirection(int32 FromCell, int32 ToCell) const;
+
+	/** Cell index for a location, INDEX_NONE off the grid */
+	int32 GetCellIndex(const FVector& Location) const;
+
+	FVector GetCellLocation(int32 Index) const;
+
+	/** Player pawns, looked up through the context so the field follows possession changes */
+	FGameplayContextHandle GameplayContext;
+
+	/** World position of the corner of cell 0 */
+	FVector2D GridOrigin;
+
+	int32 SizeX;
+	int32 SizeY;
+
+	/** Navmesh height of every cell, NoHeight where there is no navmesh. Only written by the grid setup */
+	TArray<float> Heights;
+
+	/** One bit per neighbour direction for every cell, set where the navmesh joins the two cells. Only written by the grid setup */
+	TArray<uint8> Links;
+
+	/** Grid setup in flight, returns how long it took in milliseconds */
+	TFuture<float> PendingGridSetup;
+
+	/** Heights and Links are filled in and nothing writes them any more */
+	bool bGridReady;
+
+	float SampleZ;
+	float SampleHalfHeight;
+
+	/** Neighbour to head for from every cell, NoDirection where there is none */
+	TArray<uint8> Directions;
+
+	/** Cost of the way from every cell to the nearest of the field's targets, MAX_int32 where there is none */
+	TArray<int32> Costs;
+
+	/** Index into FieldTargets of the target every cell leads to, NoOwner where there is none */
+	TArray<uint8> Owners;
+
+	/** Filled by the worker, swapped with Directions, Costs and Owners when it is done */
+	TArray<uint8> PendingDirections;
+	TArray<int32> PendingCosts;
+	TArray<uint8> PendingOwners;
+
+	/** Rebuild in flight, returns how long it took in milliseconds */
+	TFuture<float> PendingRebuild;
+
+	TArray<int32> PendingTargetCells;
+
+	UPROPERTY()
+	TArray<APawn*> PendingTargets;
+
+	/** Cells and pawns the field in Directions leads to */
+	TArray<int32> FieldTargetCells;
+
+	UPROPERTY()
+	TArray<APawn*> FieldTargets;
+
+	/** Scratch lists of where the players are this tick */
+	TArray<int32> TargetCells;
+	TArray<APawn*> Targets;
+
+	int32 NumWalkableCells;
+	int32 NumLinks;
+	int32 NumRebuilds;
+	float LastRebuildMs;
+	float RebuildMsLastFrame;
+};
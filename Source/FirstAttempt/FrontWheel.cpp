@@ -1,12 +1,12 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-
-#include "FirstAttempt.h"
-#include "FrontWheel.h"
-
-UFrontWheel::UFrontWheel()
-{
-	ShapeRadius = 35.f;
-	ShapeWidth = 10.0f;
-	bAffectedByHandbrake = false;
-	SteerAngle = 50.f;
-}
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "FirstAttempt.h"
+#include "FrontWheel.h"
+
+UFrontWheel::UFrontWheel()
+{
+	ShapeRadius = 35.f;
+	ShapeWidth = 10.0f;
+	bAffectedByHandbrake = false;
+	SteerAngle = 50.f;
+}
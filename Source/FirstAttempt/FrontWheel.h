@@ -1,16 +1,16 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-#pragma once
-#include "VehicleWheel.h"
-#include "FrontWheel.generated.h"
-
-UCLASS()
-class UFrontWheel : public UVehicleWheel
-{
-	GENERATED_BODY()
-
-public:
-	UFrontWheel();
-};
-
-
-
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "VehicleWheel.h"
+#include "FrontWheel.generated.h"
+
+UCLASS()
+class UFrontWheel : public UVehicleWheel
+{
+	GENERATED_BODY()
+
+public:
+	UFrontWheel();
+};
+
+
+
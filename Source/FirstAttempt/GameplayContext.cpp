@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "GameplayContext.h"
+#include "FirstAttemptGameModeBase.h"
+#include "FirstAttemptStats.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Player Pawn Lookups"), STAT_PlayerPawnLookups, STATGROUP_FirstAttempt);
+
+FGameplayContext::FGameplayContext()
+	: GameMode(nullptr)
+	, bPlayerPawnValid(false)
+	, bPlayerPawnsValid(false)
+	, bCachePlayerPawn(true)
+	, CachedFrame(MAX_uint64)
+	, DeltaSeconds(0.f)
+	, TimeSeconds(0.f)
+{
+}
+
+APawn* FGameplayContext::GetPlayerPawn() const
+{
+	// A destroyed pawn doesn't always go through UnPossessed first, so check the cached one is still there
+	if (!bPlayerPawnValid || !bCachePlayerPawn || PlayerPawn.IsStale())
+	{
+		INC_DWORD_STAT(STAT_PlayerPawnLookups);
+		PlayerPawn = GameMode ? UGameplayStatics::GetPlayerPawn(GameMode, 0) : NULL;
+		bPlayerPawnValid = true;
+	}
+	return PlayerPawn.Get();
+}
+
+const TArray<APawn*>& FGameplayContext::GetPlayerPawns() const
+{
+	bool bStale = !bPlayerPawnsValid || !bCachePlayerPawn;
+	for (int32 i = 0; i < PlayerPawnRefs.Num() && !bStale; i++)
+	{
+		bStale = !PlayerPawnRefs[i].IsValid();
+	}
+	if (bStale)
+	{
+		INC_DWORD_STAT(STAT_PlayerPawnLookups);
+		PlayerPawns.Reset();
+		PlayerPawnRefs.Reset();
+		UWorld *World = GameMode ? GameMode->GetWorld() : NULL;
+		if (World)
+		{
+			for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+			{
+				APlayerController *PlayerController = It->Get();
+				APawn *Pawn = PlayerController ? PlayerController->GetPawn() : NULL;
+				if (Pawn)
+				{
+					PlayerPawns.Add(Pawn);
+					PlayerPawnRefs.Add(Pawn);
+				}
+			}
+		}
+		bPlayerPawnsValid = true;
+	}
+	return PlayerPawns;
+}
+
+bool FGameplayContext::IsPlayerPawn(const APawn* Pawn) const
+{
+	return Pawn != NULL && GetPlayerPawns().Contains(Pawn);
+}
+
+void FGameplayContext::InvalidatePlayerPawn()
+{
+	bPlayerPawnValid = false;
+	PlayerPawn.Reset();
+	bPlayerPawnsValid = false;
+}
+
+void FGameplayContext::UpdateFrame() const
+{
+	UWorld *World = GameMode ? GameMode->GetWorld() : NULL;
+	CachedFrame = GFrameCounter;
+	DeltaSeconds = World ? World->GetDeltaSeconds() : 0.f;
+	TimeSeconds = World ? World->GetTimeSeconds() : 0.f;
+}
+
+void FGameplayContextHandle::Bind(const UObject* WorldContextObject)
+{
+	UWorld *World = WorldContextObject ? WorldContextObject->GetWorld() : NULL;
+	AFirstAttemptGameModeBase *GameMode = World ? Cast<AFirstAttemptGameModeBase>(World->GetAuthGameMode()) : NULL;
+	Context = GameMode ? &GameMode->GetGameplayContext() : nullptr;
+}
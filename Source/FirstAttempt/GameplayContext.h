@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class AFirstAttemptGameModeBase;
+
+/**
+ * World state that gameplay code keeps asking for: the player pawns, the game mode and this frame's timing.
+ * One lives on each AFirstAttemptGameModeBase. The player pawns are looked up once and kept until a pawn is
+ * possessed or unpossessed by a player, and the timing is refreshed on first use each frame.
+ */
+struct FIRSTATTEMPT_API FGameplayContext
+{
+public:
+	FGameplayContext();
+
+	/** The pawn player 0 is controlling, or null */
+	APawn* GetPlayerPawn() const;
+
+	/** Every pawn a player is controlling, in player order. On a server with several clients that is one each */
+	const TArray<APawn*>& GetPlayerPawns() const;
+
+	/** Whether a player is controlling Pawn */
+	bool IsPlayerPawn(const APawn* Pawn) const;
+
+	/** Called by AFirstAttemptPlayerController when it possesses or unpossesses a pawn, so the next GetPlayerPawn or GetPlayerPawns looks them up again */
+	void InvalidatePlayerPawn();
+
+	/** With caching off every GetPlayerPawn looks the pawn up again, for measuring what the cache saves */
+	FORCEINLINE void SetPlayerPawnCaching(bool bEnabled) { bCachePlayerPawn = bEnabled; }
+
+	FORCEINLINE AFirstAttemptGameModeBase* GetGameMode() const { return GameMode; }
+
+	FORCEINLINE float GetDeltaSeconds() const { RefreshFrame(); return DeltaSeconds; }
+
+	FORCEINLINE float GetTimeSeconds() const { RefreshFrame(); return TimeSeconds; }
+
+private:
+	friend class AFirstAttemptGameModeBase;
+
+	/** Picks up this frame's timing the first time it is asked for in a frame */
+	FORCEINLINE void RefreshFrame() const
+	{
+		if (CachedFrame != GFrameCounter)
+		{
+			UpdateFrame();
+		}
+	}
+
+	void UpdateFrame() const;
+
+	AFirstAttemptGameModeBase *GameMode;
+
+	mutable TWeakObjectPtr<APawn> PlayerPawn;
+
+	mutable bool bPlayerPawnValid;
+
+	/** Every player's pawn, and the same again as weak pointers to notice one being destroyed without UnPossess */
+	mutable TArray<APawn*> PlayerPawns;
+	mutable TArray<TWeakObjectPtr<APawn>> PlayerPawnRefs;
+
+	mutable bool bPlayerPawnsValid;
+
+	bool bCachePlayerPawn;
+
+	mutable uint64 CachedFrame;
+
+	mutable float DeltaSeconds;
+
+	mutable float TimeSeconds;
+};
+
+/**
+ * What gameplay classes hold to reach the context of their world. Bind it once when the actor is set up,
+ * after that every access is a pointer dereference. Stays unbound in worlds run by another game mode.
+ */
+struct FIRSTATTEMPT_API FGameplayContextHandle
+{
+public:
+	FGameplayContextHandle()
+		: Context(nullptr)
+	{
+	}
+
+	/** Finds the context of WorldContextObject's world */
+	void Bind(const UObject* WorldContextObject);
+
+	FORCEINLINE bool IsValid() const { return Context != nullptr; }
+
+	FORCEINLINE FGameplayContext* operator->() const
+	{
+		check(Context);
+		return Context;
+	}
+
+private:
+	FGameplayContext *Context;
+};
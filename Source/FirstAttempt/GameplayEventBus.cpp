@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "GameplayEventBus.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Gameplay Event Drain"), STAT_GameplayEventDrain, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gameplay Events Per Frame"), STAT_GameplayEventsPerFrame, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gameplay Event Queue Depth"), STAT_GameplayEventQueueDepth, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gameplay Events Dropped"), STAT_GameplayEventsDropped, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Gameplay Events Overflowed"), STAT_GameplayEventsOverflowed, STATGROUP_FirstAttempt);
+
+AGameplayEventBus::AGameplayEventBus()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Drain after everything that can publish during the frame has ticked
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+	QueueCapacity = 1024;
+	EventsLastFrame = 0;
+}
+
+void AGameplayEventBus::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	// Blueprint defaults are in by now. Nothing can be publishing yet since nobody has been handed the bus
+	Queue.Reset(QueueCapacity);
+	Batch.Reserve(Queue.GetCapacity());
+}
+
+bool AGameplayEventBus::Publish(const FGameplayEvent& Event)
+{
+	if (Queue.Enqueue(Event))
+	{
+		return true;
+	}
+	// A lost PlayerKilled would mean the game never ends, so take the lock rather than lose it
+	if (IsCriticalGameplayEvent(Event.Type))
+	{
+		FScopeLock Lock(&OverflowLock);
+		Overflow.Add(Event);
+		NumOverflowed.Increment();
+		return true;
+	}
+	NumDropped.Increment();
+	return false;
+}
+
+void AGameplayEventBus::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_GameplayEventDrain);
+	Super::Tick(DeltaSeconds);
+
+	SET_DWORD_STAT(STAT_GameplayEventQueueDepth, Queue.Num());
+
+	Batch.Reset();
+	FGameplayEvent Event;
+	while (Queue.Dequeue(Event))
+	{
+		Batch.Add(Event);
+	}
+	// Overflowed events were published once the queue was full, so they go after everything in it
+	{
+		FScopeLock Lock(&OverflowLock);
+		Batch.Append(Overflow);
+		Overflow.Reset();
+	}
+	EventsLastFrame = Batch.Num();
+	SET_DWORD_STAT(STAT_GameplayEventsPerFrame, EventsLastFrame);
+	SET_DWORD_STAT(STAT_GameplayEventsDropped, NumDropped.GetValue());
+	SET_DWORD_STAT(STAT_GameplayEventsOverflowed, NumOverflowed.GetValue());
+
+	if (Batch.Num() > 0)
+	{
+		GameplayEventsDelegate.Broadcast(Batch);
+	}
+}
+
+int32 AGameplayEventBus::GetEventsLastFrame() const
+{
+	return EventsLastFrame;
+}
+
+int32 AGameplayEventBus::GetNumDropped() const
+{
+	return NumDropped.GetValue();
+}
+
+int32 AGameplayEventBus::GetNumOverflowed() const
+{
+	return NumOverflowed.GetValue();
+}
@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "GameplayEventBus.generated.h"
+
+/** What happened */
+UENUM(BlueprintType)
+enum class EGameplayEventType : uint8
+{
+	/** An enemy was knocked down for good. Victim is the enemy, Instigator whatever hit it */
+	EnemyKilled,
+	/** The player's character was knocked down, which ends the game */
+	PlayerKilled
+};
+
+/** Whether losing an event of this type would break the game, so it must never be dropped */
+inline bool IsCriticalGameplayEvent(EGameplayEventType Type)
+{
+	return Type == EGameplayEventType::EnemyKilled || Type == EGameplayEventType::PlayerKilled;
+}
+
+/** One gameplay event. Plain data so it can be published from any thread */
+struct FGameplayEvent
+{
+	EGameplayEventType Type;
+
+	TWeakObjectPtr<AActor> Victim;
+
+	TWeakObjectPtr<AActor> Instigator;
+
+	FVector Location;
+
+	FGameplayEvent()
+		: Type(EGameplayEventType::EnemyKilled)
+		, Location(FVector::ZeroVector)
+	{
+	}
+
+	FGameplayEvent(EGameplayEventType InType, AActor* InVictim, AActor* InInstigator)
+		: Type(InType)
+		, Victim(InVictim)
+		, Instigator(InInstigator)
+		, Location(InVictim ? InVictim->GetActorLocation() : FVector::ZeroVector)
+	{
+	}
+};
+
+/**
+ * Bounded multi producer, single consumer ring buffer. Any thread can Enqueue, only one thread may Dequeue.
+ * Each slot carries a sequence number so producers claim slots with one compare and swap and the consumer
+ * can tell a slot that has been claimed but not yet written from one that is ready.
+ */
+template<typename T>
+class TMpscRingBuffer
+{
+public:
+	explicit TMpscRingBuffer(int32 InCapacity = 1024)
+	{
+		Reset(InCapacity);
+	}
+
+	/** Resizes the buffer, rounding up to a power of two. Not thread safe, only call while nobody is publishing */
+	void Reset(int32 InCapacity)
+	{
+		const int32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(InCapacity, 2));
+		Slots.Reset();
+		Slots.SetNum(Capacity);
+		for (int32 i = 0; i < Capacity; i++)
+		{
+			Slots[i].Sequence = i;
+		}
+		Mask = Capacity - 1;
+		EnqueuePos = 0;
+		DequeuePos = 0;
+	}
+
+	/** Adds an item, returns false if the buffer is full */
+	bool Enqueue(const T& Item)
+	{
+		int32 Pos = EnqueuePos;
+		for (;;)
+		{
+			FSlot& Slot = Slots[Pos & Mask];
+			const int32 Sequence = Slot.Sequence;
+			FPlatformMisc::MemoryBarrier();
+			const int32 Diff = Sequence - Pos;
+			if (Diff == 0)
+			{
+				// The slot is free, try to claim it
+				const int32 Claimed = FPlatformAtomics::InterlockedCompareExchange(&EnqueuePos, Pos + 1, Pos);
+				if (Claimed == Pos)
+				{
+					Slot.Item = Item;
+					FPlatformMisc::MemoryBarrier();
+					Slot.Sequence = Pos + 1;
+					return true;
+				}
+				Pos = Claimed;
+			}
+			else if (Diff < 0)
+			{
+				// The consumer hasn't got to this slot since the last lap
+				return false;
+			}
+			else
+			{
+				// Another producer got here first
+				Pos = EnqueuePos;
+			}
+		}
+	}
+
+	/** Takes the oldest item, returns false if there is nothing ready. Consumer thread only */
+	bool Dequeue(T& OutItem)
+	{
+		FSlot& Slot = Slots[DequeuePos & Mask];
+		const int32 Sequence = Slot.Sequence;
+		FPlatformMisc::MemoryBarrier();
+		if (Sequence - (DequeuePos + 1) < 0)
+		{
+			return false;
+		}
+		OutItem = Slot.Item;
+		FPlatformMisc::MemoryBarrier();
+		// Hand the slot back to producers for the next lap
+		Slot.Sequence = DequeuePos + Mask + 1;
+		DequeuePos++;
+		return true;
+	}
+
+	/** Items claimed but not yet taken. Only a snapshot while producers are running */
+	int32 Num() const
+	{
+		return EnqueuePos - DequeuePos;
+	}
+
+	int32 GetCapacity() const
+	{
+		return Mask + 1;
+	}
+
+private:
+	struct FSlot
+	{
+		volatile int32 Sequence;
+		T Item;
+	};
+
+	TArray<FSlot> Slots;
+
+	int32 Mask;
+
+	/** Next position a producer will claim */
+	volatile int32 EnqueuePos;
+
+	/** Next position the consumer will read, only touched by the consumer */
+	int32 DequeuePos;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGameplayEvents, const TArray<FGameplayEvent>&);
+
+/**
+ * Carries kills and deaths from gameplay code to whatever cares about them, so the code that notices
+ * a death doesn't have to find and call the score, corpse and HUD code itself. Publish can be called from
+ * any thread. Once a frame the bus drains everything published so far and hands it to every consumer in
+ * one batch, on the game thread. When the queue is full, critical events such as PlayerKilled go to a locked
+ * overflow list drained with the queue instead of being dropped; anything else is dropped and counted.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AGameplayEventBus : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AGameplayEventBus();
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Queues an event for the next drain. Safe from any thread. Returns false if the queue was full and it was dropped */
+	bool Publish(const FGameplayEvent& Event);
+
+	/** Consumers bind here to get each frame's events in one batch */
+	FOnGameplayEvents& OnGameplayEvents() { return GameplayEventsDelegate; }
+
+	/** Most events that can wait between drains before new ones are dropped */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Events")
+	int32 QueueCapacity;
+
+	/** Events handed to consumers in the last drain */
+	UFUNCTION(BlueprintPure, Category = "Events")
+	int32 GetEventsLastFrame() const;
+
+	/** Events dropped because the queue was full */
+	UFUNCTION(BlueprintPure, Category = "Events")
+	int32 GetNumDropped() const;
+
+	/** Critical events that found the queue full and went to the overflow list instead */
+	UFUNCTION(BlueprintPure, Category = "Events")
+	int32 GetNumOverflowed() const;
+
+private:
+	TMpscRingBuffer<FGameplayEvent> Queue;
+
+	FOnGameplayEvents GameplayEventsDelegate;
+
+	/** Reused every drain */
+	TArray<FGameplayEvent> Batch;
+
+	int32 EventsLastFrame;
+
+	FThreadSafeCounter NumDropped;
+
+	/** Critical events published while the queue was full, in the order they came */
+	TArray<FGameplayEvent> Overflow;
+
+	FCriticalSection OverflowLock;
+
+	FThreadSafeCounter NumOverflowed;
+};
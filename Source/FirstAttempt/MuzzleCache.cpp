@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "MuzzleCache.h"
+#include "FirstAttemptGameModeBase.h"
+#include "FireScheduler.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Muzzle Cache Update"), STAT_MuzzleCacheUpdate, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Muzzle Shooters"), STAT_MuzzleShooters, STATGROUP_FirstAttempt);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Muzzle Bone Reads"), STAT_MuzzleReads, STATGROUP_FirstAttempt);
+
+AMuzzleCache::AMuzzleCache()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Bone transforms are final once animation has finished for the frame
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+	MuzzleBoneName = FName(TEXT("hand_l"));
+}
+
+int32 AMuzzleCache::AddShooter(USkeletalMeshComponent* Mesh)
+{
+	int32 Slot;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(false);
+	}
+	else
+	{
+		Slot = Slots.AddDefaulted();
+		MuzzleLocations.AddZeroed();
+	}
+	FMuzzleSlot& MuzzleSlot = Slots[Slot];
+	MuzzleSlot.Mesh = Mesh;
+	MuzzleSlot.bInUse = true;
+	MuzzleSlot.bHasLocation = false;
+	MuzzleSlot.ReadFrame = 0;
+	ResolveBone(MuzzleSlot);
+	SET_DWORD_STAT(STAT_MuzzleShooters, GetNumShooters());
+	return Slot;
+}
+
+void AMuzzleCache::RemoveShooter(int32 Slot)
+{
+	if (Slots.IsValidIndex(Slot) && Slots[Slot].bInUse)
+	{
+		Slots[Slot].bInUse = false;
+		Slots[Slot].bHasLocation = false;
+		Slots[Slot].Mesh.Reset();
+		FreeSlots.Add(Slot);
+		SET_DWORD_STAT(STAT_MuzzleShooters, GetNumShooters());
+	}
+}
+
+void AMuzzleCache::ResolveBone(FMuzzleSlot& MuzzleSlot) const
+{
+	USkeletalMeshComponent *Mesh = MuzzleSlot.Mesh.Get();
+	MuzzleSlot.ResolvedFor = Mesh ? Mesh->SkeletalMesh : NULL;
+	MuzzleSlot.BoneIndex = Mesh ? Mesh->GetBoneIndex(MuzzleBoneName) : INDEX_NONE;
+}
+
+void AMuzzleCache::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AMuzzleCache::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_MuzzleCacheUpdate);
+	Super::Tick(DeltaSeconds);
+
+	// Only shooters firing next frame need their muzzle, which at a few shots a second is a small part of them.
+	// Next frame is taken to be up to twice as long as this one, a shot that still comes early reads the bone itself
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	AFireScheduler *FireScheduler = GameMode ? GameMode->GetFireScheduler() : NULL;
+	if (FireScheduler == NULL)
+	{
+		for (int32 Slot = 0; Slot < Slots.Num(); Slot++)
+		{
+			UpdateSlot(Slot);
+		}
+		return;
+	}
+	DueShooters.Reset();
+	FireScheduler->GetShootersDueBy(GetWorld()->GetTimeSeconds() + DeltaSeconds * 2.f, DueShooters);
+	for (AThirdPersonCharacter *Shooter : DueShooters)
+	{
+		UpdateSlot(Shooter->GetMuzzleSlot());
+	}
+	INC_DWORD_STAT_BY(STAT_MuzzleReads, DueShooters.Num());
+}
+
+void AMuzzleCache::UpdateSlot(int32 Slot)
+{
+	if (!Slots.IsValidIndex(Slot) || !Slots[Slot].bInUse)
+	{
+		return;
+	}
+	FMuzzleSlot& MuzzleSlot = Slots[Slot];
+	USkeletalMeshComponent *Mesh = MuzzleSlot.Mesh.Get();
+	if (Mesh == NULL)
+	{
+		MuzzleSlot.bHasLocation = false;
+		return;
+	}
+	if (MuzzleSlot.ResolvedFor.Get() != Mesh->SkeletalMesh)
+	{
+		ResolveBone(MuzzleSlot);
+	}
+	if (MuzzleSlot.BoneIndex != INDEX_NONE)
+	{
+		MuzzleLocations[Slot] = Mesh->GetBoneTransform(MuzzleSlot.BoneIndex).GetLocation();
+		MuzzleSlot.ReadFrame = GFrameCounter;
+		MuzzleSlot.bHasLocation = true;
+	}
+}
+
+bool AMuzzleCache::GetMuzzleLocation(int32 Slot, FVector& OutLocation) const
+{
+	// Anything older than last frame's read is a pose out of date
+	if (Slots.IsValidIndex(Slot) && Slots[Slot].bHasLocation && Slots[Slot].ReadFrame + 1 >= GFrameCounter)
+	{
+		OutLocation = MuzzleLocations[Slot];
+		return true;
+	}
+	return false;
+}
+
+int32 AMuzzleCache::GetNumShooters() const
+{
+	return Slots.Num() - FreeSlots.Num();
+}
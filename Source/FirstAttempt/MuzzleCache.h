@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "GameplayContext.h"
+#include "MuzzleCache.generated.h"
+
+/**
+ * Keeps the muzzle position of every character that is shooting, so firing doesn't have to look a bone up
+ * by name on each shot. Shooters take a slot while they shoot. The bone index is resolved once per slot, and
+ * once animation is done the positions of the shooters the fire scheduler has a shot due for by next frame
+ * are read in one pass into a contiguous array. Shots see the pose from the end of the previous frame.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AMuzzleCache : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AMuzzleCache();
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Starts tracking the muzzle bone on Mesh and returns the slot to read it from */
+	int32 AddShooter(USkeletalMeshComponent* Mesh);
+
+	/** Stops tracking a slot returned by AddShooter */
+	void RemoveShooter(int32 Slot);
+
+	/** World position of the muzzle in Slot, read at the end of the last frame. False if it wasn't read then */
+	bool GetMuzzleLocation(int32 Slot, FVector& OutLocation) const;
+
+	/** Slots in use */
+	UFUNCTION(BlueprintPure, Category = "Shooting")
+	int32 GetNumShooters() const;
+
+	/** Bone shots come from */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Shooting")
+	FName MuzzleBoneName;
+
+private:
+	struct FMuzzleSlot
+	{
+		TWeakObjectPtr<USkeletalMeshComponent> Mesh;
+		/** Mesh asset BoneIndex was resolved against, so a mesh swap resolves it again */
+		TWeakObjectPtr<USkeletalMesh> ResolvedFor;
+		int32 BoneIndex;
+		/** GFrameCounter when the location was last read */
+		uint64 ReadFrame;
+		bool bInUse;
+		bool bHasLocation;
+	};
+
+	/** Finds the muzzle bone on the slot's current mesh */
+	void ResolveBone(FMuzzleSlot& MuzzleSlot) const;
+
+	/** Reads the muzzle position of one slot */
+	void UpdateSlot(int32 Slot);
+
+	TArray<FMuzzleSlot> Slots;
+
+	/** One entry per slot, filled by Tick */
+	TArray<FVector> MuzzleLocations;
+
+	/** Slots given back by RemoveShooter, reused before the arrays grow */
+	TArray<int32> FreeSlots;
+
+	/** Where the game mode and its managers are reached from, bound once instead of a cast per call */
+	FGameplayContextHandle GameplayContext;
+
+	/** Scratch list of shooters due to fire */
+	TArray<class AThirdPersonCharacter*> DueShooters;
+};
@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "PathRequestManager.h"
+#include "AI/Navigation/NavigationSystem.h"
+#include "EnemyController.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Path Request Manager Tick"), STAT_PathRequestTick, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Requests Queued"), STAT_PathRequestsQueued, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Requests In Flight"), STAT_PathRequestsInFlight, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Requests Dispatched"), STAT_PathRequestsDispatched, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Requests Completed"), STAT_PathRequestsCompleted, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Paths Reused"), STAT_PathsReused, STATGROUP_FirstAttempt);
+
+APathRequestManager::APathRequestManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	MaxQueriesPerFrame = 4;
+	MaxQueriesInFlight = 16;
+	ShareCellSize = 400.f;
+	PathCacheLifetime = 0.5f;
+	DispatchedLastFrame = 0;
+	NumCompleted = 0;
+	NumReused = 0;
+	CompletedLastFrame = 0;
+	ReusedLastFrame = 0;
+}
+
+APathRequestManager::FPathKey APathRequestManager::GetKey(const FVector& Start, const FVector& Goal) const
+{
+	FPathKey Key;
+	Key.StartCell = FIntVector(FMath::FloorToInt(Start.X / ShareCellSize), FMath::FloorToInt(Start.Y / ShareCellSize), FMath::FloorToInt(Start.Z / ShareCellSize));
+	Key.GoalCell = FIntVector(FMath::FloorToInt(Goal.X / ShareCellSize), FMath::FloorToInt(Goal.Y / ShareCellSize), FMath::FloorToInt(Goal.Z / ShareCellSize));
+	return Key;
+}
+
+void APathRequestManager::RequestPath(AEnemyController* Controller, const FVector& Goal)
+{
+	APawn *Pawn = Controller ? Controller->GetPawn() : NULL;
+	if (Pawn == NULL)
+	{
+		return;
+	}
+	CancelRequest(Controller);
+
+	const FVector Start = Pawn->GetNavAgentLocation();
+	const FPathKey Key = GetKey(Start, Goal);
+
+	// Someone from the same spot asked for the same place a moment ago
+	const FCachedPath *Cached = Cache.Find(Key);
+	if (Cached && GetWorld()->GetTimeSeconds() - Cached->Time <= PathCacheLifetime)
+	{
+		NumReused++;
+		Controller->OnPathReady(Cached->Points, true);
+		return;
+	}
+
+	// Or is still waiting for it
+	Pending.Add(Controller, Key);
+	FPathRequest *Request = Requests.Find(Key);
+	if (Request)
+	{
+		NumReused++;
+		Request->Waiters.Add(Controller);
+		return;
+	}
+
+	FPathRequest NewRequest;
+	NewRequest.Start = Start;
+	NewRequest.Goal = Goal;
+	NewRequest.Waiters.Add(Controller);
+	NewRequest.QueryId = 0;
+	Requests.Add(Key, NewRequest);
+	Queue.Add(Key);
+}
+
+void APathRequestManager::CancelRequest(AEnemyController* Controller)
+{
+	// Requests nobody is waiting for any more are dropped when they come up for dispatch or come back
+	FPathKey Key;
+	if (Pending.RemoveAndCopyValue(Controller, Key))
+	{
+		FPathRequest *Request = Requests.Find(Key);
+		if (Request)
+		{
+			Request->Waiters.RemoveSwap(Controller);
+		}
+	}
+}
+
+void APathRequestManager::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_PathRequestTick);
+	Super::Tick(DeltaSeconds);
+
+	PruneCache(GetWorld()->GetTimeSeconds());
+	DispatchQueries();
+
+	CompletedLastFrame = NumCompleted;
+	ReusedLastFrame = NumReused;
+	NumCompleted = 0;
+	NumReused = 0;
+	UpdateStats();
+}
+
+void APathRequestManager::DispatchQueries()
+{
+	DispatchedLastFrame = 0;
+	UNavigationSystem *NavSys = UNavigationSystem::GetCurrent<UNavigationSystem>(GetWorld());
+	if (NavSys == NULL || Queue.Num() == 0)
+	{
+		return;
+	}
+
+	int32 NumHandled = 0;
+	while (NumHandled < Queue.Num() && DispatchedLastFrame < MaxQueriesPerFrame && InFlight.Num() < MaxQueriesInFlight)
+	{
+		const FPathKey Key = Queue[NumHandled];
+		NumHandled++;
+		FPathRequest *Request = Requests.Find(Key);
+		if (Request == NULL)
+		{
+			continue;
+		}
+		Request->Waiters.RemoveAll([this](const TWeakObjectPtr<AEnemyController>& Waiter)
+		{
+			if (Waiter.IsValid())
+			{
+				return false;
+			}
+			Pending.Remove(Waiter);
+			return true;
+		});
+		if (Request->Waiters.Num() == 0)
+		{
+			Requests.Remove(Key);
+			continue;
+		}
+
+		// Every enemy is the same size, so the first waiter's agent and nav data do for all of them
+		AEnemyController *Controller = Request->Waiters[0].Get();
+		const FNavAgentProperties& AgentProperties = Controller->GetNavAgentPropertiesRef();
+		const ANavigationData *NavData = NavSys->GetNavDataForProps(AgentProperties);
+		if (NavData == NULL)
+		{
+			const TArray<TWeakObjectPtr<AEnemyController>> Waiters = MoveTemp(Request->Waiters);
+			Requests.Remove(Key);
+			Deliver(Waiters, TArray<FVector>(), false);
+			continue;
+		}
+		FPathFindingQuery Query(Controller, *NavData, Request->Start, Request->Goal, UNavigationQueryFilter::GetQueryFilter(*NavData, Controller, Controller->GetDefaultNavigationFilterClass()));
+		Request->QueryId = NavSys->FindPathAsync(AgentProperties, Query, FNavPathQueryDelegate::CreateUObject(this, &APathRequestManager::OnPathQueryFinished));
+		InFlight.Add(Request->QueryId, Key);
+		DispatchedLastFrame++;
+	}
+	Queue.RemoveAt(0, NumHandled);
+}
+
+void APathRequestManager::OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FPathKey Key;
+	if (!InFlight.RemoveAndCopyValue(QueryId, Key))
+	{
+		return;
+	}
+	FPathRequest Request;
+	if (!Requests.RemoveAndCopyValue(Key, Request))
+	{
+		return;
+	}
+	NumCompleted++;
+
+	const bool bSuccess = Result == ENavigationQueryResult::Success && Path.IsValid();
+	TArray<FVector> Points;
+	if (bSuccess)
+	{
+		const TArray<FNavPathPoint>& PathPoints = Path->GetPathPoints();
+		Points.Reserve(PathPoints.Num());
+		for (const FNavPathPoint& PathPoint : PathPoints)
+		{
+			Points.Add(PathPoint.Location);
+		}
+		FCachedPath& Cached = Cache.FindOrAdd(Key);
+		Cached.Points = Points;
+		Cached.Time = GetWorld()->GetTimeSeconds();
+	}
+	Deliver(Request.Waiters, Points, bSuccess);
+}
+
+void APathRequestManager::Deliver(const TArray<TWeakObjectPtr<AEnemyController>>& Waiters, const TArray<FVector>& Points, bool bSuccess)
+{
+	// Nobody is waiting any more once they have their answer, and OnPathReady may put them back in
+	for (const TWeakObjectPtr<AEnemyController>& Waiter : Waiters)
+	{
+		Pending.Remove(Waiter);
+	}
+	for (const TWeakObjectPtr<AEnemyController>& Waiter : Waiters)
+	{
+		AEnemyController *Controller = Waiter.Get();
+		if (Controller)
+		{
+			Controller->OnPathReady(Points, bSuccess);
+		}
+	}
+}
+
+void APathRequestManager::PruneCache(float TimeSeconds)
+{
+	for (auto It = Cache.CreateIterator(); It; ++It)
+	{
+		if (TimeSeconds - It.Value().Time > PathCacheLifetime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+int32 APathRequestManager::GetQueueDepth() const
+{
+	return Queue.Num();
+}
+
+int32 APathRequestManager::GetRequestsDispatchedLastFrame() const
+{
+	return DispatchedLastFrame;
+}
+
+int32 APathRequestManager::GetRequestsCompletedLastFrame() const
+{
+	return CompletedLastFrame;
+}
+
+int32 APathRequestManager::GetPathsReusedLastFrame() const
+{
+	return ReusedLastFrame;
+}
+
+void APathRequestManager::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_PathRequestsQueued, Queue.Num());
+	SET_DWORD_STAT(STAT_PathRequestsInFlight, InFlight.Num());
+	SET_DWORD_STAT(STAT_PathRequestsDispatched, DispatchedLastFrame);
+	SET_DWORD_STAT(STAT_PathRequestsCompleted, CompletedLastFrame);
+	SET_DWORD_STAT(STAT_PathsReused, ReusedLastFrame);
+}
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "PathRequestManager.generated.h"
+
+class AEnemyController;
+
+/**
+ * Finds paths for every enemy controller through one queue instead of each calling MoveToActor. Requests are
+ * handed to the navigation system's async pathfinding a few per frame, with a cap on how many are out at once.
+ * Requests that start and end in the same cells share one query, and a finished path is kept for a moment so
+ * enemies bunched up behind the same target reuse it instead of asking again.
+ */
+UCLASS()
+class FIRSTATTEMPT_API APathRequestManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	APathRequestManager();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Asks for a path from the controller's pawn to Goal. The controller's OnPathReady is called with the result, maybe straight away */
+	void RequestPath(AEnemyController* Controller, const FVector& Goal);
+
+	/** Forgets any path the controller is waiting for */
+	void CancelRequest(AEnemyController* Controller);
+
+	/** Requests waiting to be handed to the navigation system */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	int32 GetQueueDepth() const;
+
+	/** Queries handed to the navigation system during the last tick */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	int32 GetRequestsDispatchedLastFrame() const;
+
+	/** Queries that came back since the tick before last */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	int32 GetRequestsCompletedLastFrame() const;
+
+	/** Requests answered from a cached or shared query since the tick before last */
+	UFUNCTION(BlueprintPure, Category = "AI")
+	int32 GetPathsReusedLastFrame() const;
+
+	/** Most queries handed to the navigation system in one frame */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	int32 MaxQueriesPerFrame;
+
+	/** Most queries the navigation system may be working on at once */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	int32 MaxQueriesInFlight;
+
+	/** Requests starting in the same cell and ending in the same cell share a path */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float ShareCellSize;
+
+	/** How long a finished path is handed out again, in seconds */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
+	float PathCacheLifetime;
+
+private:
+	struct FPathKey
+	{
+		FIntVector StartCell;
+		FIntVector GoalCell;
+
+		bool operator==(const FPathKey& Other) const
+		{
+			return StartCell == Other.StartCell && GoalCell == Other.GoalCell;
+		}
+
+		friend uint32 GetTypeHash(const FPathKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.StartCell), GetTypeHash(Key.GoalCell));
+		}
+	};
+
+	/** One query and everyone waiting for it */
+	struct FPathRequest
+	{
+		FVector Start;
+		FVector Goal;
+		TArray<TWeakObjectPtr<AEnemyController>> Waiters;
+		/** Navigation system query, 0 while still queued */
+		uint32 QueryId;
+	};
+
+	struct FCachedPath
+	{
+		TArray<FVector> Points;
+		float Time;
+	};
+
+	FPathKey GetKey(const FVector& Start, const FVector& Goal) const;
+
+	/** Hands queued requests to the navigation system until the frame or in flight limit is reached */
+	void DispatchQueries();
+
+	void OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/** Calls OnPathReady on everyone waiting. The request must be out of Requests first, they may ask again from inside it */
+	void Deliver(const TArray<TWeakObjectPtr<AEnemyController>>& Waiters, const TArray<FVector>& Points, bool bSuccess);
+
+	/** Drops cached paths older than PathCacheLifetime */
+	void PruneCache(float TimeSeconds);
+
+	void UpdateStats() const;
+
+	/** Every request that is queued or in flight */
+	TMap<FPathKey, FPathRequest> Requests;
+
+	/** The request each waiting controller is in, so cancelling doesn't look through every request */
+	TMap<TWeakObjectPtr<AEnemyController>, FPathKey> Pending;
+
+	/** Requests not handed out yet, oldest first */
+	TArray<FPathKey> Queue;
+
+	/** Requests the navigation system is working on, by query */
+	TMap<uint32, FPathKey> InFlight;
+
+	TMap<FPathKey, FCachedPath> Cache;
+
+	int32 DispatchedLastFrame;
+
+	/** Counted as results and reuses come in, moved to the LastFrame counts each tick */
+	int32 NumCompleted;
+	int32 NumReused;
+
+	int32 CompletedLastFrame;
+	int32 ReusedLastFrame;
+};
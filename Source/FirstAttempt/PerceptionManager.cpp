@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "PerceptionManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Perception Tick"), STAT_PerceptionTick, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Perception Traces"), STAT_PerceptionTraces, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Perceivers"), STAT_Perceivers, STATGROUP_FirstAttempt);
+
+static const FName PerceptionTraceTag(TEXT("PerceptionTrace"));
+
+APerceptionManager::APerceptionManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Same defaults UPawnSensingComponent used, with the 90 degree angle the characters set
+	SightRadius = 5000.f;
+	PeripheralVisionAngle = 90.f;
+	SensingInterval = 0.5f;
+	MaxTracesPerFrame = 16;
+	CacheFrames = 10;
+	CellSize = 2500.f;
+	TracesLastFrame = 0;
+}
+
+void APerceptionManager::AddPerceiver(AThirdPersonCharacter* Character)
+{
+	if (Character == NULL)
+	{
+		return;
+	}
+	RemovePerceiver(Character);
+	FPerceiver Perceiver;
+	Perceiver.Character = Character;
+	Perceiver.LastTraceFrame = 0;
+	Perceiver.LastNotifyTime = -SensingInterval;
+	Perceiver.bCanSee = false;
+	Perceivers.Add(Perceiver);
+}
+
+void APerceptionManager::RemovePerceiver(AThirdPersonCharacter* Character)
+{
+	Perceivers.RemoveAllSwap([Character](const FPerceiver& Perceiver) { return Perceiver.Character == Character; });
+}
+
+FIntPoint APerceptionManager::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void APerceptionManager::RebuildGrid()
+{
+	// Keep the per cell arrays around between frames so rebuilding doesn't allocate
+	for (TPair<FIntPoint, TArray<int32>>& Cell : Grid)
+	{
+		Cell.Value.Reset();
+	}
+	for (int32 i = Perceivers.Num() - 1; i >= 0; i--)
+	{
+		const AThirdPersonCharacter *Character = Perceivers[i].Character.Get();
+		if (Character == NULL)
+		{
+			Perceivers.RemoveAtSwap(i);
+		}
+	}
+	for (int32 i = 0; i < Perceivers.Num(); i++)
+	{
+		Grid.FindOrAdd(GetCell(Perceivers[i].Character->GetActorLocation())).Add(i);
+	}
+}
+
+void APerceptionManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void APerceptionManager::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_PerceptionTick);
+	Super::Tick(DeltaSeconds);
+
+	TracesLastFrame = 0;
+	RebuildGrid();
+
+	TArray<APawn*, TInlineAllocator<4>> PlayerPawns;
+	if (GameplayContext.IsValid())
+	{
+		PlayerPawns.Append(GameplayContext->GetPlayerPawns());
+	}
+	else if (APawn *PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0))
+	{
+		PlayerPawns.Add(PlayerPawn);
+	}
+	if (PlayerPawns.Num() == 0 || Perceivers.Num() == 0)
+	{
+		SET_DWORD_STAT(STAT_PerceptionTraces, 0);
+		SET_DWORD_STAT(STAT_Perceivers, Perceivers.Num());
+		return;
+	}
+
+	UWorld *World = GetWorld();
+	const float TimeSeconds = World->GetTimeSeconds();
+	const float SightRadiusSq = FMath::Square(SightRadius);
+	const float PeripheralVisionCosine = FMath::Cos(FMath::DegreesToRadians(PeripheralVisionAngle));
+
+	InView.Reset();
+	TraceCandidates.Reset();
+	Visited.Init(false, Perceivers.Num());
+	for (const APawn *PlayerPawn : PlayerPawns)
+	{
+		// Only cells that overlap the sight radius around a player can hold anyone who sees them
+		const FVector PlayerLocation = PlayerPawn->GetActorLocation();
+		const FIntPoint MinCell = GetCell(PlayerLocation - FVector(SightRadius, SightRadius, 0.f));
+		const FIntPoint MaxCell = GetCell(PlayerLocation + FVector(SightRadius, SightRadius, 0.f));
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				const TArray<int32> *Cell = Grid.Find(FIntPoint(X, Y));
+				if (Cell == NULL)
+				{
+					continue;
+				}
+				for (int32 Index : *Cell)
+				{
+					if (Visited[Index])
+					{
+						continue;
+					}
+					Visited[Index] = true;
+					FPerceiver& Perceiver = Perceivers[Index];
+					const AThirdPersonCharacter *Character = Perceiver.Character.Get();
+					if (PlayerPawns.Contains(Character) || Character->GetIsDead())
+					{
+						continue;
+					}
+
+					// Watch the nearest player in the view cone
+					const FVector Location = Character->GetActorLocation();
+					const FVector Forward = Character->GetActorForwardVector();
+					APawn *Target = NULL;
+					float TargetDistanceSq = SightRadiusSq;
+					for (APawn *Candidate : PlayerPawns)
+					{
+						const FVector ToPlayer = Candidate->GetActorLocation() - Location;
+						const float DistanceSq = ToPlayer.SizeSquared();
+						if (DistanceSq <= TargetDistanceSq && FVector::DotProduct(ToPlayer.GetSafeNormal(), Forward) >= PeripheralVisionCosine)
+						{
+							Target = Candidate;
+							TargetDistanceSq = DistanceSq;
+						}
+					}
+					if (Target == NULL)
+					{
+						Perceiver.bCanSee = false;
+						continue;
+					}
+					// A trace against someone else says nothing about this one
+					if (Perceiver.Target != Target)
+					{
+						Perceiver.Target = Target;
+						Perceiver.bCanSee = false;
+						Perceiver.LastTraceFrame = 0;
+					}
+					InView.Add(Index);
+					if (GFrameCounter - Perceiver.LastTraceFrame >= (uint64)CacheFrames)
+					{
+						TraceCandidates.Add(Index);
+					}
+				}
+			}
+		}
+	}
+
+	// Spend the trace budget on whoever has gone longest without one
+	TraceCandidates.Sort([this](int32 A, int32 B) { return Perceivers[A].LastTraceFrame < Perceivers[B].LastTraceFrame; });
+	FCollisionQueryParams QueryParams(PerceptionTraceTag, true);
+	for (int32 i = 0; i < TraceCandidates.Num() && TracesLastFrame < MaxTracesPerFrame; i++)
+	{
+		FPerceiver& Perceiver = Perceivers[TraceCandidates[i]];
+		AThirdPersonCharacter *Character = Perceiver.Character.Get();
+		APawn *Target = Perceiver.Target.Get();
+		QueryParams.ClearIgnoredActors();
+		QueryParams.AddIgnoredActor(Target);
+		QueryParams.AddIgnoredActor(Character);
+		Perceiver.bCanSee = !World->LineTraceTestByChannel(Character->GetPawnViewLocation(), Target->GetPawnViewLocation(), ECC_Visibility, QueryParams);
+		Perceiver.LastTraceFrame = GFrameCounter;
+		TracesLastFrame++;
+	}
+
+	for (int32 Index : InView)
+	{
+		FPerceiver& Perceiver = Perceivers[Index];
+		if (Perceiver.bCanSee && TimeSeconds - Perceiver.LastNotifyTime >= SensingInterval)
+		{
+			Perceiver.LastNotifyTime = TimeSeconds;
+			Perceiver.Character->OnSeePlayer(Perceiver.Target.Get());
+		}
+	}
+
+	SET_DWORD_STAT(STAT_PerceptionTraces, TracesLastFrame);
+	SET_DWORD_STAT(STAT_Perceivers, Perceivers.Num());
+}
+
+int32 APerceptionManager::GetTracesLastFrame() const
+{
+	return TracesLastFrame;
+}
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "GameplayContext.h"
+#include "PerceptionManager.generated.h"
+
+class AThirdPersonCharacter;
+
+/**
+ * Does the sight checks for every character in one place instead of a UPawnSensingComponent on each.
+ * Characters are bucketed into a grid each tick so only the ones near a player are looked at, line of
+ * sight traces are limited per frame and results are reused for a few frames.
+ * Each character watches the nearest player in its view cone, and gets OnSeePlayer called with them while
+ * they can be seen, the same as PawnSensing's OnSeePawn.
+ */
+UCLASS()
+class FIRSTATTEMPT_API APerceptionManager : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	APerceptionManager();
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Starts checking whether this character can see the player */
+	void AddPerceiver(AThirdPersonCharacter* Character);
+
+	/** Stops checking this character */
+	void RemovePerceiver(AThirdPersonCharacter* Character);
+
+	/** Line of sight traces done last tick */
+	UFUNCTION(BlueprintPure, Category = "Perception")
+	int32 GetTracesLastFrame() const;
+
+	/** How far characters can see */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Perception")
+	float SightRadius;
+
+	/** Half angle of the view cone in degrees, matching UPawnSensingComponent::PeripheralVisionAngle */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Perception")
+	float PeripheralVisionAngle;
+
+	/** How often a character that can see the player is told about it, in seconds */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Perception")
+	float SensingInterval;
+
+	/** Most line of sight traces done in one frame */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Perception")
+	int32 MaxTracesPerFrame;
+
+	/** A line of sight result is reused for this many frames before it is traced again */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Perception")
+	int32 CacheFrames;
+
+	/** Size of a grid cell, should be around SightRadius or smaller */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Perception")
+	float CellSize;
+
+private:
+	/** Where the player pawns are cached between possessions */
+	FGameplayContextHandle GameplayContext;
+
+	struct FPerceiver
+	{
+		TWeakObjectPtr<AThirdPersonCharacter> Character;
+		/** The player the last trace was against */
+		TWeakObjectPtr<APawn> Target;
+		uint64 LastTraceFrame;
+		float LastNotifyTime;
+		bool bCanSee;
+	};
+
+	/** Buckets every perceiver into the grid by location */
+	void RebuildGrid();
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	TArray<FPerceiver> Perceivers;
+
+	/** Indices into Perceivers for each occupied cell */
+	TMap<FIntPoint, TArray<int32>> Grid;
+
+	/** Scratch list of perceivers that have a player in their view cone this tick */
+	TArray<int32> InView;
+
+	/** Scratch flags for perceivers already looked at this tick, players close together share cells */
+	TBitArray<> Visited;
+
+	/** Scratch list of perceivers waiting for a fresh trace */
+	TArray<int32> TraceCandidates;
+
+	int32 TracesLastFrame;
+};
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "PossessableRegistry.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Possessable Registry Tick"), STAT_PossessableRegistryTick, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("SwitchPawns"), STAT_SwitchPawns, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Possessable Pawns"), STAT_PossessablePawns, STATGROUP_FirstAttempt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Possess Switches Per Second"), STAT_PossessSwitchesPerSecond, STATGROUP_FirstAttempt);
+
+APossessableRegistry::APossessableRegistry()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Keep cells current before anyone presses SwitchPawns during the frame
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+	HandoffRadius = 100.f;
+	CellSize = 1000.f;
+	NumSwitches = 0;
+	SwitchesInWindow = 0;
+	SwitchWindowTime = 0.f;
+	SwitchesPerSecond = 0.f;
+}
+
+FIntPoint APossessableRegistry::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void APossessableRegistry::AddToCell(const FIntPoint& Cell, int32 Index)
+{
+	Grid.FindOrAdd(Cell).Add(Index);
+}
+
+void APossessableRegistry::RemoveFromCell(const FIntPoint& Cell, int32 Index)
+{
+	TArray<int32> *CellEntries = Grid.Find(Cell);
+	if (CellEntries)
+	{
+		CellEntries->RemoveSingleSwap(Index, false);
+		if (CellEntries->Num() == 0)
+		{
+			Grid.Remove(Cell);
+		}
+	}
+}
+
+void APossessableRegistry::AddPossessable(APawn* Pawn)
+{
+	if (Pawn == NULL)
+	{
+		return;
+	}
+	RemovePossessable(Pawn);
+	FPossessable Possessable;
+	Possessable.Pawn = Pawn;
+	Possessable.Cell = GetCell(Pawn->GetActorLocation());
+	const int32 Index = Possessables.Add(Possessable);
+	AddToCell(Possessable.Cell, Index);
+	SET_DWORD_STAT(STAT_PossessablePawns, Possessables.Num());
+}
+
+void APossessableRegistry::RemovePossessable(APawn* Pawn)
+{
+	for (int32 i = Possessables.Num() - 1; i >= 0; i--)
+	{
+		if (Possessables[i].Pawn == Pawn)
+		{
+			RemoveAt(i);
+		}
+	}
+	SET_DWORD_STAT(STAT_PossessablePawns, Possessables.Num());
+}
+
+void APossessableRegistry::RemoveAt(int32 Index)
+{
+	RemoveFromCell(Possessables[Index].Cell, Index);
+	const int32 LastIndex = Possessables.Num() - 1;
+	if (Index != LastIndex)
+	{
+		// The last entry is about to be swapped into Index, so repoint its cell at the new slot
+		TArray<int32> *CellEntries = Grid.Find(Possessables[LastIndex].Cell);
+		if (CellEntries)
+		{
+			const int32 Slot = CellEntries->Find(LastIndex);
+			if (Slot != INDEX_NONE)
+			{
+				(*CellEntries)[Slot] = Index;
+			}
+		}
+	}
+	Possessables.RemoveAtSwap(Index);
+}
+
+void APossessableRegistry::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_PossessableRegistryTick);
+	Super::Tick(DeltaSeconds);
+
+	// Most pawns stay in the same cell from frame to frame, so this is mostly a location read and a compare
+	for (int32 i = Possessables.Num() - 1; i >= 0; i--)
+	{
+		FPossessable& Possessable = Possessables[i];
+		const APawn *Pawn = Possessable.Pawn.Get();
+		if (Pawn == NULL)
+		{
+			RemoveAt(i);
+			continue;
+		}
+		const FIntPoint Cell = GetCell(Pawn->GetActorLocation());
+		if (Cell != Possessable.Cell)
+		{
+			RemoveFromCell(Possessable.Cell, i);
+			Possessable.Cell = Cell;
+			AddToCell(Cell, i);
+		}
+	}
+	SET_DWORD_STAT(STAT_PossessablePawns, Possessables.Num());
+
+	// Switches per second over the last whole second
+	SwitchWindowTime += DeltaSeconds;
+	if (SwitchWindowTime >= 1.f)
+	{
+		SwitchesPerSecond = SwitchesInWindow / SwitchWindowTime;
+		SwitchesInWindow = 0;
+		SwitchWindowTime = 0.f;
+		SET_FLOAT_STAT(STAT_PossessSwitchesPerSecond, SwitchesPerSecond);
+	}
+}
+
+APawn* APossessableRegistry::FindNearestPossessable(const FVector& Location, float Radius, const APawn* Ignore) const
+{
+	APawn *Nearest = NULL;
+	float NearestDistanceSq = FMath::Square(Radius);
+	const FIntPoint Center = GetCell(Location);
+	for (int32 X = Center.X - 1; X <= Center.X + 1; X++)
+	{
+		for (int32 Y = Center.Y - 1; Y <= Center.Y + 1; Y++)
+		{
+			const TArray<int32> *CellEntries = Grid.Find(FIntPoint(X, Y));
+			if (CellEntries == NULL)
+			{
+				continue;
+			}
+			for (int32 Index : *CellEntries)
+			{
+				APawn *Pawn = Possessables[Index].Pawn.Get();
+				// Taking over an AI's pawn is the point, taking another player's is not
+				if (Pawn == NULL || Pawn == Ignore || Pawn->GetRootComponent() == NULL || Pawn->IsPlayerControlled())
+				{
+					continue;
+				}
+				// Measure to the pawn's bounds rather than its origin so big vehicles can be entered from the side
+				const float DistanceSq = Pawn->GetRootComponent()->Bounds.GetBox().ComputeSquaredDistanceToPoint(Location);
+				if (DistanceSq <= NearestDistanceSq)
+				{
+					Nearest = Pawn;
+					NearestDistanceSq = DistanceSq;
+				}
+			}
+		}
+	}
+	return Nearest;
+}
+
+bool APossessableRegistry::SwitchPawns(APawn* FromPawn)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_SwitchPawns);
+	AController *TempController = FromPawn ? FromPawn->GetController() : NULL;
+	if (TempController == NULL)
+	{
+		return false;
+	}
+	APawn *Pawn = FindNearestPossessable(FromPawn->GetActorLocation(), HandoffRadius, FromPawn);
+	if (Pawn == NULL)
+	{
+		return false;
+	}
+	TempController->UnPossess();
+	TempController->Possess(Pawn);
+	AThirdPersonCharacter *Character = Cast<AThirdPersonCharacter>(Pawn);
+	if (Character)
+	{
+		Character->GetUp();
+	}
+	NumSwitches++;
+	SwitchesInWindow++;
+	return true;
+}
+
+int32 APossessableRegistry::GetNumSwitches() const
+{
+	return NumSwitches;
+}
+
+float APossessableRegistry::GetSwitchesPerSecond() const
+{
+	return SwitchesPerSecond;
+}
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "PossessableRegistry.generated.h"
+
+/**
+ * Keeps every pawn the player can switch into in a uniform grid, so SwitchPawns can find the closest one
+ * by looking at a few cells instead of running overlap queries on a sensor sphere attached to each pawn.
+ */
+UCLASS()
+class FIRSTATTEMPT_API APossessableRegistry : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	APossessableRegistry();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	void AddPossessable(APawn* Pawn);
+
+	void RemovePossessable(APawn* Pawn);
+
+	/** Returns the registered pawn whose bounds are closest to Location and within Radius of it, or null. Pawns another player is controlling are skipped */
+	APawn* FindNearestPossessable(const FVector& Location, float Radius, const APawn* Ignore = nullptr) const;
+
+	/** Moves FromPawn's controller into the nearest possessable pawn. Returns true if it switched */
+	bool SwitchPawns(APawn* FromPawn);
+
+	/** How close a pawn's bounds have to be to switch into it */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Possession")
+	float HandoffRadius;
+
+	/** Size of a grid cell. Should be larger than HandoffRadius plus the extent of the biggest pawn */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Possession")
+	float CellSize;
+
+	/** Number of successful pawn switches since the level started */
+	UFUNCTION(BlueprintPure, Category = "Possession")
+	int32 GetNumSwitches() const;
+
+	/** Pawn switches over the last second */
+	UFUNCTION(BlueprintPure, Category = "Possession")
+	float GetSwitchesPerSecond() const;
+
+private:
+	struct FPossessable
+	{
+		TWeakObjectPtr<APawn> Pawn;
+		FIntPoint Cell;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	void AddToCell(const FIntPoint& Cell, int32 Index);
+
+	void RemoveFromCell(const FIntPoint& Cell, int32 Index);
+
+	/** Removes entry Index, keeping the cell lists pointing at the right entries */
+	void RemoveAt(int32 Index);
+
+	TArray<FPossessable> Possessables;
+
+	/** Indices into Possessables for each occupied cell */
+	TMap<FIntPoint, TArray<int32>> Grid;
+
+	int32 NumSwitches;
+
+	int32 SwitchesInWindow;
+
+	float SwitchWindowTime;
+
+	float SwitchesPerSecond;
+};
@@ -0,0 +1,9 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "PreloadedContent.h"
+
+UPreloadedContent::UPreloadedContent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
@@ -0,0 +1,23 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "PreloadedContent.generated.h"
+
+UINTERFACE()
+class FIRSTATTEMPT_API UPreloadedContent : public UInterface
+{
+	GENERATED_UINTERFACE_BODY()
+};
+
+/**
+ * Something whose soft referenced content the content preloader streams in. Actor classes listed in the
+ * preloader's ManifestClasses are asked through their default object.
+ */
+class FIRSTATTEMPT_API IPreloadedContent
+{
+	GENERATED_IINTERFACE_BODY()
+
+	/** Adds the soft referenced content this needs to the list */
+	virtual void GetContentAssets(TArray<FStringAssetReference>& OutAssets) const = 0;
+};
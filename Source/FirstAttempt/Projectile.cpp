@@ -1,63 +1,121 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#include "FirstAttempt.h"
-#include "Projectile.h"
-
-
-// Sets default values
-AProjectile::AProjectile()
-{
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
-
-	// Static reference to the mesh to use for the projectile
-	static ConstructorHelpers::FObjectFinder<UStaticMesh> ProjectileMeshAsset(TEXT("/Game/StarterContent/Shapes/Shape_Sphere.Shape_Sphere"));
-
-	// Create mesh component for the projectile sphere
-	ProjectileMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ProjectileMesh0"));
-	ProjectileMesh->SetStaticMesh(ProjectileMeshAsset.Object);
-	ProjectileMesh->SetWorldScale3D(FVector(.3, .3, .3));
-	ProjectileMesh->SetupAttachment(RootComponent);
-	ProjectileMesh->BodyInstance.SetCollisionProfileName("Projectile");
-	ProjectileMesh->OnComponentHit.AddDynamic(this, &AProjectile::OnHit);		// set up a notification for when this component hits something
-	RootComponent = ProjectileMesh;
-
-	// Use a ProjectileMovementComponent to govern this projectile's movement
-	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileMovement0"));
-	ProjectileMovement->UpdatedComponent = ProjectileMesh;
-	ProjectileMovement->InitialSpeed = 3000.f;
-	ProjectileMovement->MaxSpeed = 3000.f;
-	ProjectileMovement->bRotationFollowsVelocity = true;
-	ProjectileMovement->bShouldBounce = false;
-	ProjectileMovement->ProjectileGravityScale = 0.f; // No gravity
-
-													  // Die after 3 seconds by default
-	InitialLifeSpan = 3.0f;
-
-}
-
-void AProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
-{
-	// Only add impulse and destroy projectile if we hit a physics
-	if ((OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL) && OtherComp->IsSimulatingPhysics())
-	{
-		OtherComp->AddImpulseAtLocation(GetVelocity() * 20.0f, GetActorLocation());
-	}
-
-	Destroy();
-}
-/*
-// Called when the game starts or when spawned
-void AProjectile::BeginPlay()
-{
-	Super::BeginPlay();
-	
-}
-
-// Called every frame
-void AProjectile::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-}
-*/
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "Projectile.h"
+#include "ProjectilePool.h"
+#include "ContentPreloader.h"
+
+
+// Sets default values
+AProjectile::AProjectile()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Soft reference to the mesh to use for the projectile, streamed in by the content preloader and applied in OnConstruction
+	ProjectileMeshAsset = TAssetPtr<UStaticMesh>(FStringAssetReference(TEXT("/Game/StarterContent/Shapes/Shape_Sphere.Shape_Sphere")));
+
+	// Create mesh component for the projectile sphere
+	ProjectileMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ProjectileMesh0"));
+	ProjectileMesh->SetWorldScale3D(FVector(.3, .3, .3));
+	ProjectileMesh->SetupAttachment(RootComponent);
+	ProjectileMesh->BodyInstance.SetCollisionProfileName("Projectile");
+	ProjectileMesh->OnComponentHit.AddDynamic(this, &AProjectile::OnHit);		// set up a notification for when this component hits something
+	RootComponent = ProjectileMesh;
+
+	// Use a ProjectileMovementComponent to govern this projectile's movement
+	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileMovement0"));
+	ProjectileMovement->UpdatedComponent = ProjectileMesh;
+	ProjectileMovement->InitialSpeed = 3000.f;
+	ProjectileMovement->MaxSpeed = 3000.f;
+	ProjectileMovement->bRotationFollowsVelocity = true;
+	ProjectileMovement->bShouldBounce = false;
+	ProjectileMovement->ProjectileGravityScale = 0.f; // No gravity
+
+	// Go back to the pool after 3 seconds by default. InitialLifeSpan would destroy the actor, so track it ourselves
+	FlightLifeSpan = 3.0f;
+	OwningPool = NULL;
+	PoolSlot = INDEX_NONE;
+
+	// Projectiles never replicate. The server's ones do the hitting and clients fly their own for show
+	bReplicates = false;
+}
+
+void AProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	// Only add impulse and destroy projectile if we hit a physics
+	if ((OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL) && OtherComp->IsSimulatingPhysics())
+	{
+		OtherComp->AddImpulseAtLocation(GetVelocity() * 20.0f, GetActorLocation());
+	}
+
+	Expire();
+}
+
+// Called when the game starts or when spawned
+void AProjectile::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	if (ProjectileMesh->GetStaticMesh() == NULL)
+	{
+		ProjectileMesh->SetStaticMesh(AContentPreloader::Resolve(ProjectileMeshAsset));
+	}
+}
+
+void AProjectile::GetContentAssets(TArray<FStringAssetReference>& OutAssets) const
+{
+	OutAssets.AddUnique(ProjectileMeshAsset.ToStringReference());
+}
+
+void AProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+	OwningPool = Cast<AProjectilePool>(GetOwner());
+	if (OwningPool == NULL)
+	{
+		SetLifeSpan(FlightLifeSpan);
+	}
+}
+
+void AProjectile::Launch(const FVector& Location, const FRotator& Rotation)
+{
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// The movement component lets go of the mesh when it stops on a hit, so hook it back up every launch
+	ProjectileMovement->SetUpdatedComponent(ProjectileMesh);
+	ProjectileMovement->Velocity = Rotation.Vector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->Activate(true);
+
+	GetWorldTimerManager().SetTimer(FlightLifeSpanHandle, this, &AProjectile::Expire, FlightLifeSpan, false);
+}
+
+void AProjectile::Deactivate()
+{
+	GetWorldTimerManager().ClearTimer(FlightLifeSpanHandle);
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
+
+void AProjectile::Expire()
+{
+	if (OwningPool)
+	{
+		OwningPool->ReleaseProjectile(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+/*
+// Called every frame
+void AProjectile::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+}
+*/
@@ -1,47 +1,83 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "GameFramework/Actor.h"
-#include "Projectile.generated.h"
-
-class UProjectileMovementComponent;
-class UStaticMeshComponent;
-
-UCLASS(config=Game)
-class FIRSTATTEMPT_API AProjectile : public AActor
-{
-	GENERATED_BODY()
-
-	/** Sphere collision component */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Projectile, meta = (AllowPrivateAccess = "true"))
-	UStaticMeshComponent* ProjectileMesh;
-
-	/** Projectile movement component */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
-	UProjectileMovementComponent* ProjectileMovement;
-	
-public:	
-	// Sets default values for this actor's properties
-	AProjectile();
-
-	/** Function to handle the projectile hitting something */
-	UFUNCTION()
-	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
-
-	/** Returns ProjectileMesh subobject **/
-	FORCEINLINE UStaticMeshComponent* GetProjectileMesh() const { return ProjectileMesh; }
-	/** Returns ProjectileMovement subobject **/
-	FORCEINLINE UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
-	/*
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
-
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	*/
-	
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "PreloadedContent.h"
+#include "Projectile.generated.h"
+
+class UProjectileMovementComponent;
+class UStaticMeshComponent;
+class AProjectilePool;
+
+UCLASS(config=Game)
+class FIRSTATTEMPT_API AProjectile : public AActor, public IPreloadedContent
+{
+	GENERATED_BODY()
+
+	/** Sphere collision component */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Projectile, meta = (AllowPrivateAccess = "true"))
+	UStaticMeshComponent* ProjectileMesh;
+
+	/** Projectile movement component */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
+	UProjectileMovementComponent* ProjectileMovement;
+	
+public:	
+	// Sets default values for this actor's properties
+	AProjectile();
+
+	/** Function to handle the projectile hitting something */
+	UFUNCTION()
+	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+
+	/** Moves the projectile to the given transform and sends it flying, used when it is handed out by a pool */
+	void Launch(const FVector& Location, const FRotator& Rotation);
+
+	/** Stops, hides and disables collision on the projectile while it sits in a pool */
+	void Deactivate();
+
+	/** How long the projectile flies before it is returned to its pool (or destroyed if it has none) */
+	UPROPERTY(Category = Projectile, EditDefaultsOnly, BlueprintReadOnly)
+	float FlightLifeSpan;
+
+	/** Mesh for the projectile, loaded through the content preloader */
+	UPROPERTY(Category = Projectile, EditDefaultsOnly, BlueprintReadOnly)
+	TAssetPtr<UStaticMesh> ProjectileMeshAsset;
+
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+	/** Adds the soft referenced content this projectile needs to the list, for the content preloader */
+	virtual void GetContentAssets(TArray<FStringAssetReference>& OutAssets) const override;
+
+	/** Returns ProjectileMesh subobject **/
+	FORCEINLINE UStaticMeshComponent* GetProjectileMesh() const { return ProjectileMesh; }
+	/** Returns ProjectileMovement subobject **/
+	FORCEINLINE UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	/*
+public:	
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	*/
+
+private:
+	friend class AProjectilePool;
+
+	/** Sends the projectile back to its pool, or destroys it if it was not spawned by one */
+	void Expire();
+
+	/** Pool that spawned this projectile, null for projectiles spawned on their own */
+	UPROPERTY()
+	AProjectilePool *OwningPool;
+
+	/** Where the pool keeps this projectile among the ones in flight, INDEX_NONE while it sits in the pool */
+	int32 PoolSlot;
+
+	FTimerHandle FlightLifeSpanHandle;
+
+};
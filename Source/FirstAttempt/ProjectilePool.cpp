@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "ProjectilePool.h"
+#include "Projectile.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Size"), STAT_ProjectilePoolSize, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectiles In Flight"), STAT_ProjectilesInFlight, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool High Water Mark"), STAT_ProjectilePoolHighWaterMark, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Misses"), STAT_ProjectilePoolMisses, STATGROUP_FirstAttempt);
+
+AProjectilePool::AProjectilePool()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	WarmUpSize = 128;
+	MaxPoolSize = 1024;
+	HighWaterMark = 0;
+	MissCount = 0;
+	NumSpawned = 0;
+	ReuseCursor = 0;
+}
+
+void AProjectilePool::BeginPlay()
+{
+	Super::BeginPlay();
+	AllProjectiles.Reserve(WarmUpSize);
+	FreeProjectiles.Reserve(WarmUpSize);
+	ActiveProjectiles.Reserve(WarmUpSize);
+	for (int i = 0; i < WarmUpSize; i++)
+	{
+		AProjectile *Projectile = SpawnPooledProjectile();
+		if (Projectile)
+		{
+			FreeProjectiles.Add(Projectile);
+		}
+	}
+	UpdateStats();
+}
+
+void AProjectilePool::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+	UE_LOG(LogTemp, Log, TEXT("ProjectilePool: size %d, high water mark %d, misses %d, spawned %d"), GetPoolSize(), HighWaterMark, MissCount, NumSpawned);
+	AllProjectiles.Empty();
+	FreeProjectiles.Empty();
+	ActiveProjectiles.Empty();
+}
+
+AProjectile* AProjectilePool::SpawnPooledProjectile()
+{
+	UWorld *World = GetWorld();
+	if (World == NULL)
+	{
+		return NULL;
+	}
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AProjectile *Projectile = World->SpawnActor<AProjectile>(GetActorLocation(), FRotator::ZeroRotator, SpawnParams);
+	if (Projectile)
+	{
+		Projectile->Deactivate();
+		AllProjectiles.Add(Projectile);
+		NumSpawned++;
+	}
+	return Projectile;
+}
+
+AProjectile* AProjectilePool::AcquireProjectile(const FVector& Location, const FRotator& Rotation)
+{
+	AProjectile *Projectile = NULL;
+	while (FreeProjectiles.Num() > 0 && Projectile == NULL)
+	{
+		// Skip anything that was destroyed out from under us, e.g. by a level unload
+		AProjectile *Candidate = FreeProjectiles.Pop(false);
+		if (Candidate && !Candidate->IsPendingKill())
+		{
+			Projectile = Candidate;
+		}
+	}
+	if (Projectile == NULL)
+	{
+		MissCount++;
+		if (GetPoolSize() < MaxPoolSize)
+		{
+			Projectile = SpawnPooledProjectile();
+		}
+		else
+		{
+			// Pool is exhausted, steal the next one round the pool. Everything is in flight, so going round in
+			// firing order soon makes this the one that has been flying the longest
+			for (int32 i = 0; i < AllProjectiles.Num() && Projectile == NULL; i++)
+			{
+				ReuseCursor = ReuseCursor % AllProjectiles.Num();
+				AProjectile *Candidate = AllProjectiles[ReuseCursor];
+				ReuseCursor++;
+				if (Candidate && !Candidate->IsPendingKill() && Candidate->PoolSlot != INDEX_NONE)
+				{
+					Projectile = Candidate;
+				}
+			}
+		}
+	}
+	if (Projectile)
+	{
+		// A stolen projectile keeps its slot
+		if (Projectile->PoolSlot == INDEX_NONE)
+		{
+			Projectile->PoolSlot = ActiveProjectiles.Add(Projectile);
+		}
+		HighWaterMark = FMath::Max(HighWaterMark, ActiveProjectiles.Num());
+		Projectile->Launch(Location, Rotation);
+	}
+	UpdateStats();
+	return Projectile;
+}
+
+void AProjectilePool::ReleaseProjectile(AProjectile* Projectile)
+{
+	if (Projectile && ActiveProjectiles.IsValidIndex(Projectile->PoolSlot) && ActiveProjectiles[Projectile->PoolSlot] == Projectile)
+	{
+		const int32 Slot = Projectile->PoolSlot;
+		ActiveProjectiles.RemoveAtSwap(Slot, 1, false);
+		if (Slot < ActiveProjectiles.Num())
+		{
+			ActiveProjectiles[Slot]->PoolSlot = Slot;
+		}
+		Projectile->PoolSlot = INDEX_NONE;
+		Projectile->Deactivate();
+		FreeProjectiles.Add(Projectile);
+		UpdateStats();
+	}
+}
+
+int32 AProjectilePool::GetPoolSize() const
+{
+	return AllProjectiles.Num();
+}
+
+int32 AProjectilePool::GetNumActive() const
+{
+	return ActiveProjectiles.Num();
+}
+
+int32 AProjectilePool::GetHighWaterMark() const
+{
+	return HighWaterMark;
+}
+
+int32 AProjectilePool::GetMissCount() const
+{
+	return MissCount;
+}
+
+int32 AProjectilePool::GetNumSpawned() const
+{
+	return NumSpawned;
+}
+
+void AProjectilePool::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_ProjectilePoolSize, AllProjectiles.Num());
+	SET_DWORD_STAT(STAT_ProjectilesInFlight, ActiveProjectiles.Num());
+	SET_DWORD_STAT(STAT_ProjectilePoolHighWaterMark, HighWaterMark);
+	SET_DWORD_STAT(STAT_ProjectilePoolMisses, MissCount);
+}
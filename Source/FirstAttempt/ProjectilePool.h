@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "ProjectilePool.generated.h"
+
+class AProjectile;
+
+/**
+ * World level pool of AProjectile actors. Projectiles are spawned up front, handed out when a
+ * character fires and returned here on hit or when their lifetime runs out instead of being destroyed.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AProjectilePool : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AProjectilePool();
+
+	/** Takes a projectile out of the pool and launches it. Spawns a new one if the pool is empty */
+	AProjectile* AcquireProjectile(const FVector& Location, const FRotator& Rotation);
+
+	/** Hides the projectile and makes it available to be fired again */
+	void ReleaseProjectile(AProjectile* Projectile);
+
+	/** Number of projectiles owned by the pool, in flight or not */
+	UFUNCTION(BlueprintPure, Category = "Pool")
+	int32 GetPoolSize() const;
+
+	/** Number of projectiles currently in flight */
+	UFUNCTION(BlueprintPure, Category = "Pool")
+	int32 GetNumActive() const;
+
+	/** Largest number of projectiles that have been in flight at once */
+	UFUNCTION(BlueprintPure, Category = "Pool")
+	int32 GetHighWaterMark() const;
+
+	/** Number of times a projectile was requested while the pool was empty */
+	UFUNCTION(BlueprintPure, Category = "Pool")
+	int32 GetMissCount() const;
+
+	/** Number of projectile actors spawned by the pool, including the warm up */
+	UFUNCTION(BlueprintPure, Category = "Pool")
+	int32 GetNumSpawned() const;
+
+	/** Lets the pool grow to NewMaxPoolSize, for benchmarks that keep thousands of projectiles in flight */
+	FORCEINLINE void SetMaxPoolSize(int32 NewMaxPoolSize) { MaxPoolSize = FMath::Max(MaxPoolSize, NewMaxPoolSize); }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Projectiles spawned when the pool begins play */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Pool")
+	int32 WarmUpSize;
+
+	/**
+	 * The pool never grows past this. When every projectile is in flight they are reused in turn, which is
+	 * oldest first once the pool has been exhausted for a while
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Pool")
+	int32 MaxPoolSize;
+
+private:
+	AProjectile* SpawnPooledProjectile();
+
+	void UpdateStats() const;
+
+	UPROPERTY()
+	TArray<AProjectile*> AllProjectiles;
+
+	UPROPERTY()
+	TArray<AProjectile*> FreeProjectiles;
+
+	/** Projectiles in flight, in no particular order. Each knows its slot so it can be swapped out when it comes back */
+	TArray<AProjectile*> ActiveProjectiles;
+
+	/** Next projectile in AllProjectiles to reuse when the pool is full */
+	int32 ReuseCursor;
+
+	int32 HighWaterMark;
+	int32 MissCount;
+	int32 NumSpawned;
+};
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "RandomStreams.h"
+
+/** Spreads a seed over the generator state, as the xoshiro authors recommend */
+static uint64 SplitMix64(uint64& State)
+{
+	uint64 Z = (State += 0x9E3779B97F4A7C15ull);
+	Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+	return Z ^ (Z >> 31);
+}
+
+FFastRandomStream::FFastRandomStream()
+{
+	Initialize(0);
+}
+
+FFastRandomStream::FFastRandomStream(uint64 InSeed)
+{
+	Initialize(InSeed);
+}
+
+void FFastRandomStream::Initialize(uint64 InSeed)
+{
+	InitialSeed = InSeed;
+	uint64 State = InSeed;
+	for (int32 Lane = 0; Lane < NumLanes; Lane++)
+	{
+		// SplitMix never gives four zero words in a row, so no lane starts in xoshiro's one stuck state
+		const uint64 A = SplitMix64(State);
+		const uint64 B = SplitMix64(State);
+		S0[Lane] = (uint32)A;
+		S1[Lane] = (uint32)(A >> 32);
+		S2[Lane] = (uint32)B;
+		S3[Lane] = (uint32)(B >> 32);
+	}
+	BufferPos = NumLanes;
+}
+
+FVector FFastRandomStream::GetPointInBox(const FVector& Origin, const FVector& Extent)
+{
+	return FVector(
+		Origin.X + Extent.X * (2.f * GetFraction() - 1.f),
+		Origin.Y + Extent.Y * (2.f * GetFraction() - 1.f),
+		Origin.Z + Extent.Z * (2.f * GetFraction() - 1.f));
+}
+
+void FFastRandomStream::GetFractions(float* Out, int32 Num, float Min, float Max)
+{
+	const float Range = Max - Min;
+	int32 i = 0;
+	// Use up what single draws left in the buffer first so bulk and single draws give the same sequence
+	while (i < Num && BufferPos < NumLanes)
+	{
+		Out[i++] = Min + Range * ToFraction(Buffer[BufferPos++]);
+	}
+	MS_ALIGN(16) uint32 Values[NumLanes] GCC_ALIGN(16);
+	for (; i + NumLanes <= Num; i += NumLanes)
+	{
+		Step(Values);
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			Out[i + Lane] = Min + Range * ToFraction(Values[Lane]);
+		}
+	}
+	for (; i < Num; i++)
+	{
+		Out[i] = Min + Range * GetFraction();
+	}
+}
+
+void FFastRandomStream::GetPointsInBox(const FVector& Origin, const FVector& Extent, int32 Num, TArray<FVector>& Out)
+{
+	Out.SetNumUninitialized(FMath::Max(Num, 0), false);
+	if (Num <= 0)
+	{
+		return;
+	}
+	// Draw every coordinate in one go, then spread them out. Same order as Num calls to GetPointInBox
+	TArray<float> Fractions;
+	Fractions.SetNumUninitialized(Num * 3);
+	GetFractions(Fractions.GetData(), Fractions.Num(), -1.f, 1.f);
+	for (int32 i = 0; i < Num; i++)
+	{
+		Out[i] = Origin + Extent * FVector(Fractions[i * 3], Fractions[i * 3 + 1], Fractions[i * 3 + 2]);
+	}
+}
+
+FRandomStreams::FRandomStreams()
+{
+	Initialize(0);
+}
+
+void FRandomStreams::Initialize(uint64 InSeed)
+{
+	Seed = InSeed;
+	uint64 State = InSeed;
+	for (int32 i = 0; i < (int32)ERandomStream::Num; i++)
+	{
+		Streams[i].Initialize(SplitMix64(State));
+	}
+}
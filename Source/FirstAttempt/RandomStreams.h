@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/** The systems that draw random numbers. Each gets its own stream so one drawing more doesn't shift the others */
+enum class ERandomStream : uint8
+{
+	Spawning,
+	AI,
+	Weapons,
+	Crowd,
+	Num
+};
+
+/**
+ * Fast seedable random stream. Runs four xoshiro128+ generators side by side with their state laid out lane by
+ * lane, so drawing numbers in bulk is a straight loop over four lanes the compiler can vectorise. Single draws
+ * come out of a four number buffer refilled one step at a time.
+ */
+class FIRSTATTEMPT_API FFastRandomStream
+{
+public:
+	FFastRandomStream();
+
+	explicit FFastRandomStream(uint64 InSeed);
+
+	/** Restarts the stream. The same seed always gives the same numbers */
+	void Initialize(uint64 InSeed);
+
+	FORCEINLINE uint64 GetInitialSeed() const { return InitialSeed; }
+
+	/** Random 32 bit integer */
+	FORCEINLINE uint32 GetUnsignedInt()
+	{
+		if (BufferPos == NumLanes)
+		{
+			Step(Buffer);
+			BufferPos = 0;
+		}
+		return Buffer[BufferPos++];
+	}
+
+	/** Random float in [0, 1) */
+	FORCEINLINE float GetFraction()
+	{
+		return ToFraction(GetUnsignedInt());
+	}
+
+	/** Random float in [Min, Max) */
+	FORCEINLINE float FRandRange(float Min, float Max)
+	{
+		return Min + (Max - Min) * GetFraction();
+	}
+
+	/** Random integer in [Min, Max] */
+	FORCEINLINE int32 RandRange(int32 Min, int32 Max)
+	{
+		const int64 Range = (int64)Max - Min + 1;
+		return Range > 0 ? Min + (int32)(((uint64)GetUnsignedInt() * (uint64)Range) >> 32) : Min;
+	}
+
+	/** Random point inside the box */
+	FVector GetPointInBox(const FVector& Origin, const FVector& Extent);
+
+	/** Fills Out with Num floats in [Min, Max) */
+	void GetFractions(float* Out, int32 Num, float Min = 0.f, float Max = 1.f);
+
+	/** Replaces Out with Num random points inside the box, for placing a whole wave in one call */
+	void GetPointsInBox(const FVector& Origin, const FVector& Extent, int32 Num, TArray<FVector>& Out);
+
+private:
+	enum { NumLanes = 4 };
+
+	FORCEINLINE static float ToFraction(uint32 Value)
+	{
+		// Top 24 bits, which is all a float's mantissa can hold, so the result is never rounded up to 1
+		return (Value >> 8) * (1.f / 16777216.f);
+	}
+
+	FORCEINLINE static uint32 Rotl(uint32 Value, int32 Shift)
+	{
+		return (Value << Shift) | (Value >> (32 - Shift));
+	}
+
+	/** Advances every lane once and writes one number per lane */
+	FORCEINLINE void Step(uint32* Out)
+	{
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			Out[Lane] = S0[Lane] + S3[Lane];
+			const uint32 T = S1[Lane] << 9;
+			S2[Lane] ^= S0[Lane];
+			S3[Lane] ^= S1[Lane];
+			S1[Lane] ^= S2[Lane];
+			S0[Lane] ^= S3[Lane];
+			S2[Lane] ^= T;
+			S3[Lane] = Rotl(S3[Lane], 11);
+		}
+	}
+
+	/** Generator state, one word of every lane next to each other */
+	MS_ALIGN(16) uint32 S0[NumLanes] GCC_ALIGN(16);
+	MS_ALIGN(16) uint32 S1[NumLanes] GCC_ALIGN(16);
+	MS_ALIGN(16) uint32 S2[NumLanes] GCC_ALIGN(16);
+	MS_ALIGN(16) uint32 S3[NumLanes] GCC_ALIGN(16);
+
+	/** Numbers from the last step not handed out yet */
+	uint32 Buffer[NumLanes];
+
+	int32 BufferPos;
+
+	uint64 InitialSeed;
+};
+
+/**
+ * One stream per ERandomStream, all derived from one seed. One lives on each AFirstAttemptGameModeBase and is
+ * seeded in InitGame from the replay being recorded or played, -RandomSeed= or the clock, in that order.
+ * Identical seeds give identical spawn timing and placement.
+ */
+class FIRSTATTEMPT_API FRandomStreams
+{
+public:
+	FRandomStreams();
+
+	/** Seeds every stream from Seed */
+	void Initialize(uint64 InSeed);
+
+	FORCEINLINE uint64 GetSeed() const { return Seed; }
+
+	FORCEINLINE FFastRandomStream& Get(ERandomStream Stream)
+	{
+		check(Stream < ERandomStream::Num);
+		return Streams[(int32)Stream];
+	}
+
+private:
+	FFastRandomStream Streams[(int32)ERandomStream::Num];
+
+	uint64 Seed;
+};
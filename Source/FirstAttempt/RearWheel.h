@@ -1,20 +1,20 @@
-// Fill out your copyright notice in the Description page of Project Settings.
-
-#pragma once
-
-#include "VehicleWheel.h"
-#include "RearWheel.generated.h"
-
-/**
- * 
- */
-UCLASS()
-class FIRSTATTEMPT_API URearWheel : public UVehicleWheel
-{
-	GENERATED_BODY()
-	
-public:
-	URearWheel();
-	
-	
-};
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "VehicleWheel.h"
+#include "RearWheel.generated.h"
+
+/**
+ * 
+ */
+UCLASS()
+class FIRSTATTEMPT_API URearWheel : public UVehicleWheel
+{
+	GENERATED_BODY()
+	
+public:
+	URearWheel();
+	
+	
+};
@@ -0,0 +1,463 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "ReplayRecorder.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "Serialization/MemoryReader.h"
+#include "FirstAttemptPlayerController.h"
+
+/** "FARP" */
+static const uint32 ReplayMagic = 0x50524146;
+static const uint32 ReplayVersion = 1;
+
+/** Divergences past this many are counted but not logged */
+static const int32 MaxLoggedDivergences = 10;
+
+/** Slowest frames listed when playback finishes */
+static const int32 MaxLoggedHitches = 10;
+
+AReplayRecorder::AReplayRecorder()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	HitchThresholdMs = 50.f;
+	Mode = EReplayMode::None;
+	Seed = 0;
+	FrameIndex = 0;
+	Writer = NULL;
+	InputOffset = 0;
+	CheckOffset = 0;
+	HeaderSize = 0;
+	NumDivergences = 0;
+	LastTickTime = 0.0;
+	bFinished = false;
+	bSavedUseFixedTimeStep = false;
+	SavedFixedDeltaTime = 0.0;
+}
+
+/** Whether the command line has -RecordReplay or -RecordReplay=<path>. Param only matches the bare form */
+static bool IsRecordRequested(const TCHAR* CommandLine, FString& OutPath)
+{
+	return FParse::Value(CommandLine, TEXT("RecordReplay="), OutPath) || FParse::Param(CommandLine, TEXT("RecordReplay"));
+}
+
+bool AReplayRecorder::IsRequested()
+{
+	const TCHAR *CommandLine = FCommandLine::Get();
+	FString Path;
+	return FParse::Value(CommandLine, TEXT("PlayReplay="), Path) || IsRecordRequested(CommandLine, Path);
+}
+
+void AReplayRecorder::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// The game mode spawns this from InitGame, so the random stream is seeded before any actor has begun play
+	const TCHAR *CommandLine = FCommandLine::Get();
+	if (FParse::Value(CommandLine, TEXT("PlayReplay="), ReplayPath))
+	{
+		Mode = StartPlayback() ? EReplayMode::Playback : EReplayMode::None;
+	}
+	else if (IsRecordRequested(CommandLine, ReplayPath))
+	{
+		if (ReplayPath.IsEmpty())
+		{
+			ReplayPath = FPaths::GameSavedDir() / TEXT("Replays") / FString::Printf(TEXT("FirstAttempt-%s.farp"), *FDateTime::Now().ToString());
+		}
+		if (!FParse::Value(CommandLine, TEXT("ReplaySeed="), Seed))
+		{
+			Seed = (int32)FPlatformTime::Cycles();
+		}
+		Mode = StartRecording() ? EReplayMode::Recording : EReplayMode::None;
+	}
+	if (Mode != EReplayMode::None)
+	{
+		FMath::RandInit(Seed);
+		FMath::SRandInit(Seed);
+	}
+}
+
+bool AReplayRecorder::StartRecording()
+{
+	Writer = IFileManager::Get().CreateFileWriter(*ReplayPath);
+	if (Writer == NULL)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Replay: could not create %s"), *ReplayPath);
+		return false;
+	}
+	uint32 Magic = ReplayMagic;
+	uint32 Version = ReplayVersion;
+	FString MapName = GetWorld()->GetMapName();
+	*Writer << Magic << Version << Seed << MapName;
+	UE_LOG(LogTemp, Log, TEXT("Replay: recording to %s with seed %d"), *ReplayPath, Seed);
+	return true;
+}
+
+bool AReplayRecorder::StartPlayback()
+{
+	if (!FFileHelper::LoadFileToArray(LogData, *ReplayPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Replay: could not read %s"), *ReplayPath);
+		return false;
+	}
+	FMemoryReader Reader(LogData);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	FString MapName;
+	Reader << Magic << Version;
+	if (Magic != ReplayMagic || Version != ReplayVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Replay: %s is not a version %u replay"), *ReplayPath, ReplayVersion);
+		return false;
+	}
+	Reader << Seed << MapName;
+	if (MapName != GetWorld()->GetMapName())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay: %s was recorded on %s, not %s"), *ReplayPath, *MapName, *GetWorld()->GetMapName());
+	}
+	HeaderSize = Reader.Tell();
+
+	// Index the frame times up front, each frame's has to be set before the frame starts
+	FRecord Record;
+	while (ReadRecord(Reader, Record))
+	{
+		if (Record.Type == ERecordType::Frame)
+		{
+			if (FrameDeltas.Num() <= (int32)Record.Frame)
+			{
+				FrameDeltas.SetNumZeroed(Record.Frame + 1);
+			}
+			FrameDeltas[Record.Frame] = Record.Value;
+		}
+	}
+	if (FrameDeltas.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Replay: %s has no frames"), *ReplayPath);
+		return false;
+	}
+	InputOffset = HeaderSize;
+	CheckOffset = HeaderSize;
+	Samples.Reserve(FrameDeltas.Num());
+
+	// Run every frame at its recorded length without waiting for real time to catch up
+	bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+	SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FrameDeltas[0]);
+	UE_LOG(LogTemp, Log, TEXT("Replay: playing %s, %d frames with seed %d"), *ReplayPath, FrameDeltas.Num(), Seed);
+	return true;
+}
+
+void AReplayRecorder::BeginPlay()
+{
+	Super::BeginPlay();
+	LastTickTime = FPlatformTime::Seconds();
+}
+
+void AReplayRecorder::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Writer)
+	{
+		Writer->Close();
+		delete Writer;
+		Writer = NULL;
+		UE_LOG(LogTemp, Log, TEXT("Replay: recorded %u frames to %s"), FrameIndex, *ReplayPath);
+	}
+	if (IsPlayingBack())
+	{
+		FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AReplayRecorder::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const double Now = FPlatformTime::Seconds();
+	if (IsPlayingBack() && !bFinished)
+	{
+		FFrameSample Sample;
+		Sample.Frame = FrameIndex;
+		Sample.FrameMs = (Now - LastTickTime) * 1000.0;
+		Sample.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+		Samples.Add(Sample);
+	}
+	LastTickTime = Now;
+}
+
+void AReplayRecorder::OnPlayerTick(AFirstAttemptPlayerController* PlayerController, float DeltaSeconds)
+{
+	if (IsRecording())
+	{
+		FRecord Record;
+		Record.Type = ERecordType::Frame;
+		Record.Value = DeltaSeconds;
+		WriteRecord(Record);
+	}
+	else if (IsPlayingBack() && !bFinished)
+	{
+		if (FrameIndex >= (uint32)FrameDeltas.Num())
+		{
+			FinishPlayback();
+			return;
+		}
+		PlayFrameInput(PlayerController);
+		if (FrameDeltas.IsValidIndex(FrameIndex + 1))
+		{
+			FApp::SetFixedDeltaTime(FrameDeltas[FrameIndex + 1]);
+		}
+	}
+	FrameIndex++;
+}
+
+void AReplayRecorder::RecordInputKey(const FKey& Key, EInputEvent EventType, float AmountDepressed, bool bGamepad)
+{
+	FRecord Record;
+	Record.Type = ERecordType::InputKey;
+	Record.KeyIndex = GetKeyIndex(Key);
+	Record.EventType = (uint8)EventType;
+	Record.Value = AmountDepressed;
+	Record.bGamepad = bGamepad;
+	WriteRecord(Record);
+}
+
+void AReplayRecorder::RecordInputAxis(const FKey& Key, float Delta, float DeltaTime, int32 NumSamples, bool bGamepad)
+{
+	FRecord Record;
+	Record.Type = ERecordType::InputAxis;
+	Record.KeyIndex = GetKeyIndex(Key);
+	Record.Value = Delta;
+	Record.DeltaTime = DeltaTime;
+	Record.NumSamples = NumSamples;
+	Record.bGamepad = bGamepad;
+	WriteRecord(Record);
+}
+
+void AReplayRecorder::RecordPossess(APawn* Pawn)
+{
+	FRecord Record;
+	Record.Type = ERecordType::Possess;
+	Record.Frame = FrameIndex;
+	Record.Name = Pawn ? Pawn->GetName() : FString();
+	Record.Location = Pawn ? Pawn->GetActorLocation() : FVector::ZeroVector;
+	if (IsRecording())
+	{
+		WriteRecord(Record);
+	}
+	else if (IsPlayingBack())
+	{
+		CheckRecord(Record);
+	}
+}
+
+void AReplayRecorder::RecordSpawn(AActor* Spawner, const FVector& Location, float Yaw)
+{
+	FRecord Record;
+	Record.Type = ERecordType::Spawn;
+	Record.Frame = FrameIndex;
+	Record.Name = Spawner ? Spawner->GetName() : FString();
+	Record.Location = Location;
+	Record.Value = Yaw;
+	if (IsRecording())
+	{
+		WriteRecord(Record);
+	}
+	else if (IsPlayingBack())
+	{
+		CheckRecord(Record);
+	}
+}
+
+uint16 AReplayRecorder::GetKeyIndex(const FKey& Key)
+{
+	const FName KeyName = Key.GetFName();
+	if (const uint16 *Found = KeyIndices.Find(KeyName))
+	{
+		return *Found;
+	}
+	// Write the name once, every record after that only carries the number
+	const uint16 Index = (uint16)KeyIndices.Num();
+	KeyIndices.Add(KeyName, Index);
+	FRecord Record;
+	Record.Type = ERecordType::KeyName;
+	Record.KeyIndex = Index;
+	Record.Name = KeyName.ToString();
+	WriteRecord(Record);
+	return Index;
+}
+
+void AReplayRecorder::WriteRecord(FRecord& Record)
+{
+	if (Writer)
+	{
+		Record.Frame = FrameIndex;
+		SerializeRecord(*Writer, Record);
+	}
+}
+
+bool AReplayRecorder::ReadRecord(FArchive& Reader, FRecord& OutRecord) const
+{
+	if (Reader.AtEnd())
+	{
+		return false;
+	}
+	SerializeRecord(Reader, OutRecord);
+	if (Reader.IsError() || OutRecord.Type > ERecordType::Spawn)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay: %s is damaged at offset %lld"), *ReplayPath, Reader.Tell());
+		return false;
+	}
+	return true;
+}
+
+void AReplayRecorder::SerializeRecord(FArchive& Ar, FRecord& Record)
+{
+	uint8 Type = (uint8)Record.Type;
+	uint8 bGamepad = Record.bGamepad ? 1 : 0;
+	Ar << Type << Record.Frame;
+	Record.Type = (ERecordType)Type;
+	switch (Record.Type)
+	{
+	case ERecordType::Frame:
+		Ar << Record.Value;
+		break;
+	case ERecordType::KeyName:
+		Ar << Record.KeyIndex << Record.Name;
+		break;
+	case ERecordType::InputKey:
+		Ar << Record.KeyIndex << Record.EventType << bGamepad << Record.Value;
+		break;
+	case ERecordType::InputAxis:
+		Ar << Record.KeyIndex << bGamepad << Record.Value << Record.DeltaTime << Record.NumSamples;
+		break;
+	case ERecordType::Possess:
+		Ar << Record.Name << Record.Location;
+		break;
+	case ERecordType::Spawn:
+		Ar << Record.Name << Record.Location << Record.Value;
+		break;
+	default:
+		Ar.SetError();
+		break;
+	}
+	Record.bGamepad = bGamepad != 0;
+}
+
+void AReplayRecorder::PlayFrameInput(AFirstAttemptPlayerController* PlayerController)
+{
+	FMemoryReader Reader(LogData);
+	Reader.Seek(InputOffset);
+	FRecord Record;
+	for (;;)
+	{
+		const int64 RecordOffset = Reader.Tell();
+		if (!ReadRecord(Reader, Record) || Record.Frame > FrameIndex)
+		{
+			// Not this frame's, leave it for the next one
+			InputOffset = RecordOffset;
+			break;
+		}
+		switch (Record.Type)
+		{
+		case ERecordType::KeyName:
+			if (Keys.Num() <= Record.KeyIndex)
+			{
+				Keys.SetNum(Record.KeyIndex + 1);
+			}
+			Keys[Record.KeyIndex] = FKey(FName(*Record.Name));
+			break;
+		case ERecordType::InputKey:
+			if (Keys.IsValidIndex(Record.KeyIndex))
+			{
+				PlayerController->ReplayInputKey(Keys[Record.KeyIndex], (EInputEvent)Record.EventType, Record.Value, Record.bGamepad);
+			}
+			break;
+		case ERecordType::InputAxis:
+			if (Keys.IsValidIndex(Record.KeyIndex))
+			{
+				PlayerController->ReplayInputAxis(Keys[Record.KeyIndex], Record.Value, Record.DeltaTime, Record.NumSamples, Record.bGamepad);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void AReplayRecorder::CheckRecord(const FRecord& Actual)
+{
+	FMemoryReader Reader(LogData);
+	Reader.Seek(CheckOffset);
+	FRecord Expected;
+	bool bFound = false;
+	while (ReadRecord(Reader, Expected))
+	{
+		if (Expected.Type == ERecordType::Possess || Expected.Type == ERecordType::Spawn)
+		{
+			bFound = true;
+			break;
+		}
+	}
+	CheckOffset = Reader.Tell();
+
+	const bool bMatches = bFound && Expected.Type == Actual.Type && Expected.Frame == Actual.Frame && Expected.Name == Actual.Name
+		&& Expected.Location.Equals(Actual.Location, 1.f) && (Actual.Type != ERecordType::Spawn || FMath::IsNearlyEqual(Expected.Value, Actual.Value, 0.01f));
+	if (!bMatches)
+	{
+		if (NumDivergences < MaxLoggedDivergences)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Replay: diverged at frame %u, %s %s at %s, log has %s"), Actual.Frame,
+				Actual.Type == ERecordType::Spawn ? TEXT("spawn from") : TEXT("possessed"), *Actual.Name, *Actual.Location.ToString(),
+				bFound ? *FString::Printf(TEXT("%s at %s on frame %u"), *Expected.Name, *Expected.Location.ToString(), Expected.Frame) : TEXT("nothing more"));
+		}
+		NumDivergences++;
+	}
+}
+
+void AReplayRecorder::FinishPlayback()
+{
+	bFinished = true;
+
+	FString Csv = TEXT("Frame,FrameMs,GameThreadMs\n");
+	double TotalMs = 0.0;
+	TArray<int32> Hitches;
+	for (int32 i = 0; i < Samples.Num(); i++)
+	{
+		const FFrameSample& Sample = Samples[i];
+		Csv += FString::Printf(TEXT("%u,%.3f,%.3f\n"), Sample.Frame, Sample.FrameMs, Sample.GameThreadMs);
+		TotalMs += Sample.FrameMs;
+		if (Sample.GameThreadMs > HitchThresholdMs)
+		{
+			Hitches.Add(i);
+		}
+	}
+	FFileHelper::SaveStringToFile(Csv, *(ReplayPath + TEXT(".csv")));
+
+	double RecordedSeconds = 0.0;
+	for (float FrameDelta : FrameDeltas)
+	{
+		RecordedSeconds += FrameDelta;
+	}
+	UE_LOG(LogTemp, Log, TEXT("Replay: played %d frames (%.1f s of game time) in %.1f s, %d divergences, %d frames over %.0f ms. Timings written to %s.csv"),
+		Samples.Num(), RecordedSeconds, TotalMs / 1000.0, NumDivergences, Hitches.Num(), HitchThresholdMs, *ReplayPath);
+
+	// Worst first, these are the frames to profile
+	Hitches.Sort([this](int32 A, int32 B) { return Samples[A].GameThreadMs > Samples[B].GameThreadMs; });
+	for (int32 i = 0; i < Hitches.Num() && i < MaxLoggedHitches; i++)
+	{
+		const FFrameSample& Sample = Samples[Hitches[i]];
+		UE_LOG(LogTemp, Log, TEXT("    frame %u: game thread %.2f ms"), Sample.Frame, Sample.GameThreadMs);
+	}
+	UKismetSystemLibrary::QuitGame(this, nullptr, EQuitPreference::Quit);
+}
+
+int32 AReplayRecorder::GetFrameIndex() const
+{
+	return (int32)FrameIndex;
+}
+
+int32 AReplayRecorder::GetNumDivergences() const
+{
+	return NumDivergences;
+}
@@ -0,0 +1,193 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "ReplayRecorder.generated.h"
+
+class AFirstAttemptPlayerController;
+
+/**
+ * Records a session so it can be played back exactly, to reproduce and profile a reported hitch. The game mode
+ * spawns one when the game is started with either of:
+ *
+ *   -RecordReplay=Saved/Replays/Stutter.farp [-ReplaySeed=1234]
+ *   UE4Editor FirstAttempt.uproject <Map> -game -nullrhi -nosound -unattended -PlayReplay=Saved/Replays/Stutter.farp
+ *
+ * Recording seeds the random stream and streams the seed, the player's keys and axes, every frame's delta time,
+ * possessions and enemy spawns to a compact binary log. Playback seeds the stream the same way, feeds the recorded
+ * input back in on the same frames and runs every frame at its recorded delta time without waiting, so a session
+ * replays faster than real time. Possessions and spawns are checked against the log to catch the replay drifting.
+ * When the log runs out it writes the frame and game thread time of every frame next to the log and quits.
+ */
+UCLASS()
+class FIRSTATTEMPT_API AReplayRecorder : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AReplayRecorder();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Whether the command line asks for a replay to be recorded or played */
+	static bool IsRequested();
+
+	FORCEINLINE bool IsRecording() const { return Mode == EReplayMode::Recording; }
+
+	FORCEINLINE bool IsPlayingBack() const { return Mode == EReplayMode::Playback; }
+
+	/** Seed the random stream was started with */
+	FORCEINLINE int32 GetSeed() const { return Seed; }
+
+	/** Called by the player controller at the start of every PlayerTick, before it processes input */
+	void OnPlayerTick(AFirstAttemptPlayerController* PlayerController, float DeltaSeconds);
+
+	void RecordInputKey(const FKey& Key, EInputEvent EventType, float AmountDepressed, bool bGamepad);
+
+	void RecordInputAxis(const FKey& Key, float Delta, float DeltaTime, int32 NumSamples, bool bGamepad);
+
+	/** Logs a possession, or checks it against the log when playing back */
+	void RecordPossess(APawn* Pawn);
+
+	/** Logs an enemy spawn, or checks it against the log when playing back */
+	void RecordSpawn(AActor* Spawner, const FVector& Location, float Yaw);
+
+	/** Frames slower than this many milliseconds are listed in the log when playback finishes */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Replay")
+	float HitchThresholdMs;
+
+	/** Frames played back so far */
+	UFUNCTION(BlueprintPure, Category = "Replay")
+	int32 GetFrameIndex() const;
+
+	/** Spawns and possessions that didn't match the log during playback */
+	UFUNCTION(BlueprintPure, Category = "Replay")
+	int32 GetNumDivergences() const;
+
+private:
+	enum class EReplayMode : uint8
+	{
+		None,
+		Recording,
+		Playback
+	};
+
+	enum class ERecordType : uint8
+	{
+		/** One PlayerTick and its delta time */
+		Frame,
+		/** Gives a key a number, written the first time the key is used */
+		KeyName,
+		InputKey,
+		InputAxis,
+		Possess,
+		Spawn
+	};
+
+	/** Any record from the log. Only the fields its type uses are filled in */
+	struct FRecord
+	{
+		ERecordType Type;
+		uint32 Frame;
+		uint16 KeyIndex;
+		uint8 EventType;
+		bool bGamepad;
+		int32 NumSamples;
+		float Value;
+		float DeltaTime;
+		FString Name;
+		FVector Location;
+
+		FRecord()
+			: Type(ERecordType::Frame)
+			, Frame(0)
+			, KeyIndex(0)
+			, EventType(0)
+			, bGamepad(false)
+			, NumSamples(0)
+			, Value(0.f)
+			, DeltaTime(0.f)
+			, Location(FVector::ZeroVector)
+		{
+		}
+	};
+
+	struct FFrameSample
+	{
+		/** Recorded frame the sample was taken on */
+		uint32 Frame;
+		float FrameMs;
+		float GameThreadMs;
+	};
+
+	/** Writes the header, or reads it and indexes the frames */
+	bool StartRecording();
+	bool StartPlayback();
+
+	void WriteRecord(FRecord& Record);
+
+	/** Reads the record at Reader's position, returns false at the end of the log */
+	bool ReadRecord(FArchive& Reader, FRecord& OutRecord) const;
+
+	uint16 GetKeyIndex(const FKey& Key);
+
+	/** Feeds the controller every input recorded for the current frame */
+	void PlayFrameInput(AFirstAttemptPlayerController* PlayerController);
+
+	/** Compares a spawn or possession with the next one in the log */
+	void CheckRecord(const FRecord& Actual);
+
+	/** Writes the timing report and quits */
+	void FinishPlayback();
+
+	static void SerializeRecord(FArchive& Ar, FRecord& Record);
+
+	EReplayMode Mode;
+
+	FString ReplayPath;
+
+	int32 Seed;
+
+	/** PlayerTicks so far. Records are tagged with the tick they belong to */
+	uint32 FrameIndex;
+
+	/** Recording: streamed to disk as records come in */
+	FArchive* Writer;
+
+	/** Recording: key names already given a number */
+	TMap<FName, uint16> KeyIndices;
+
+	/** Playback: the whole log */
+	TArray<uint8> LogData;
+
+	/** Playback: keys by the numbers the log gave them */
+	TArray<FKey> Keys;
+
+	/** Playback: delta time of every recorded frame */
+	TArray<float> FrameDeltas;
+
+	/** Playback: where the next input to feed in is */
+	int64 InputOffset;
+
+	/** Playback: where the next spawn or possession to check is */
+	int64 CheckOffset;
+
+	int64 HeaderSize;
+
+	int32 NumDivergences;
+
+	TArray<FFrameSample> Samples;
+
+	double LastTickTime;
+
+	bool bFinished;
+
+	/** Fixed time step settings to put back after playback */
+	bool bSavedUseFixedTimeStep;
+
+	double SavedFixedDeltaTime;
+};
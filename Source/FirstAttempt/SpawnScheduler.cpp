@@ -0,0 +1,230 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "SpawnScheduler.h"
+#include "EnemySpawner.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Scheduler Tick"), STAT_SpawnSchedulerTick, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Queue Depth"), STAT_SpawnQueueDepth, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawns This Frame"), STAT_SpawnsThisFrame, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Budget Overruns"), STAT_SpawnBudgetOverruns, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Enemies"), STAT_LiveEnemies, STATGROUP_FirstAttempt);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Spawn Cost Per Enemy (ms)"), STAT_SpawnCostPerEnemy, STATGROUP_FirstAttempt);
+
+ASpawnScheduler::ASpawnScheduler()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	MaxLiveEnemies = 50;
+	MaxSpawnsPerFrame = 4;
+	SpawnBudgetMs = 2.f;
+	SpawnPointsRefreshedPerFrame = 8;
+	NumQueuedEnemies = 0;
+	RefreshIndex = 0;
+	SpawnsLastFrame = 0;
+	BudgetOverruns = 0;
+	SpawnCostPerEnemyMs = 0.f;
+}
+
+void ASpawnScheduler::SetSpawnerActive(AEnemySpawner* Spawner, bool bActive)
+{
+	if (Spawner == NULL)
+	{
+		return;
+	}
+	Spawners.RemoveAll([Spawner](const FScheduledSpawner& Scheduled) { return Scheduled.Spawner == Spawner; });
+	for (int32 i = SpawnQueue.Num() - 1; i >= 0; i--)
+	{
+		if (SpawnQueue[i].Spawner == Spawner)
+		{
+			NumQueuedEnemies -= SpawnQueue[i].NumEnemies;
+			SpawnQueue.RemoveAt(i);
+		}
+	}
+	if (bActive)
+	{
+		FScheduledSpawner Scheduled;
+		Scheduled.Spawner = Spawner;
+		Scheduled.NextSpawnTime = GetWorld()->GetTimeSeconds() + Spawner->GetRandomSpawnDelay();
+		Spawners.Add(Scheduled);
+	}
+	UpdateStats();
+}
+
+void ASpawnScheduler::Tick(float DeltaSeconds)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_SpawnSchedulerTick);
+	Super::Tick(DeltaSeconds);
+
+	PruneLiveEnemies();
+	QueueDueSpawns(GetWorld()->GetTimeSeconds());
+	RunQueuedSpawns();
+	RefreshSpawnPoints();
+	UpdateStats();
+}
+
+void ASpawnScheduler::QueueDueSpawns(float TimeSeconds)
+{
+	for (int32 i = Spawners.Num() - 1; i >= 0; i--)
+	{
+		FScheduledSpawner& Scheduled = Spawners[i];
+		AEnemySpawner *Spawner = Scheduled.Spawner.Get();
+		if (Spawner == NULL)
+		{
+			Spawners.RemoveAtSwap(i);
+			continue;
+		}
+		if (Scheduled.NextSpawnTime <= TimeSeconds)
+		{
+			// Don't let the queue grow past what the cap would allow anyway, the rest of the wave is dropped
+			const int32 NumEnemies = FMath::Min(Spawner->GetWaveSize(), MaxLiveEnemies - LiveEnemies.Num() - NumQueuedEnemies);
+			if (NumEnemies > 0)
+			{
+				FQueuedWave Wave;
+				Wave.Spawner = Spawner;
+				Wave.NumEnemies = NumEnemies;
+				SpawnQueue.Add(Wave);
+				NumQueuedEnemies += NumEnemies;
+			}
+			Scheduled.NextSpawnTime = TimeSeconds + Spawner->GetRandomSpawnDelay();
+		}
+	}
+}
+
+void ASpawnScheduler::RunQueuedSpawns()
+{
+	SpawnsLastFrame = 0;
+	SpawnCostPerEnemyMs = 0.f;
+	if (SpawnQueue.Num() == 0)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumHandled = 0;
+	int32 NumTried = 0;
+	TArray<AThirdPersonCharacter*> Spawned;
+	while (NumHandled < SpawnQueue.Num() && LiveEnemies.Num() < MaxLiveEnemies && NumTried < MaxSpawnsPerFrame)
+	{
+		FQueuedWave& Wave = SpawnQueue[NumHandled];
+		AEnemySpawner *Spawner = Wave.Spawner.Get();
+		if (Spawner == NULL)
+		{
+			NumQueuedEnemies -= Wave.NumEnemies;
+			NumHandled++;
+			continue;
+		}
+		// A wave stops where this frame's count runs out and carries on next frame
+		Spawned.Reset();
+		const int32 NumEnemies = FMath::Min3(Wave.NumEnemies, MaxLiveEnemies - LiveEnemies.Num(), MaxSpawnsPerFrame - NumTried);
+		Spawner->SpawnWave(NumEnemies, Spawned);
+		NumTried += NumEnemies;
+		Wave.NumEnemies -= NumEnemies;
+		NumQueuedEnemies -= NumEnemies;
+		for (AThirdPersonCharacter *Enemy : Spawned)
+		{
+			LiveEnemies.Add(Enemy);
+		}
+		SpawnsLastFrame += Spawned.Num();
+		if (Wave.NumEnemies > 0)
+		{
+			break;
+		}
+		NumHandled++;
+	}
+	SpawnQueue.RemoveAt(0, NumHandled);
+
+	// Waves the cap caught up with are dropped, like spawns queued while at the cap
+	if (LiveEnemies.Num() >= MaxLiveEnemies)
+	{
+		SpawnQueue.Reset();
+		NumQueuedEnemies = 0;
+	}
+
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+	if (NumTried > 0)
+	{
+		SpawnCostPerEnemyMs = Elapsed * 1000.0 / NumTried;
+	}
+	if (Elapsed > SpawnBudgetMs / 1000.0)
+	{
+		BudgetOverruns++;
+	}
+}
+
+void ASpawnScheduler::RefreshSpawnPoints()
+{
+	if (Spawners.Num() == 0 || SpawnPointsRefreshedPerFrame <= 0)
+	{
+		return;
+	}
+	RefreshIndex = RefreshIndex % Spawners.Num();
+	AEnemySpawner *Spawner = Spawners[RefreshIndex].Spawner.Get();
+	if (Spawner)
+	{
+		Spawner->RefreshSpawnPoints(SpawnPointsRefreshedPerFrame);
+	}
+	RefreshIndex++;
+}
+
+void ASpawnScheduler::PruneLiveEnemies()
+{
+	for (int32 i = LiveEnemies.Num() - 1; i >= 0; i--)
+	{
+		const AThirdPersonCharacter *Enemy = LiveEnemies[i].Get();
+		if (Enemy == NULL || Enemy->GetIsDead())
+		{
+			LiveEnemies.RemoveAtSwap(i);
+		}
+	}
+}
+
+int32 ASpawnScheduler::GetNumLiveEnemies() const
+{
+	return LiveEnemies.Num();
+}
+
+bool ASpawnScheduler::HasRoomForEnemy() const
+{
+	return LiveEnemies.Num() < MaxLiveEnemies;
+}
+
+void ASpawnScheduler::AddLiveEnemy(AThirdPersonCharacter* Enemy)
+{
+	LiveEnemies.AddUnique(Enemy);
+}
+
+void ASpawnScheduler::RemoveLiveEnemy(AThirdPersonCharacter* Enemy)
+{
+	LiveEnemies.RemoveSwap(Enemy);
+}
+
+int32 ASpawnScheduler::GetQueueDepth() const
+{
+	return NumQueuedEnemies;
+}
+
+float ASpawnScheduler::GetSpawnCostPerEnemyMs() const
+{
+	return SpawnCostPerEnemyMs;
+}
+
+int32 ASpawnScheduler::GetSpawnsLastFrame() const
+{
+	return SpawnsLastFrame;
+}
+
+int32 ASpawnScheduler::GetBudgetOverruns() const
+{
+	return BudgetOverruns;
+}
+
+void ASpawnScheduler::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_SpawnQueueDepth, NumQueuedEnemies);
+	SET_DWORD_STAT(STAT_SpawnsThisFrame, SpawnsLastFrame);
+	SET_DWORD_STAT(STAT_SpawnBudgetOverruns, BudgetOverruns);
+	SET_DWORD_STAT(STAT_LiveEnemies, LiveEnemies.Num());
+	SET_FLOAT_STAT(STAT_SpawnCostPerEnemy, SpawnCostPerEnemyMs);
+}
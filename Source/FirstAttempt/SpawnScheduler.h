@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Info.h"
+#include "SpawnScheduler.generated.h"
+
+class AEnemySpawner;
+class AThirdPersonCharacter;
+
+/**
+ * Decides when every AEnemySpawner in the world gets to spawn. Spawners register here instead of running
+ * their own timers. When a spawner is due its whole wave is queued, and waves are worked off a fixed number of
+ * enemies per frame, a wave that doesn't fit carrying on next frame. The count is fixed rather than timed so a
+ * seeded run or replay spawns the same enemies on the same frames every time. Nothing is spawned while the
+ * number of living enemies is at the cap. Spawners' spawn point caches are topped up a few points a frame.
+ */
+UCLASS()
+class FIRSTATTEMPT_API ASpawnScheduler : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	ASpawnScheduler();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Starts or stops scheduling spawns for the given spawner */
+	void SetSpawnerActive(AEnemySpawner* Spawner, bool bActive);
+
+	/** Enemies spawned by this scheduler, or added to it, that are still alive */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	int32 GetNumLiveEnemies() const;
+
+	/** Whether one more enemy would still be under MaxLiveEnemies */
+	bool HasRoomForEnemy() const;
+
+	/** Counts an enemy that didn't come from a spawner, such as a promoted crowd agent, against MaxLiveEnemies */
+	void AddLiveEnemy(AThirdPersonCharacter* Enemy);
+
+	/** Stops counting an enemy that is being put away without dying */
+	void RemoveLiveEnemy(AThirdPersonCharacter* Enemy);
+
+	/** Enemies in queued waves waiting their turn */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	int32 GetQueueDepth() const;
+
+	/** Average time taken to spawn one enemy last frame, in milliseconds */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	float GetSpawnCostPerEnemyMs() const;
+
+	/** Enemies spawned during the last tick */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	int32 GetSpawnsLastFrame() const;
+
+	/** Number of frames where spawning took longer than SpawnBudgetMs */
+	UFUNCTION(BlueprintPure, Category = "Spawning")
+	int32 GetBudgetOverruns() const;
+
+	/** Spawning stops while this many spawned enemies are alive */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Spawning")
+	int32 MaxLiveEnemies;
+
+	/** Most enemies spawned in one frame */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Spawning", meta = (ClampMin = "1"))
+	int32 MaxSpawnsPerFrame;
+
+	/** Frames that spend longer than this spawning, in milliseconds, are counted as overruns. Only a hint for tuning MaxSpawnsPerFrame */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Spawning")
+	float SpawnBudgetMs;
+
+	/** Spawn points rechecked or replaced per frame, one spawner a frame in turn */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Spawning")
+	int32 SpawnPointsRefreshedPerFrame;
+
+private:
+	struct FScheduledSpawner
+	{
+		TWeakObjectPtr<AEnemySpawner> Spawner;
+		float NextSpawnTime;
+	};
+
+	struct FQueuedWave
+	{
+		TWeakObjectPtr<AEnemySpawner> Spawner;
+		/** Enemies still to spawn */
+		int32 NumEnemies;
+	};
+
+	/** Queues a request for every spawner whose delay has run out */
+	void QueueDueSpawns(float TimeSeconds);
+
+	/** Spawns queued waves until the queue is empty, the cap is reached or MaxSpawnsPerFrame have been tried */
+	void RunQueuedSpawns();
+
+	/** Lets the next spawner in turn refresh its spawn points */
+	void RefreshSpawnPoints();
+
+	/** Forgets enemies that have died or been destroyed */
+	void PruneLiveEnemies();
+
+	void UpdateStats() const;
+
+	TArray<FScheduledSpawner> Spawners;
+
+	/** Waves waiting to be spawned, oldest first */
+	TArray<FQueuedWave> SpawnQueue;
+
+	/** Enemies in SpawnQueue */
+	int32 NumQueuedEnemies;
+
+	/** Next spawner in Spawners to refresh spawn points for */
+	int32 RefreshIndex;
+
+	TArray<TWeakObjectPtr<AThirdPersonCharacter>> LiveEnemies;
+
+	int32 SpawnsLastFrame;
+	int32 BudgetOverruns;
+	float SpawnCostPerEnemyMs;
+};
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "AutomationTest.h"
+#include "AirplaneFlightModel.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AirplaneFlightModelTest
+{
+	static const float FixedTimeStep = 1.f / 60.f;
+	static const int32 MaxSubSteps = 4;
+
+	/** Ten seconds of flight */
+	static const int32 NumSteps = 600;
+
+	/** The stick moves every StepsPerInput steps */
+	static const int32 StepsPerInput = 60;
+
+	FAirplaneInput GetInput(int32 StepIndex)
+	{
+		// Climb, bank both ways and cut the throttle, so every part of the model gets used
+		static const float Inputs[][3] =
+		{
+			{ 1.f, 0.f, 0.f },
+			{ 1.f, 0.5f, 0.f },
+			{ 1.f, 0.f, 1.f },
+			{ 0.f, -0.3f, 1.f },
+			{ 0.5f, 0.f, -1.f },
+			{ 1.f, 1.f, -0.5f },
+			{ 0.f, 0.f, 0.f },
+		};
+		const float *Values = Inputs[(StepIndex / StepsPerInput) % ARRAY_COUNT(Inputs)];
+		FAirplaneInput Input;
+		Input.Thrust = Values[0];
+		Input.MoveUp = Values[1];
+		Input.MoveRight = Values[2];
+		return Input;
+	}
+
+	/**
+	 * Flies NumSteps steps with frames of 1 / FrameRate seconds the way AAirplane::Tick does. Input is picked each
+	 * frame, so it only changes on a frame boundary, which every rate here has at each StepsPerInput step.
+	 * Returns false if the accumulator was ever left holding a whole step.
+	 */
+	bool Fly(float FrameRate, FAirplaneState& OutState)
+	{
+		const FAirplaneFlightParams Params;
+		FAirplaneState State;
+		FAirplaneState PreviousState;
+		float Accumulator = 0.f;
+		int32 StepsDone = 0;
+		bool bAccumulatorInRange = true;
+		while (StepsDone < NumSteps)
+		{
+			StepsDone += FAirplaneState::StepFixed(State, PreviousState, Accumulator, GetInput(StepsDone), Params, 1.f / FrameRate, FixedTimeStep, MaxSubSteps);
+			bAccumulatorInRange &= Accumulator >= 0.f && Accumulator < FixedTimeStep;
+		}
+		OutState = State;
+		return bAccumulatorInRange && StepsDone == NumSteps;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAirplaneFixedStepDeterminismTest, "FirstAttempt.Airplane.SameTrajectoryAt30And60And144Hz", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/** Flies the same stick inputs at three frame rates and checks the plane ends up in exactly the same place */
+bool FAirplaneFixedStepDeterminismTest::RunTest(const FString& Parameters)
+{
+	using namespace AirplaneFlightModelTest;
+
+	const float FrameRates[] = { 30.f, 60.f, 144.f };
+	FAirplaneState States[ARRAY_COUNT(FrameRates)];
+	for (int32 i = 0; i < ARRAY_COUNT(FrameRates); i++)
+	{
+		TestTrue(FString::Printf(TEXT("%.0f Hz ran %d steps and kept the accumulator under one step"), FrameRates[i], NumSteps), Fly(FrameRates[i], States[i]));
+	}
+	TestTrue(TEXT("The plane moved"), !States[0].Location.IsNearlyZero());
+
+	for (int32 i = 1; i < ARRAY_COUNT(FrameRates); i++)
+	{
+		// Exact, not nearly: the same steps with the same inputs have to give the same bits
+		const FAirplaneState& Expected = States[0];
+		const FAirplaneState& Actual = States[i];
+		const FString Rate = FString::Printf(TEXT("%.0f Hz against %.0f Hz"), FrameRates[i], FrameRates[0]);
+		TestTrue(Rate + TEXT(" location"), Actual.Location == Expected.Location);
+		TestTrue(Rate + TEXT(" rotation"), Actual.Rotation.X == Expected.Rotation.X && Actual.Rotation.Y == Expected.Rotation.Y && Actual.Rotation.Z == Expected.Rotation.Z && Actual.Rotation.W == Expected.Rotation.W);
+		TestTrue(Rate + TEXT(" speeds"), Actual.ForwardSpeed == Expected.ForwardSpeed && Actual.PitchSpeed == Expected.PitchSpeed && Actual.YawSpeed == Expected.YawSpeed && Actual.RollSpeed == Expected.RollSpeed);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAirplaneFixedStepHitchTest, "FirstAttempt.Airplane.HitchKeepsUnderOneStep", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/** A frame far longer than MaxSubSteps steps runs only MaxSubSteps and leaves less than a step for drawing */
+bool FAirplaneFixedStepHitchTest::RunTest(const FString& Parameters)
+{
+	using namespace AirplaneFlightModelTest;
+
+	const FAirplaneFlightParams Params;
+	FAirplaneState State;
+	FAirplaneState PreviousState;
+	float Accumulator = 0.f;
+	const int32 StepsRun = FAirplaneState::StepFixed(State, PreviousState, Accumulator, GetInput(0), Params, 1.f, FixedTimeStep, MaxSubSteps);
+	TestEqual(TEXT("Steps run in a one second frame"), StepsRun, MaxSubSteps);
+	TestTrue(TEXT("Accumulator under one step"), Accumulator >= 0.f && Accumulator < FixedTimeStep);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "FirstAttempt.h"
+
+/**
+ * An empty game world for automation tests that need to spawn actors. It has no game mode, so play is begun
+ * through the world settings, and it is torn down again when this goes out of scope.
+ */
+class FFirstAttemptTestWorld
+{
+public:
+	FFirstAttemptTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	~FFirstAttemptTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	UWorld* Get() const
+	{
+		return World;
+	}
+
+	template<class T>
+	T* Spawn(const FVector& Location = FVector::ZeroVector, const FRotator& Rotation = FRotator::ZeroRotator)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		return World->SpawnActor<T>(Location, Rotation, SpawnParams);
+	}
+
+	/** Runs one frame of DeltaSeconds */
+	void Tick(float DeltaSeconds)
+	{
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+	}
+
+private:
+	UWorld *World;
+};
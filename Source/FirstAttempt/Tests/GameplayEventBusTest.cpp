@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "AutomationTest.h"
+#include "FirstAttemptTestWorld.h"
+#include "GameplayEventBus.h"
+#include "Async/Async.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** An event type the game never publishes and the bus doesn't count as critical, for filling the queue with */
+static const EGameplayEventType TestEventType = (EGameplayEventType)0xFF;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayEventBusStressTest, "FirstAttempt.GameplayEventBus.MillionEventsFromWorkerThreads", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * Publishes a million events from the worker threads into a queue the size of the bus's default one while this
+ * thread drains it, and checks every one arrives. Producers retry when the queue is full, which also exercises
+ * the wrap around.
+ */
+bool FGameplayEventBusStressTest::RunTest(const FString& Parameters)
+{
+	static const int32 NumEvents = 1000000;
+
+	TMpscRingBuffer<FGameplayEvent> Queue(GetDefault<AGameplayEventBus>()->QueueCapacity);
+	const int32 NumProducers = FMath::Max(FPlatformMisc::NumberOfWorkerThreadsToSpawn(), 1);
+	const int32 EventsPerProducer = FMath::Max(NumEvents / NumProducers, 1);
+	const int32 TotalEvents = EventsPerProducer * NumProducers;
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<TFuture<void>> Producers;
+	for (int32 ProducerIndex = 0; ProducerIndex < NumProducers; ProducerIndex++)
+	{
+		Producers.Add(Async<void>(EAsyncExecution::ThreadPool, [&Queue, EventsPerProducer]()
+		{
+			const FGameplayEvent TestEvent(TestEventType, nullptr, nullptr);
+			for (int32 i = 0; i < EventsPerProducer; i++)
+			{
+				while (!Queue.Enqueue(TestEvent))
+				{
+					FPlatformProcess::Yield();
+				}
+			}
+		}));
+	}
+
+	int32 NumReceived = 0;
+	int32 NumWrongType = 0;
+	int32 MaxDepth = 0;
+	FGameplayEvent Event;
+	while (NumReceived < TotalEvents)
+	{
+		MaxDepth = FMath::Max(MaxDepth, Queue.Num());
+		if (Queue.Dequeue(Event))
+		{
+			NumWrongType += Event.Type != TestEventType;
+			NumReceived++;
+		}
+		else
+		{
+			FPlatformProcess::Yield();
+		}
+	}
+	for (TFuture<void>& Producer : Producers)
+	{
+		Producer.Wait();
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+	AddLogItem(FString::Printf(TEXT("%d events from %d threads in %.1f ms (%.1f M events/s), peak queue depth %d of %d"),
+		NumReceived, NumProducers, Seconds * 1000.0, Seconds > 0.0 ? NumReceived / Seconds / 1000000.0 : 0.0, MaxDepth, Queue.GetCapacity()));
+	TestEqual(TEXT("Events received"), NumReceived, TotalEvents);
+	TestEqual(TEXT("Events left in the queue"), Queue.Num(), 0);
+	TestEqual(TEXT("Events that came out changed"), NumWrongType, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayEventBusOverflowTest, "FirstAttempt.GameplayEventBus.CriticalEventsSurviveFullQueue", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/** Fills the queue, then checks a PlayerKilled still reaches consumers while a non critical event is dropped */
+bool FGameplayEventBusOverflowTest::RunTest(const FString& Parameters)
+{
+	FFirstAttemptTestWorld World;
+	AGameplayEventBus *EventBus = World.Spawn<AGameplayEventBus>();
+	if (!TestNotNull(TEXT("Event bus spawned"), EventBus))
+	{
+		return false;
+	}
+
+	int32 NumPlayerKilled = 0;
+	int32 NumEvents = 0;
+	bool bPlayerKilledLast = false;
+	EventBus->OnGameplayEvents().AddLambda([&](const TArray<FGameplayEvent>& Events)
+	{
+		for (const FGameplayEvent& Event : Events)
+		{
+			NumEvents++;
+			NumPlayerKilled += Event.Type == EGameplayEventType::PlayerKilled;
+		}
+		bPlayerKilledLast = Events.Num() > 0 && Events.Last().Type == EGameplayEventType::PlayerKilled;
+	});
+
+	const int32 Capacity = EventBus->QueueCapacity;
+	for (int32 i = 0; i < Capacity; i++)
+	{
+		EventBus->Publish(FGameplayEvent(TestEventType, nullptr, nullptr));
+	}
+	TestFalse(TEXT("Non critical event published to a full queue"), EventBus->Publish(FGameplayEvent(TestEventType, nullptr, nullptr)));
+	TestTrue(TEXT("PlayerKilled published to a full queue"), EventBus->Publish(FGameplayEvent(EGameplayEventType::PlayerKilled, nullptr, nullptr)));
+
+	// Drain the way the bus does once a frame
+	EventBus->Tick(0.f);
+	TestEqual(TEXT("PlayerKilled events handed to consumers"), NumPlayerKilled, 1);
+	TestTrue(TEXT("PlayerKilled came after the queued events"), bPlayerKilledLast);
+	TestEqual(TEXT("Events handed to consumers"), NumEvents, Capacity + 1);
+	TestEqual(TEXT("Events dropped"), EventBus->GetNumDropped(), 1);
+	TestEqual(TEXT("Events overflowed"), EventBus->GetNumOverflowed(), 1);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "AutomationTest.h"
+#include "FirstAttemptTestWorld.h"
+#include "GameFramework/DefaultPawn.h"
+#include "AIController.h"
+#include "PossessableRegistry.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** What FindNearestPossessable should return, found by looking at every pawn */
+static APawn* FindNearestByScan(const TArray<ADefaultPawn*>& Pawns, const FVector& Location, float Radius, const APawn* Ignore)
+{
+	APawn *Nearest = NULL;
+	float NearestDistanceSq = FMath::Square(Radius);
+	for (ADefaultPawn *Pawn : Pawns)
+	{
+		if (Pawn == Ignore)
+		{
+			continue;
+		}
+		const float DistanceSq = Pawn->GetRootComponent()->Bounds.GetBox().ComputeSquaredDistanceToPoint(Location);
+		if (DistanceSq <= NearestDistanceSq)
+		{
+			Nearest = Pawn;
+			NearestDistanceSq = DistanceSq;
+		}
+	}
+	return Nearest;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPossessableRegistryNearestTest, "FirstAttempt.PossessableRegistry.NearestMatchesScan", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/** Scatters pawns over many cells, moves some of them about, and checks every lookup against a scan of all of them */
+bool FPossessableRegistryNearestTest::RunTest(const FString& Parameters)
+{
+	static const int32 NumPawns = 200;
+	static const int32 NumQueries = 500;
+	static const float Extent = 5000.f;
+	static const float Radius = 300.f;
+
+	FFirstAttemptTestWorld World;
+	APossessableRegistry *Registry = World.Spawn<APossessableRegistry>();
+	if (!TestNotNull(TEXT("Registry spawned"), Registry))
+	{
+		return false;
+	}
+
+	FRandomStream Random(1);
+	TArray<ADefaultPawn*> Pawns;
+	for (int32 i = 0; i < NumPawns; i++)
+	{
+		ADefaultPawn *Pawn = World.Spawn<ADefaultPawn>(FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), 0.f));
+		if (!TestNotNull(TEXT("Pawn spawned"), Pawn))
+		{
+			return false;
+		}
+		Registry->AddPossessable(Pawn);
+		Pawns.Add(Pawn);
+	}
+
+	// Some pawns change cell and some leave, which the registry only notices when it ticks
+	for (int32 i = 0; i < NumPawns / 4; i++)
+	{
+		Pawns[i]->SetActorLocation(FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), 0.f));
+	}
+	for (int32 i = 0; i < NumPawns / 10; i++)
+	{
+		Registry->RemovePossessable(Pawns.Last());
+		Pawns.Pop();
+	}
+	Registry->Tick(0.f);
+
+	int32 NumFound = 0;
+	for (int32 Query = 0; Query < NumQueries; Query++)
+	{
+		// Half the queries start next to a pawn, which is how SwitchPawns asks
+		const APawn *Ignore = (Query % 2 == 0) ? Pawns[Random.RandHelper(Pawns.Num())] : NULL;
+		const FVector Location = Ignore ? Ignore->GetActorLocation() + FVector(Random.FRandRange(-Radius, Radius), Random.FRandRange(-Radius, Radius), 0.f)
+			: FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), 0.f);
+		APawn *Expected = FindNearestByScan(Pawns, Location, Radius, Ignore);
+		APawn *Found = Registry->FindNearestPossessable(Location, Radius, Ignore);
+		if (Found != Expected)
+		{
+			AddError(FString::Printf(TEXT("Query %d at %s found %s, expected %s"), Query, *Location.ToString(),
+				Found ? *Found->GetName() : TEXT("nothing"), Expected ? *Expected->GetName() : TEXT("nothing")));
+		}
+		NumFound += Found ? 1 : 0;
+	}
+	TestTrue(TEXT("Some queries found a pawn"), NumFound > 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPossessableRegistryHandoffTest, "FirstAttempt.PossessableRegistry.Handoff", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/** Switches a controller between pawns and checks it only ever lands in the nearest one in reach */
+bool FPossessableRegistryHandoffTest::RunTest(const FString& Parameters)
+{
+	FFirstAttemptTestWorld World;
+	APossessableRegistry *Registry = World.Spawn<APossessableRegistry>();
+	ADefaultPawn *From = World.Spawn<ADefaultPawn>(FVector::ZeroVector);
+	ADefaultPawn *Near = World.Spawn<ADefaultPawn>(FVector(120.f, 0.f, 0.f));
+	ADefaultPawn *Farther = World.Spawn<ADefaultPawn>(FVector(0.f, -125.f, 0.f));
+	ADefaultPawn *OutOfReach = World.Spawn<ADefaultPawn>(FVector(-400.f, 0.f, 0.f));
+	AAIController *Controller = World.Spawn<AAIController>();
+	if (!TestNotNull(TEXT("Registry spawned"), Registry) || !TestNotNull(TEXT("Controller spawned"), Controller)
+		|| !From || !Near || !Farther || !OutOfReach)
+	{
+		return false;
+	}
+	Registry->AddPossessable(From);
+	Registry->AddPossessable(Near);
+	Registry->AddPossessable(Farther);
+	Registry->AddPossessable(OutOfReach);
+
+	TestFalse(TEXT("Switch without a controller"), Registry->SwitchPawns(From));
+
+	Controller->Possess(From);
+	TestTrue(TEXT("Switch from the first pawn"), Registry->SwitchPawns(From));
+	TestTrue(TEXT("Controller moved into the nearest pawn"), Controller->GetPawn() == Near);
+	TestNull(TEXT("First pawn let go"), From->GetController());
+
+	// From is now the nearest to Near, so switching straight back is a round trip
+	TestTrue(TEXT("Switch back"), Registry->SwitchPawns(Near));
+	TestTrue(TEXT("Controller back in the first pawn"), Controller->GetPawn() == From);
+
+	// With Near gone the next nearest in reach is taken, never the one out of reach
+	Registry->RemovePossessable(Near);
+	TestTrue(TEXT("Switch with the nearest pawn gone"), Registry->SwitchPawns(From));
+	TestTrue(TEXT("Controller moved into the next nearest pawn"), Controller->GetPawn() == Farther);
+
+	// A pawn that walks into reach is found once the registry has ticked
+	Registry->RemovePossessable(From);
+	OutOfReach->SetActorLocation(FVector(0.f, -250.f, 0.f));
+	Registry->Tick(0.f);
+	TestTrue(TEXT("Switch to a pawn that moved into reach"), Registry->SwitchPawns(Farther));
+	TestTrue(TEXT("Controller moved into the pawn that came closer"), Controller->GetPawn() == OutOfReach);
+
+	Registry->RemovePossessable(Farther);
+	TestFalse(TEXT("Switch with nothing in reach"), Registry->SwitchPawns(OutOfReach));
+	TestTrue(TEXT("Controller stayed put"), Controller->GetPawn() == OutOfReach);
+	TestEqual(TEXT("Switches counted"), Registry->GetNumSwitches(), 4);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
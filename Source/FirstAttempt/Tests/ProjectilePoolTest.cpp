@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "AutomationTest.h"
+#include "FirstAttemptTestWorld.h"
+#include "ProjectilePool.h"
+#include "Projectile.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FProjectilePoolZeroSpawnTest, "FirstAttempt.ProjectilePool.ZeroSpawnsOverTenThousandShots", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/** Fires 10000 shots with a steady number in flight and checks none of them needed a new actor once the pool was warm */
+bool FProjectilePoolZeroSpawnTest::RunTest(const FString& Parameters)
+{
+	static const int32 NumShots = 10000;
+	static const int32 MaxInFlight = 64;
+
+	FFirstAttemptTestWorld World;
+	AProjectilePool *Pool = World.Spawn<AProjectilePool>();
+	if (!TestNotNull(TEXT("Pool spawned"), Pool))
+	{
+		return false;
+	}
+	const int32 NumWarmedUp = Pool->GetNumSpawned();
+	TestTrue(TEXT("Pool warmed up enough for the test"), NumWarmedUp >= MaxInFlight);
+
+	// Shots come back in the order they were fired, as they would with a fixed flight time
+	TArray<AProjectile*> InFlight;
+	for (int32 Shot = 0; Shot < NumShots; Shot++)
+	{
+		if (InFlight.Num() == MaxInFlight)
+		{
+			Pool->ReleaseProjectile(InFlight[0]);
+			InFlight.RemoveAt(0, 1, false);
+		}
+		AProjectile *Projectile = Pool->AcquireProjectile(FVector(0.f, 0.f, 1000.f), FRotator::ZeroRotator);
+		if (!TestNotNull(TEXT("Projectile handed out"), Projectile))
+		{
+			return false;
+		}
+		InFlight.Add(Projectile);
+	}
+	TestEqual(TEXT("Projectiles in flight"), Pool->GetNumActive(), MaxInFlight);
+
+	for (AProjectile *Projectile : InFlight)
+	{
+		Pool->ReleaseProjectile(Projectile);
+	}
+	TestEqual(TEXT("Projectiles spawned after warm up"), Pool->GetNumSpawned() - NumWarmedUp, 0);
+	TestEqual(TEXT("Pool misses"), Pool->GetMissCount(), 0);
+	TestEqual(TEXT("Projectiles in flight after all came back"), Pool->GetNumActive(), 0);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstAttempt.h"
+#include "AutomationTest.h"
+#include "FirstAttemptTestWorld.h"
+#include "ThirdPersonVehicle.h"
+#include "WheeledVehicleMovementComponent4W.h"
+#include "Components/TextRenderComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** What every vehicle tick used to do for the HUD: format both strings and push them to the text renders */
+static void UpdateHUDEveryTick(AThirdPersonVehicle* Vehicle)
+{
+	const int32 KPH = FMath::FloorToInt(FMath::Abs(Vehicle->GetVehicleMovement()->GetForwardSpeed()) * 0.036f);
+	const FText SpeedText = FText::Format(NSLOCTEXT("VehiclePawn", "SpeedFormat", "{0} km/h"), FText::AsNumber(KPH));
+	const int32 Gear = Vehicle->GetVehicleMovement()->GetCurrentGear();
+	const FText GearText = (Gear < 0) ? NSLOCTEXT("VehiclePawn", "ReverseGear", "R") : ((Gear == 0) ? NSLOCTEXT("VehiclePawn", "N", "N") : FText::AsNumber(Gear));
+	Vehicle->GetInCarSpeed()->SetText(SpeedText);
+	Vehicle->GetInCarGear()->SetText(GearText);
+	Vehicle->GetInCarGear()->SetTextRenderColor(FColor::White);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVehicleHUDTickCostTest, "FirstAttempt.Vehicle.HUDTickCost", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * Ticks a driven vehicle at a steady speed and gear and checks the in-car HUD is left alone, then that the car
+ * goes dormant once nobody drives it. The tick is timed as it is now and with the HUD work every tick used to do,
+ * for the log only: timings on a shared machine are too noisy to pass or fail on.
+ */
+bool FVehicleHUDTickCostTest::RunTest(const FString& Parameters)
+{
+	static const int32 NumTicks = 20000;
+	static const int32 NumRuns = 5;
+	static const float DeltaSeconds = 1.f / 60.f;
+	static const float MaxSecondsToDormant = 60.f;
+
+	FFirstAttemptTestWorld World;
+	AThirdPersonVehicle *Vehicle = World.Spawn<AThirdPersonVehicle>(FVector(0.f, 0.f, 100.f));
+	APlayerController *Driver = World.Spawn<APlayerController>();
+	if (!TestNotNull(TEXT("Vehicle spawned"), Vehicle) || !TestNotNull(TEXT("Driver spawned"), Driver) || !TestNotNull(TEXT("Speed text"), Vehicle->GetInCarSpeed()) || !TestNotNull(TEXT("Gear text"), Vehicle->GetInCarGear()))
+	{
+		return false;
+	}
+	// A driven car never goes dormant, and the in-car HUD is only pushed for a player in the in-car view
+	Driver->Possess(Vehicle);
+	if (!Vehicle->bInCarCameraActive)
+	{
+		Vehicle->OnToggleCamera();
+	}
+	Vehicle->Tick(DeltaSeconds);
+
+	// Something the vehicle would never show, which stays up as long as the HUD isn't refreshed
+	const FText Marker = FText::FromString(TEXT("Not refreshed"));
+	Vehicle->GetInCarSpeed()->SetText(Marker);
+
+	// Best of a few runs each, so a context switch in one of them doesn't skew the log
+	double BestAfter = MAX_dbl;
+	for (int32 Run = 0; Run < NumRuns; Run++)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumTicks; i++)
+		{
+			Vehicle->Tick(DeltaSeconds);
+		}
+		BestAfter = FMath::Min(BestAfter, FPlatformTime::Seconds() - StartTime);
+	}
+	TestFalse(TEXT("A driven car stays awake"), Vehicle->GetIsDormant());
+	TestTrue(TEXT("The HUD isn't refreshed while speed and gear stay the same"), Vehicle->GetInCarSpeed()->Text.EqualTo(Marker));
+
+	double BestBefore = MAX_dbl;
+	for (int32 Run = 0; Run < NumRuns; Run++)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumTicks; i++)
+		{
+			Vehicle->Tick(DeltaSeconds);
+			UpdateHUDEveryTick(Vehicle);
+		}
+		BestBefore = FMath::Min(BestBefore, FPlatformTime::Seconds() - StartTime);
+	}
+
+	const double BeforeUs = BestBefore * 1000000.0 / NumTicks;
+	const double AfterUs = BestAfter * 1000000.0 / NumTicks;
+	AddLogItem(FString::Printf(TEXT("Vehicle tick: %.3fus formatting the HUD every tick, %.3fus updating it on change (%.1fx)"),
+		BeforeUs, AfterUs, AfterUs > 0.0 ? BeforeUs / AfterUs : 0.0));
+
+	// Left alone and at rest, the car should go to sleep
+	Driver->UnPossess();
+	for (float Elapsed = 0.f; Elapsed < MaxSecondsToDormant && !Vehicle->GetIsDormant(); Elapsed += DeltaSeconds)
+	{
+		Vehicle->Tick(DeltaSeconds);
+	}
+	TestTrue(TEXT("A parked car nobody drives goes dormant"), Vehicle->GetIsDormant());
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -1,463 +1,872 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-
-#include "FirstAttempt.h"
-#include "Kismet/HeadMountedDisplayFunctionLibrary.h"
-#include "Kismet/GameplayStatics.h"
-#include "Perception/PawnSensingComponent.h"
-#include "Blueprint/UserWidget.h"
-#include "ThirdPersonCharacter.h"
-#include "ThirdPersonVehicle.h"
-#include "Projectile.h"
-#include "EnemyController.h"
-#include "FirstAttemptGameModeBase.h"
-
-//////////////////////////////////////////////////////////////////////////
-// AThirdPersonCharacter
-
-AThirdPersonCharacter::AThirdPersonCharacter()
-{
-	// Set size for collision capsule
-	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
-
-	static ConstructorHelpers::FObjectFinder<USkeletalMesh> CarMesh(TEXT("/Game/Mannequin/Character/Mesh/SK_Mannequin.SK_Mannequin"));
-	GetMesh()->SetSkeletalMesh(CarMesh.Object);
-
-	static ConstructorHelpers::FClassFinder<UObject> AnimBPClass(TEXT("/Game/Mannequin/Animations/ThirdPerson_AnimBP"));
-	GetMesh()->SetAnimInstanceClass(AnimBPClass.Class);
-
-	// set our turn rates for input
-	BaseTurnRate = 45.f;
-	BaseLookUpRate = 45.f;
-
-	// Don't rotate when the controller rotates. Let that just affect the camera.
-	bUseControllerRotationPitch = false;
-	bUseControllerRotationYaw = false;
-	bUseControllerRotationRoll = false;
-
-	// Configure character movement
-	GetCharacterMovement()->bOrientRotationToMovement = true; // Character moves in the direction of input...	
-	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f); // ...at this rotation rate
-	GetCharacterMovement()->JumpZVelocity = 600.f;
-	GetCharacterMovement()->AirControl = 0.2f;
-
-	FirstPersonCameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
-	FirstPersonCameraComponent->SetupAttachment(RootComponent);
-	FirstPersonCameraComponent->RelativeLocation = FVector(-40,-15, 70); // Position the camera
-	//FirstPersonCameraComponent->SetupAttachment(GetMesh(), FName("head"));
-	//FirstPersonCameraComponent->RelativeLocation = FVector(25, 0, 0);
-	FirstPersonCameraComponent->bUsePawnControlRotation = true;
-
-	// Create a camera boom (pulls in towards the player if there is a collision)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->TargetArmLength = 300.0f; // The camera follows at this distance behind the character	
-	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
-
-												// Create a follow camera
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
-	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
-
-												   // Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
-												   // are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
-
-	Sensor = CreateDefaultSubobject<USphereComponent>(TEXT("Sensor"));
-	Sensor->SetSphereRadius(0, true);
-	Sensor->SetupAttachment(GetMesh());
-
-	//GetMesh()->AttachTo(RootComponent);
-	
-	//GetMesh()->OnComponentHit.AddDynamic(this, &AThirdPersonCharacter::OnHit);
-	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &AThirdPersonCharacter::OnOverlap);
-
-	bIsShooting = false;
-	bIsDead = false;
-	bIsAiming = false;
-	//GunOffset = FVector(150.f, -50.f, 50.f);
-	FireRate = 0.3f;
-
-	PawnSensingComponent = CreateDefaultSubobject<UPawnSensingComponent>(TEXT("PawnSensingComponent"));
-	//Set the peripheral vision angle to 90 degrees
-	PawnSensingComponent->SetPeripheralVisionAngle(90.f);
-
-	GetCharacterMovement()->MaxWalkSpeed = 1200;
-}
-
-//////////////////////////////////////////////////////////////////////////
-// Input
-
-void AThirdPersonCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
-{
-	// Set up gameplay key bindings
-	check(PlayerInputComponent);
-
-	PlayerInputComponent->BindAction("SwitchCamera", IE_Pressed, this, &AThirdPersonCharacter::ChangePOV);
-
-	PlayerInputComponent->BindAction("Aim", IE_Pressed, this, &AThirdPersonCharacter::SetOverShoulderPOV);
-	PlayerInputComponent->BindAction("Aim", IE_Released, this, &AThirdPersonCharacter::SetThirdPersonPOV);
-
-	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
-
-	PlayerInputComponent->BindAction("Sprint", IE_Pressed, this, &AThirdPersonCharacter::Sprint);
-	PlayerInputComponent->BindAction("Sprint", IE_Released, this, &AThirdPersonCharacter::StopSprinting);
-
-	PlayerInputComponent->BindAction("Shoot", IE_Pressed, this, &AThirdPersonCharacter::StartShooting);
-	PlayerInputComponent->BindAction("Shoot", IE_Released, this, &AThirdPersonCharacter::StopShooting);
-
-	PlayerInputComponent->BindAxis("HumanMoveForward", this, &AThirdPersonCharacter::MoveForward);
-	PlayerInputComponent->BindAxis("HumanMoveRight", this, &AThirdPersonCharacter::MoveRight);
-
-	PlayerInputComponent->BindAction("SwitchPawns", IE_Pressed, this, &AThirdPersonCharacter::SwitchPawns);
-
-	// We have 2 versions of the rotation bindings to handle different kinds of devices differently
-	// "turn" handles devices that provide an absolute delta, such as a mouse.
-	// "turnrate" is for devices that we choose to treat as a rate of change, such as an analog joystick
-	PlayerInputComponent->BindAxis("Turn", this, &APawn::AddControllerYawInput);
-	PlayerInputComponent->BindAxis("TurnRate", this, &AThirdPersonCharacter::TurnAtRate);
-	PlayerInputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
-	PlayerInputComponent->BindAxis("LookUpRate", this, &AThirdPersonCharacter::LookUpAtRate);
-
-	// handle touch devices
-	PlayerInputComponent->BindTouch(IE_Pressed, this, &AThirdPersonCharacter::TouchStarted);
-	PlayerInputComponent->BindTouch(IE_Released, this, &AThirdPersonCharacter::TouchStopped);
-
-	// VR headset functionality
-	PlayerInputComponent->BindAction("ResetVR", IE_Pressed, this, &AThirdPersonCharacter::OnResetVR);
-}
-
-void AThirdPersonCharacter::BeginPlay()
-{
-	Super::BeginPlay();
-	SetThirdPersonPOV();
-	//Register the function that is going to fire when the character sees a Pawn
-	if (PawnSensingComponent)
-	{
-		PawnSensingComponent->OnSeePawn.AddDynamic(this, &AThirdPersonCharacter::OnSeePlayer);
-	}
-	/*
-	if (HUDWidgetClass != nullptr)
-	{
-		CurrentWidget = CreateWidget<UUserWidget>(GetWorld(), HUDWidgetClass);
-		if (CurrentWidget != nullptr)
-		{
-			CurrentWidget->AddToViewport();
-		}
-	}
-	*/
-}
-
-
-void AThirdPersonCharacter::OnResetVR()
-{
-	UHeadMountedDisplayFunctionLibrary::ResetOrientationAndPosition();
-}
-
-void AThirdPersonCharacter::TouchStarted(ETouchIndex::Type FingerIndex, FVector Location)
-{
-	Jump();
-}
-
-void AThirdPersonCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVector Location)
-{
-	StopJumping();
-}
-
-void AThirdPersonCharacter::TurnAtRate(float Rate)
-{
-	// calculate delta for this frame from the rate information
-	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
-}
-
-void AThirdPersonCharacter::LookUpAtRate(float Rate)
-{
-	// calculate delta for this frame from the rate information
-	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
-}
-
-void AThirdPersonCharacter::MoveForward(float Value)
-{
-	if ((Controller != NULL) && (Value != 0.0f))
-	{
-		// find out which way is forward
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// get forward vector
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
-		AddMovementInput(Direction, Value);
-	}
-}
-
-void AThirdPersonCharacter::MoveRight(float Value)
-{
-	if ((Controller != NULL) && (Value != 0.0f))
-	{
-		// find out which way is right
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// get right vector 
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
-		// add movement in that direction
-		AddMovementInput(Direction, Value);
-	}
-}
-
-void AThirdPersonCharacter::SwitchPawns()
-{
-	TArray<AActor*> OverlappingActors;
-	Sensor->GetOverlappingActors(OverlappingActors);
-	for (int i = 0; i < OverlappingActors.Num(); i++)
-	{
-		//UE_LOG(LogTemp, Warning, TEXT("Fuck"));
-		APawn *Pawn = Cast<APawn>(OverlappingActors[i]);
-		if (Pawn && Pawn != this)
-		{
-			//UE_LOG(LogTemp, Warning, TEXT("Ass"));
-			AController* TempController = GetController();
-			if (TempController)
-			{
-				//UE_LOG(LogTemp, Warning, TEXT("Bitch"));
-				TempController->UnPossess();
-				TempController->Possess(Pawn);
-				AThirdPersonCharacter *Character = Cast<AThirdPersonCharacter>(Pawn);
-				if (Character)
-				{
-					Character->GetUp();
-				}
-				/*
-				else
-				{
-					AThirdPersonVehicle *Vehicle = Cast<AThirdPersonVehicle>(Pawn);
-					if (Vehicle)
-					{
-						GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Vehicle, ECR_Ignore);
-						GetMesh()->AttachTo(Vehicle->GetMesh());
-						GetMesh()->RelativeLocation.Set(50, 50, 200);
-						GetMesh()->SetSimulatePhysics(true);
-					}
-				}
-				*/
-			}
-			break;
-		}
-	}
-}
-
-void AThirdPersonCharacter::Sprint()
-{
-	GetCharacterMovement()->MaxWalkSpeed = 2400;
-}
-
-void AThirdPersonCharacter::StopSprinting()
-{
-	GetCharacterMovement()->MaxWalkSpeed = 1200;
-}
-
-void AThirdPersonCharacter::OnOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
-{
-	//UE_LOG(LogTemp, Warning, TEXT("Your message"));
-	if ((OverlappedComp != NULL) && (OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL) && OtherActor->GetVelocity().Size() > 30.0f)
-	{
-		StopShooting();
-		GetCharacterMovement()->DisableMovement();
-		GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Vehicle, ECR_Ignore);
-		GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
-		GetMesh()->SetSimulatePhysics(true);
-		//GetMesh()->SetAllBodiesBelowSimulatePhysics(GetMesh()->GetBoneName(1), true);
-		AFirstAttemptGameModeBase *GameMode = Cast<AFirstAttemptGameModeBase>(GetWorld()->GetAuthGameMode());
-		if (this == UGameplayStatics::GetPlayerPawn(this, 0))
-		{
-			GetWorld()->GetTimerManager().SetTimer(GetUpHandle, this, &AThirdPersonCharacter::GetUp, 4, true);
-			if (GameMode)
-			{
-				GameMode->EndGame();
-			}
-		}
-		else if (!this->bIsDead)
-		{
-			if (GameMode)
-			{
-				GameMode->IncrementKillCount(1);
-			}
-		}
-		bIsDead = true;
-	}
-}
-
-void AThirdPersonCharacter::GetUp()
-{
-	if (!bIsDead && GetMesh()->IsSimulatingPhysics() && GetMesh()->GetPhysicsLinearVelocity().Size() == 0)
-	{
-		FRotator Rotation;
-		Rotation.Yaw = -90;
-		Rotation.Pitch = 0;
-		Rotation.Roll = 0;
-		GetMesh()->SetSimulatePhysics(false);
-		GetMesh()->SetRelativeRotation(Rotation);
-		//GetMesh()->RemoveFromRoot();
-		//GetCapsuleComponent()->SetWorldLocation(FVector(GetCapsuleComponent()->RelativeLocation.X + GetMesh()->RelativeLocation.X, GetCapsuleComponent()->RelativeLocation.Y + GetMesh()->RelativeLocation.Y, GetCapsuleComponent()->RelativeLocation.Z + GetMesh()->RelativeLocation.Z));
-		GetCapsuleComponent()->SetWorldLocation(FVector(GetMesh()->RelativeLocation.X, GetMesh()->RelativeLocation.Y, GetMesh()->RelativeLocation.Z + 90));
-		GetMesh()->RelativeLocation.Set(0, 0, -90);
-		GetMesh()->AttachTo(RootComponent);
-		GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Vehicle, ECR_Block);
-		GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Block);
-		GetWorld()->GetTimerManager().ClearTimer(GetUpHandle);
-		/*
-		static ConstructorHelpers::FObjectFinder<UAnimSequence> anim(TEXT("AnimSequence'/Game/Mannequin/Animations/ThirdPerson_GetUp.ThirdPerson_GetUp'"));
-		static UAnimSequence *Anim = anim.Object;
-		GetMesh()->PlayAnimation(Anim, false);
-		*/
-	}
-}
-
-bool AThirdPersonCharacter::GetIsShooting()
-{
-	return bIsShooting;
-}
-
-bool AThirdPersonCharacter::GetIsAiming()
-{
-	return bIsAiming;
-}
-/*
-void AThirdPersonCharacter::SetIsShooting(bool NewIsShooting)
-{
-	bIsShooting = NewIsShooting;
-}
-*/
-void AThirdPersonCharacter::StartShooting()
-{
-	bIsShooting = true;
-	//CameraBoom->TargetArmLength = 0;
-	GetCharacterMovement()->bUseControllerDesiredRotation = true;
-	GetCharacterMovement()->bOrientRotationToMovement = false;
-	GetWorld()->GetTimerManager().SetTimer(ShootingHandle, this, &AThirdPersonCharacter::FireShot, FireRate, true);
-}
-
-void AThirdPersonCharacter::StopShooting()
-{
-	bIsShooting = false;
-	//CameraBoom->TargetArmLength = 300.0f;
-	/*
-	if (FollowCamera->IsActive())
-	{
-		GetCharacterMovement()->bUseControllerDesiredRotation = false;
-		GetCharacterMovement()->bOrientRotationToMovement = true;
-	}
-	*/
-	//GetWorld()->GetTimerManager().ClearTimer(ShootingHandle);
-}
-
-
-
-void AThirdPersonCharacter::FireShot()
-{
-	//UE_LOG(LogTemp, Warning, TEXT("%d"), bIsShooting);
-	// If it's ok to fire again
-	if (!bIsDead)
-	{
-		FRotator FireRotation = GetControlRotation();
-
-		FRotator ProjectileRotation(0, FireRotation.Yaw, 0);
-
-		FVector SpawnLocation = GetMesh()->GetBoneLocation(FName("hand_l")) + ProjectileRotation.RotateVector(FVector(50, 0, 0));
-
-		//FVector SpawnLocation = GetActorLocation() + ProjectileRotation.RotateVector(GunOffset);
-
-		UWorld* World = GetWorld();
-		if (World != NULL)
-		{
-			// spawn the projectile
-			AProjectile *Projectile = World->SpawnActor<AProjectile>(SpawnLocation, FireRotation);
-			/*
-			Projectile->GetProjectileMesh()->SetupAttachment(GetMesh(), FName("hand_l"));
-			Projectile->GetProjectileMesh()->RelativeLocation.Set(10, 0, 0);
-			Projectile->GetProjectileMesh()->DetachFromParent();
-			*/
-		}
-		/*
-		// try and play the sound if specified
-		if (FireSound != nullptr)
-		{
-			UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
-		}
-		*/
-		if (!bIsShooting)
-		{
-			GetWorld()->GetTimerManager().ClearTimer(ShootingHandle);
-			if (FollowCamera->IsActive())
-			{
-				GetCharacterMovement()->bUseControllerDesiredRotation = false;
-				GetCharacterMovement()->bOrientRotationToMovement = true;
-			}
-		}
-	}
-}
-
-void AThirdPersonCharacter::ChangePOV()
-{
-	if (FirstPersonCameraComponent->IsActive())
-	{
-		FirstPersonCameraComponent->Deactivate();
-		FollowCamera->Activate();
-		if (!bIsShooting)
-		{
-			GetCharacterMovement()->bUseControllerDesiredRotation = false;
-			GetCharacterMovement()->bOrientRotationToMovement = true;
-		}
-		/*
-		if (CurrentWidget)
-		{
-			CurrentWidget->RemoveFromParent();
-		}
-		*/
-	}
-	else
-	{
-		FirstPersonCameraComponent->Activate();
-		FollowCamera->Deactivate();
-		GetCharacterMovement()->bUseControllerDesiredRotation = true;
-		GetCharacterMovement()->bOrientRotationToMovement = false;
-		/*
-		if (HUDWidgetClass != nullptr)
-		{
-			CurrentWidget = CreateWidget<UUserWidget>(GetWorld(), HUDWidgetClass);
-			if (CurrentWidget != nullptr && !CurrentWidget->IsVisible())
-			{
-				CurrentWidget->AddToViewport();
-			}
-		}
-		*/
-	}
-}
-
-void AThirdPersonCharacter::SetOverShoulderPOV()
-{
-	if (FollowCamera->IsActive())
-	{
-		bIsAiming = true;
-		ChangePOV();
-	}
-}
-
-void AThirdPersonCharacter::SetThirdPersonPOV()
-{
-	if (FirstPersonCameraComponent->IsActive())
-	{
-		bIsAiming = false;
-		ChangePOV();
-	}
-}
-
-void AThirdPersonCharacter::OnSeePlayer(APawn* Pawn)
-{
-	AEnemyController *EnemyController = Cast<AEnemyController>(GetController());
-	if (!bIsDead && EnemyController && Pawn == UGameplayStatics::GetPlayerPawn(this, 0))
-	{
-		EnemyController->SetFocus(Pawn);
-		EnemyController->MoveToActor(Pawn);
-		StartShooting();
-	}
-}
\ No newline at end of file
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "FirstAttempt.h"
+#include "Kismet/HeadMountedDisplayFunctionLibrary.h"
+#include "Kismet/GameplayStatics.h"
+#include "Blueprint/UserWidget.h"
+#include "Net/UnrealNetwork.h"
+#include "ThirdPersonCharacter.h"
+#include "ThirdPersonVehicle.h"
+#include "Projectile.h"
+#include "ProjectilePool.h"
+#include "BulletManager.h"
+#include "EnemyController.h"
+#include "FirstAttemptGameModeBase.h"
+#include "GameplayEventBus.h"
+#include "PerceptionManager.h"
+#include "EnemySignificanceManager.h"
+#include "PossessableRegistry.h"
+#include "MuzzleCache.h"
+#include "FireScheduler.h"
+#include "ContentPreloader.h"
+#include "FirstAttemptStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("FireShot"), STAT_FireShot, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("Character OnOverlap"), STAT_CharacterOnOverlap, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("OnSeePlayer"), STAT_OnSeePlayer, STATGROUP_FirstAttempt);
+
+//////////////////////////////////////////////////////////////////////////
+// AThirdPersonCharacter
+
+AThirdPersonCharacter::AThirdPersonCharacter()
+{
+	// Set size for collision capsule
+	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
+
+	// Soft references, streamed in by the content preloader and applied in OnConstruction
+	CharacterMeshAsset = TAssetPtr<USkeletalMesh>(FStringAssetReference(TEXT("/Game/Mannequin/Character/Mesh/SK_Mannequin.SK_Mannequin")));
+	AnimClassAsset = TAssetSubclassOf<UAnimInstance>(FStringAssetReference(TEXT("/Game/Mannequin/Animations/ThirdPerson_AnimBP.ThirdPerson_AnimBP_C")));
+
+	// set our turn rates for input
+	BaseTurnRate = 45.f;
+	BaseLookUpRate = 45.f;
+
+	// Don't rotate when the controller rotates. Let that just affect the camera.
+	bUseControllerRotationPitch = false;
+	bUseControllerRotationYaw = false;
+	bUseControllerRotationRoll = false;
+
+	// Configure character movement
+	GetCharacterMovement()->bOrientRotationToMovement = true; // Character moves in the direction of input...	
+	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f); // ...at this rotation rate
+	GetCharacterMovement()->JumpZVelocity = 600.f;
+	GetCharacterMovement()->AirControl = 0.2f;
+
+	// The cameras and boom are only created once a player possesses the character, on the server and on that
+	// player's machine. See CreatePlayerComponents
+	FirstPersonCameraComponent = NULL;
+	CameraBoom = NULL;
+	FollowCamera = NULL;
+
+												   // Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
+												   // are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
+
+	//GetMesh()->AttachTo(RootComponent);
+	
+	//GetMesh()->OnComponentHit.AddDynamic(this, &AThirdPersonCharacter::OnHit);
+	GetCapsuleComponent()->OnComponentBeginOverlap.AddDynamic(this, &AThirdPersonCharacter::OnOverlap);
+
+	bIsShooting = false;
+	bIsDead = false;
+	EventBus = NULL;
+	SignificanceManager = NULL;
+	MuzzleSlot = INDEX_NONE;
+	FireTicket = INDEX_NONE;
+	LastShotTime = -BIG_NUMBER;
+	bIsAiming = false;
+	//GunOffset = FVector(150.f, -50.f, 50.f);
+	FireRate = 0.3f;
+
+	GetCharacterMovement()->MaxWalkSpeed = 1200;
+	AIControllerClass = AEnemyController::StaticClass();
+
+	// Only clients within a few screens of a character hear about it, and quiet characters are sent less often.
+	// The significance manager lowers NetUpdateFrequency further for enemies far from the player
+	NetCullDistanceSquared = FMath::Square(15000.f);
+	NetUpdateFrequency = 30.f;
+	MinNetUpdateFrequency = 2.f;
+}
+
+void AThirdPersonCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	// The owner already knows whether it is shooting
+	DOREPLIFETIME_CONDITION(AThirdPersonCharacter, bIsShooting, COND_SkipOwner);
+	DOREPLIFETIME(AThirdPersonCharacter, bIsDead);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Input
+
+void AThirdPersonCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
+{
+	// Set up gameplay key bindings
+	check(PlayerInputComponent);
+
+	PlayerInputComponent->BindAction("SwitchCamera", IE_Pressed, this, &AThirdPersonCharacter::ChangePOV);
+
+	PlayerInputComponent->BindAction("Aim", IE_Pressed, this, &AThirdPersonCharacter::SetOverShoulderPOV);
+	PlayerInputComponent->BindAction("Aim", IE_Released, this, &AThirdPersonCharacter::SetThirdPersonPOV);
+
+	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
+	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
+
+	PlayerInputComponent->BindAction("Sprint", IE_Pressed, this, &AThirdPersonCharacter::Sprint);
+	PlayerInputComponent->BindAction("Sprint", IE_Released, this, &AThirdPersonCharacter::StopSprinting);
+
+	PlayerInputComponent->BindAction("Shoot", IE_Pressed, this, &AThirdPersonCharacter::StartShooting);
+	PlayerInputComponent->BindAction("Shoot", IE_Released, this, &AThirdPersonCharacter::StopShooting);
+
+	PlayerInputComponent->BindAxis("HumanMoveForward", this, &AThirdPersonCharacter::MoveForward);
+	PlayerInputComponent->BindAxis("HumanMoveRight", this, &AThirdPersonCharacter::MoveRight);
+
+	PlayerInputComponent->BindAction("SwitchPawns", IE_Pressed, this, &AThirdPersonCharacter::SwitchPawns);
+
+	// We have 2 versions of the rotation bindings to handle different kinds of devices differently
+	// "turn" handles devices that provide an absolute delta, such as a mouse.
+	// "turnrate" is for devices that we choose to treat as a rate of change, such as an analog joystick
+	PlayerInputComponent->BindAxis("Turn", this, &APawn::AddControllerYawInput);
+	PlayerInputComponent->BindAxis("TurnRate", this, &AThirdPersonCharacter::TurnAtRate);
+	PlayerInputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
+	PlayerInputComponent->BindAxis("LookUpRate", this, &AThirdPersonCharacter::LookUpAtRate);
+
+	// handle touch devices
+	PlayerInputComponent->BindTouch(IE_Pressed, this, &AThirdPersonCharacter::TouchStarted);
+	PlayerInputComponent->BindTouch(IE_Released, this, &AThirdPersonCharacter::TouchStopped);
+
+	// VR headset functionality
+	PlayerInputComponent->BindAction("ResetVR", IE_Pressed, this, &AThirdPersonCharacter::OnResetVR);
+}
+
+void AThirdPersonCharacter::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	// Leave alone anything a blueprint or the level has already set
+	if (GetMesh()->SkeletalMesh == NULL)
+	{
+		GetMesh()->SetSkeletalMesh(AContentPreloader::Resolve(CharacterMeshAsset));
+	}
+	if (GetMesh()->AnimClass == NULL)
+	{
+		GetMesh()->SetAnimInstanceClass(AContentPreloader::Resolve(AnimClassAsset));
+	}
+}
+
+void AThirdPersonCharacter::GetContentAssets(TArray<FStringAssetReference>& OutAssets) const
+{
+	OutAssets.AddUnique(CharacterMeshAsset.ToStringReference());
+	OutAssets.AddUnique(AnimClassAsset.ToStringReference());
+}
+
+void AThirdPersonCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AThirdPersonCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+	SetThirdPersonPOV();
+	//Register with the perception manager so OnSeePlayer fires when the character sees the player, with the significance manager for update LOD and with the possessable registry for SwitchPawns
+	SetRegisteredWithManagers(true);
+	// Clients and levels run with another game mode have no context, or a context without a game mode yet
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	EventBus = GameMode ? GameMode->GetGameplayEventBus() : NULL;
+	/*
+	if (HUDWidgetClass != nullptr)
+	{
+		CurrentWidget = CreateWidget<UUserWidget>(GetWorld(), HUDWidgetClass);
+		if (CurrentWidget != nullptr)
+		{
+			CurrentWidget->AddToViewport();
+		}
+	}
+	*/
+}
+
+void AThirdPersonCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// When the whole world is going away the manager goes with it, so only unregister on a plain destroy
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		SetRegisteredWithManagers(false);
+		StopShooting();
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AThirdPersonCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+	if (NewController && NewController->IsPlayerController())
+	{
+		CreatePlayerComponents();
+	}
+}
+
+void AThirdPersonCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+	// PossessedBy only runs on the server, this is where a remote client's own player gets its cameras
+	if (IsLocallyControlled())
+	{
+		CreatePlayerComponents();
+	}
+}
+
+void AThirdPersonCharacter::CreatePlayerComponents()
+{
+	if (FollowCamera != NULL)
+	{
+		return;
+	}
+
+	FirstPersonCameraComponent = NewObject<UCameraComponent>(this, TEXT("FirstPersonCamera"));
+	FirstPersonCameraComponent->SetupAttachment(RootComponent);
+	FirstPersonCameraComponent->RelativeLocation = FVector(-40,-15, 70); // Position the camera
+	//FirstPersonCameraComponent->SetupAttachment(GetMesh(), FName("head"));
+	//FirstPersonCameraComponent->RelativeLocation = FVector(25, 0, 0);
+	FirstPersonCameraComponent->bUsePawnControlRotation = true;
+	FirstPersonCameraComponent->bAutoActivate = false; // Start in third person
+	FirstPersonCameraComponent->RegisterComponent();
+
+	// Create a camera boom (pulls in towards the player if there is a collision)
+	CameraBoom = NewObject<USpringArmComponent>(this, TEXT("CameraBoom"));
+	CameraBoom->SetupAttachment(RootComponent);
+	CameraBoom->TargetArmLength = 300.0f; // The camera follows at this distance behind the character	
+	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	CameraBoom->RegisterComponent();
+
+	// Create a follow camera
+	FollowCamera = NewObject<UCameraComponent>(this, TEXT("FollowCamera"));
+	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
+	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+	FollowCamera->RegisterComponent();
+
+	bIsAiming = false;
+}
+
+void AThirdPersonCharacter::TickActor(float DeltaTime, ELevelTick TickType, FActorTickFunction& ThisTickFunction)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	Super::TickActor(DeltaTime, TickType, ThisTickFunction);
+	if (SignificanceManager)
+	{
+		SignificanceManager->AddMeasuredTick(FPlatformTime::Cycles() - StartCycles);
+	}
+}
+
+void AThirdPersonCharacter::SetRegisteredWithManagers(bool bRegistered)
+{
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APerceptionManager *PerceptionManager = GameMode ? GameMode->GetPerceptionManager() : NULL;
+	if (PerceptionManager)
+	{
+		if (bRegistered)
+		{
+			PerceptionManager->AddPerceiver(this);
+		}
+		else
+		{
+			PerceptionManager->RemovePerceiver(this);
+		}
+	}
+	SignificanceManager = GameMode ? GameMode->GetSignificanceManager() : NULL;
+	if (SignificanceManager)
+	{
+		if (bRegistered)
+		{
+			SignificanceManager->AddCharacter(this);
+		}
+		else
+		{
+			SignificanceManager->RemoveCharacter(this);
+			SignificanceManager = NULL;
+		}
+	}
+	APossessableRegistry *PossessableRegistry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+	if (PossessableRegistry)
+	{
+		if (bRegistered)
+		{
+			PossessableRegistry->AddPossessable(this);
+		}
+		else
+		{
+			PossessableRegistry->RemovePossessable(this);
+		}
+	}
+}
+
+void AThirdPersonCharacter::OnResetVR()
+{
+	UHeadMountedDisplayFunctionLibrary::ResetOrientationAndPosition();
+}
+
+void AThirdPersonCharacter::TouchStarted(ETouchIndex::Type FingerIndex, FVector Location)
+{
+	Jump();
+}
+
+void AThirdPersonCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVector Location)
+{
+	StopJumping();
+}
+
+void AThirdPersonCharacter::TurnAtRate(float Rate)
+{
+	// calculate delta for this frame from the rate information
+	AddControllerYawInput(Rate * BaseTurnRate * (GameplayContext.IsValid() ? GameplayContext->GetDeltaSeconds() : GetWorld()->GetDeltaSeconds()));
+}
+
+void AThirdPersonCharacter::LookUpAtRate(float Rate)
+{
+	// calculate delta for this frame from the rate information
+	AddControllerPitchInput(Rate * BaseLookUpRate * (GameplayContext.IsValid() ? GameplayContext->GetDeltaSeconds() : GetWorld()->GetDeltaSeconds()));
+}
+
+void AThirdPersonCharacter::MoveForward(float Value)
+{
+	if ((Controller != NULL) && (Value != 0.0f))
+	{
+		// find out which way is forward
+		const FRotator Rotation = Controller->GetControlRotation();
+		const FRotator YawRotation(0, Rotation.Yaw, 0);
+
+		// get forward vector
+		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
+		AddMovementInput(Direction, Value);
+	}
+}
+
+void AThirdPersonCharacter::MoveRight(float Value)
+{
+	if ((Controller != NULL) && (Value != 0.0f))
+	{
+		// find out which way is right
+		const FRotator Rotation = Controller->GetControlRotation();
+		const FRotator YawRotation(0, Rotation.Yaw, 0);
+
+		// get right vector 
+		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
+		// add movement in that direction
+		AddMovementInput(Direction, Value);
+	}
+}
+
+void AThirdPersonCharacter::SwitchPawns()
+{
+	if (Role < ROLE_Authority)
+	{
+		ServerSwitchPawns();
+		return;
+	}
+	// The registry keeps every possessable pawn in a grid, so this only looks at the few nearby
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APossessableRegistry *Registry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+	if (Registry)
+	{
+		Registry->SwitchPawns(this);
+	}
+}
+
+void AThirdPersonCharacter::ServerSwitchPawns_Implementation()
+{
+	SwitchPawns();
+}
+
+bool AThirdPersonCharacter::ServerSwitchPawns_Validate()
+{
+	return true;
+}
+
+void AThirdPersonCharacter::Sprint()
+{
+	GetCharacterMovement()->MaxWalkSpeed = 2400;
+}
+
+void AThirdPersonCharacter::StopSprinting()
+{
+	GetCharacterMovement()->MaxWalkSpeed = 1200;
+}
+
+void AThirdPersonCharacter::OnOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_CharacterOnOverlap);
+	//UE_LOG(LogTemp, Warning, TEXT("Your message"));
+	// Only the server decides who goes down, clients ragdoll when bIsDead arrives. This also keeps the
+	// projectiles clients spawn for show from knocking anyone over
+	if (!HasAuthority())
+	{
+		return;
+	}
+	if ((OverlappedComp != NULL) && (OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL) && OtherActor->GetVelocity().Size() > 30.0f)
+	{
+		StopShooting();
+		KnockDown();
+		// Score, game over and corpses are handled by whoever listens on the event bus
+		if (IsPlayerControlled())
+		{
+			GetWorld()->GetTimerManager().SetTimer(GetUpHandle, this, &AThirdPersonCharacter::GetUp, 4, true);
+			if (EventBus)
+			{
+				EventBus->Publish(FGameplayEvent(EGameplayEventType::PlayerKilled, this, OtherActor));
+			}
+		}
+		else if (!this->bIsDead)
+		{
+			if (EventBus)
+			{
+				EventBus->Publish(FGameplayEvent(EGameplayEventType::EnemyKilled, this, OtherActor));
+			}
+		}
+		bIsDead = true;
+	}
+}
+
+void AThirdPersonCharacter::KnockDown()
+{
+	GetCharacterMovement()->DisableMovement();
+	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Vehicle, ECR_Ignore);
+	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+	GetMesh()->SetSimulatePhysics(true);
+	//GetMesh()->SetAllBodiesBelowSimulatePhysics(GetMesh()->GetBoneName(1), true);
+}
+
+void AThirdPersonCharacter::OnRep_IsDead()
+{
+	if (bIsDead)
+	{
+		KnockDown();
+	}
+	else
+	{
+		ResetRagdoll();
+	}
+}
+
+void AThirdPersonCharacter::GetUp()
+{
+	if (!bIsDead && GetMesh()->IsSimulatingPhysics() && GetMesh()->GetPhysicsLinearVelocity().Size() == 0)
+	{
+		FRotator Rotation;
+		Rotation.Yaw = -90;
+		Rotation.Pitch = 0;
+		Rotation.Roll = 0;
+		GetMesh()->SetSimulatePhysics(false);
+		GetMesh()->SetRelativeRotation(Rotation);
+		//GetMesh()->RemoveFromRoot();
+		//GetCapsuleComponent()->SetWorldLocation(FVector(GetCapsuleComponent()->RelativeLocation.X + GetMesh()->RelativeLocation.X, GetCapsuleComponent()->RelativeLocation.Y + GetMesh()->RelativeLocation.Y, GetCapsuleComponent()->RelativeLocation.Z + GetMesh()->RelativeLocation.Z));
+		GetCapsuleComponent()->SetWorldLocation(FVector(GetMesh()->RelativeLocation.X, GetMesh()->RelativeLocation.Y, GetMesh()->RelativeLocation.Z + 90));
+		GetMesh()->RelativeLocation.Set(0, 0, -90);
+		GetMesh()->AttachTo(RootComponent);
+		GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Vehicle, ECR_Block);
+		GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Block);
+		GetWorld()->GetTimerManager().ClearTimer(GetUpHandle);
+		/*
+		static ConstructorHelpers::FObjectFinder<UAnimSequence> anim(TEXT("AnimSequence'/Game/Mannequin/Animations/ThirdPerson_GetUp.ThirdPerson_GetUp'"));
+		static UAnimSequence *Anim = anim.Object;
+		GetMesh()->PlayAnimation(Anim, false);
+		*/
+	}
+}
+
+void AThirdPersonCharacter::ResetForReuse()
+{
+	GetWorld()->GetTimerManager().ClearTimer(GetUpHandle);
+	StopShooting();
+	bIsAiming = false;
+	bIsDead = false;
+	AEnemyController *EnemyController = Cast<AEnemyController>(Controller);
+	if (EnemyController)
+	{
+		EnemyController->ResetState();
+	}
+	else if (Controller != NULL)
+	{
+		Controller->StopMovement();
+	}
+
+	ResetRagdoll();
+	GetCharacterMovement()->bUseControllerDesiredRotation = false;
+	GetCharacterMovement()->bOrientRotationToMovement = true;
+
+	// Park it until a spawner needs it. Movement and sensing stay off so it doesn't fall or react while hidden
+	SetRegisteredWithManagers(false);
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+}
+
+void AThirdPersonCharacter::ResetRagdoll()
+{
+	// Undo the ragdoll the same way GetUp does
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetComponentTickEnabled(true);
+	GetMesh()->bPauseAnims = false;
+	GetMesh()->AttachTo(RootComponent);
+	GetMesh()->SetRelativeLocationAndRotation(FVector(0, 0, -90), FRotator(0, -90, 0));
+	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Vehicle, ECR_Block);
+	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECR_Block);
+}
+
+void AThirdPersonCharacter::Revive(const FVector& Location, const FRotator& Rotation)
+{
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+	SetRegisteredWithManagers(true);
+}
+
+bool AThirdPersonCharacter::GetIsShooting()
+{
+	return bIsShooting;
+}
+
+bool AThirdPersonCharacter::GetIsAiming()
+{
+	return bIsAiming;
+}
+/*
+void AThirdPersonCharacter::SetIsShooting(bool NewIsShooting)
+{
+	bIsShooting = NewIsShooting;
+}
+*/
+void AThirdPersonCharacter::StartShooting()
+{
+	bIsShooting = true;
+	//CameraBoom->TargetArmLength = 0;
+	GetCharacterMovement()->bUseControllerDesiredRotation = true;
+	GetCharacterMovement()->bOrientRotationToMovement = false;
+	if (Role < ROLE_Authority)
+	{
+		// Show our own shots straight away instead of waiting a round trip for the server's
+		if (IsLocallyControlled() && !GetWorldTimerManager().IsTimerActive(PredictedShotHandle))
+		{
+			const float FirstShotDelay = FMath::Max(LastShotTime + FireRate - GetWorld()->GetTimeSeconds(), 0.f);
+			GetWorldTimerManager().SetTimer(PredictedShotHandle, this, &AThirdPersonCharacter::FirePredictedShot, FMath::Max(FireRate, 0.01f), true, FirstShotDelay);
+		}
+		ServerSetShooting(true);
+		return;
+	}
+
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	// Already firing, keep the cadence rather than restarting it every time the enemy sees the player again
+	AFireScheduler *FireScheduler = GameMode ? GameMode->GetFireScheduler() : NULL;
+	if (FireScheduler && FireTicket == INDEX_NONE)
+	{
+		// Fire straight away unless the last shot was too recent
+		const float TimeSeconds = GetWorld()->GetTimeSeconds();
+		FireTicket = FireScheduler->StartFiring(this, FMath::Max(TimeSeconds, LastShotTime + FireRate));
+	}
+
+	// Have the muzzle position read with everyone else's after animation instead of looking it up every shot
+	AMuzzleCache *MuzzleCache = GameMode ? GameMode->GetMuzzleCache() : NULL;
+	if (MuzzleCache && MuzzleSlot == INDEX_NONE)
+	{
+		MuzzleSlot = MuzzleCache->AddShooter(GetMesh());
+	}
+}
+
+void AThirdPersonCharacter::ReleaseMuzzleSlot()
+{
+	if (MuzzleSlot == INDEX_NONE)
+	{
+		return;
+	}
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	AMuzzleCache *MuzzleCache = GameMode ? GameMode->GetMuzzleCache() : NULL;
+	if (MuzzleCache)
+	{
+		MuzzleCache->RemoveShooter(MuzzleSlot);
+	}
+	MuzzleSlot = INDEX_NONE;
+}
+
+FVector AThirdPersonCharacter::GetMuzzleLocation() const
+{
+	AFirstAttemptGameModeBase *GameMode = (GameplayContext.IsValid() && MuzzleSlot != INDEX_NONE) ? GameplayContext->GetGameMode() : NULL;
+	AMuzzleCache *MuzzleCache = GameMode ? GameMode->GetMuzzleCache() : NULL;
+	FVector Location;
+	if (MuzzleCache && MuzzleCache->GetMuzzleLocation(MuzzleSlot, Location))
+	{
+		return Location;
+	}
+	// Not read yet, the first shot after starting to shoot can land before the cache's first update
+	static const FName HandBoneName(TEXT("hand_l"));
+	return GetMesh()->GetBoneLocation(HandBoneName);
+}
+
+void AThirdPersonCharacter::StopShooting()
+{
+	bIsShooting = false;
+	//CameraBoom->TargetArmLength = 300.0f;
+	if (IsThirdPersonPOV())
+	{
+		GetCharacterMovement()->bUseControllerDesiredRotation = false;
+		GetCharacterMovement()->bOrientRotationToMovement = true;
+	}
+	if (Role < ROLE_Authority)
+	{
+		GetWorldTimerManager().ClearTimer(PredictedShotHandle);
+		// Destroyed and reused characters stop shooting on every machine, only the owner's input needs sending
+		if (IsLocallyControlled())
+		{
+			ServerSetShooting(false);
+		}
+		return;
+	}
+	if (FireTicket != INDEX_NONE)
+	{
+		AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+		AFireScheduler *FireScheduler = GameMode ? GameMode->GetFireScheduler() : NULL;
+		if (FireScheduler)
+		{
+			FireScheduler->StopFiring(FireTicket);
+		}
+		FireTicket = INDEX_NONE;
+	}
+	ReleaseMuzzleSlot();
+}
+
+
+
+void AThirdPersonCharacter::FireShot()
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_FireShot);
+	//UE_LOG(LogTemp, Warning, TEXT("%d"), bIsShooting);
+	// If it's ok to fire again
+	if (!bIsDead)
+	{
+		FRotator FireRotation;
+		FVector SpawnLocation;
+		GetShotStart(SpawnLocation, FireRotation);
+
+		//FVector SpawnLocation = GetActorLocation() + ProjectileRotation.RotateVector(GunOffset);
+
+		UWorld* World = GetWorld();
+		if (World != NULL)
+		{
+			// hand the shot to the bullet manager or take a projectile from the pool, falling back to spawning one
+			AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+			ABulletManager *BulletManager = (GameMode && GameMode->IsUsingBulletManager()) ? GameMode->GetBulletManager() : NULL;
+			AProjectilePool *ProjectilePool = (GameMode && BulletManager == NULL) ? GameMode->GetProjectilePool() : NULL;
+			if (BulletManager)
+			{
+				BulletManager->FireBullet(SpawnLocation, FireRotation, this);
+			}
+			else if (ProjectilePool)
+			{
+				ProjectilePool->AcquireProjectile(SpawnLocation, FireRotation);
+			}
+			else
+			{
+				World->SpawnActor<AProjectile>(SpawnLocation, FireRotation);
+			}
+			// Projectiles don't replicate, clients get the shot and fly their own copy
+			if (World->GetNetMode() != NM_Standalone)
+			{
+				MulticastFireShot(SpawnLocation, FireRotation);
+			}
+			/*
+			Projectile->GetProjectileMesh()->SetupAttachment(GetMesh(), FName("hand_l"));
+			Projectile->GetProjectileMesh()->RelativeLocation.Set(10, 0, 0);
+			Projectile->GetProjectileMesh()->DetachFromParent();
+			*/
+		}
+		/*
+		// try and play the sound if specified
+		if (FireSound != nullptr)
+		{
+			UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+		}
+		*/
+		LastShotTime = World ? World->GetTimeSeconds() : 0.f;
+	}
+}
+
+void AThirdPersonCharacter::GetShotStart(FVector& OutLocation, FRotator& OutRotation) const
+{
+	OutRotation = GetControlRotation();
+	FRotator ProjectileRotation(0, OutRotation.Yaw, 0);
+	OutLocation = GetMuzzleLocation() + ProjectileRotation.RotateVector(FVector(50, 0, 0));
+}
+
+void AThirdPersonCharacter::FirePredictedShot()
+{
+	UWorld* World = GetWorld();
+	if (bIsDead || World == NULL)
+	{
+		return;
+	}
+	FRotator FireRotation;
+	FVector SpawnLocation;
+	GetShotStart(SpawnLocation, FireRotation);
+	World->SpawnActor<AProjectile>(SpawnLocation, FireRotation);
+	LastShotTime = World->GetTimeSeconds();
+}
+
+void AThirdPersonCharacter::ServerSetShooting_Implementation(bool bShooting)
+{
+	if (bShooting)
+	{
+		StartShooting();
+	}
+	else
+	{
+		StopShooting();
+	}
+}
+
+bool AThirdPersonCharacter::ServerSetShooting_Validate(bool bShooting)
+{
+	return true;
+}
+
+void AThirdPersonCharacter::MulticastFireShot_Implementation(FVector_NetQuantize Location, FRotator Rotation)
+{
+	// The server already fired the real one, and the owning client predicted its own
+	if (HasAuthority() || IsLocallyControlled())
+	{
+		return;
+	}
+	UWorld* World = GetWorld();
+	if (World != NULL)
+	{
+		World->SpawnActor<AProjectile>(Location, Rotation);
+	}
+}
+
+bool AThirdPersonCharacter::IsThirdPersonPOV() const
+{
+	// Characters nobody has played have no cameras and behave as if in third person
+	return FollowCamera == NULL || FollowCamera->IsActive();
+}
+
+void AThirdPersonCharacter::ChangePOV()
+{
+	if (FirstPersonCameraComponent == NULL || FollowCamera == NULL)
+	{
+		return;
+	}
+	if (FirstPersonCameraComponent->IsActive())
+	{
+		FirstPersonCameraComponent->Deactivate();
+		FollowCamera->Activate();
+		if (!bIsShooting)
+		{
+			GetCharacterMovement()->bUseControllerDesiredRotation = false;
+			GetCharacterMovement()->bOrientRotationToMovement = true;
+		}
+		/*
+		if (CurrentWidget)
+		{
+			CurrentWidget->RemoveFromParent();
+		}
+		*/
+	}
+	else
+	{
+		FirstPersonCameraComponent->Activate();
+		FollowCamera->Deactivate();
+		GetCharacterMovement()->bUseControllerDesiredRotation = true;
+		GetCharacterMovement()->bOrientRotationToMovement = false;
+		/*
+		if (HUDWidgetClass != nullptr)
+		{
+			CurrentWidget = CreateWidget<UUserWidget>(GetWorld(), HUDWidgetClass);
+			if (CurrentWidget != nullptr && !CurrentWidget->IsVisible())
+			{
+				CurrentWidget->AddToViewport();
+			}
+		}
+		*/
+	}
+}
+
+void AThirdPersonCharacter::SetOverShoulderPOV()
+{
+	if (FollowCamera && FollowCamera->IsActive())
+	{
+		bIsAiming = true;
+		ChangePOV();
+	}
+}
+
+void AThirdPersonCharacter::SetThirdPersonPOV()
+{
+	if (FirstPersonCameraComponent && FirstPersonCameraComponent->IsActive())
+	{
+		bIsAiming = false;
+		ChangePOV();
+	}
+}
+
+void AThirdPersonCharacter::OnSeePlayer(APawn* Pawn)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_OnSeePlayer);
+	AEnemyController *EnemyController = Cast<AEnemyController>(GetController());
+	if (!bIsDead && EnemyController && GameplayContext.IsValid() && GameplayContext->IsPlayerPawn(Pawn))
+	{
+		EnemyController->OnSeeTarget(Pawn);
+	}
+}
+void AThirdPersonCharacter::ReportFootprint(UWorld* World)
+{
+	struct FFootprint
+	{
+		int32 Characters;
+		int32 Components;
+		int32 TickingComponents;
+		SIZE_T Bytes;
+	};
+	auto AddObject = [](FFootprint& Footprint, UObject* Object)
+	{
+		Footprint.Bytes += Object->GetClass()->GetStructureSize() + Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	};
+	FFootprint Player = {}, Enemy = {}, PlayerOnly = {};
+
+	for (TActorIterator<AThirdPersonCharacter> It(World); It; ++It)
+	{
+		AThirdPersonCharacter *Character = *It;
+		FFootprint& Footprint = Character->IsPlayerControlled() ? Player : Enemy;
+		Footprint.Characters++;
+		AddObject(Footprint, Character);
+		for (UActorComponent *Component : Character->GetComponents())
+		{
+			Footprint.Components++;
+			Footprint.TickingComponents += Component->IsComponentTickEnabled() ? 1 : 0;
+			AddObject(Footprint, Component);
+			if (Component == Character->FirstPersonCameraComponent || Component == Character->CameraBoom || Component == Character->FollowCamera)
+			{
+				PlayerOnly.Components++;
+				PlayerOnly.TickingComponents += Component->IsComponentTickEnabled() ? 1 : 0;
+				AddObject(PlayerOnly, Component);
+			}
+		}
+	}
+
+	auto LogRow = [](const TCHAR* Label, const FFootprint& Footprint)
+	{
+		const int32 Count = FMath::Max(Footprint.Characters, 1);
+		UE_LOG(LogTemp, Log, TEXT("    %-8s %4d characters, per character: %5.1f components, %5.1f ticking, %8.1f KB"), Label, Footprint.Characters,
+			(float)Footprint.Components / Count, (float)Footprint.TickingComponents / Count, Footprint.Bytes / 1024.0 / Count);
+	};
+	UE_LOG(LogTemp, Log, TEXT("Character footprint:"));
+	LogRow(TEXT("Player"), Player);
+	LogRow(TEXT("Enemy"), Enemy);
+	// What every enemy carried before the player only components were created on possession
+	UE_LOG(LogTemp, Log, TEXT("    Player only components: %d components, %d ticking, %.1f KB in total"), PlayerOnly.Components, PlayerOnly.TickingComponents, PlayerOnly.Bytes / 1024.0);
+}
+
+static FAutoConsoleCommandWithWorld CharacterFootprintCommand(
+	TEXT("FirstAttempt.CharacterFootprint"),
+	TEXT("Logs the components, ticking components and memory of player and enemy characters"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&AThirdPersonCharacter::ReportFootprint));
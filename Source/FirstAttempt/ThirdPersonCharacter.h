@@ -1,149 +1,245 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-#pragma once
-#include "GameFramework/Character.h"
-#include "ThirdPersonCharacter.generated.h"
-
-UCLASS(config = Game)
-class AThirdPersonCharacter : public ACharacter
-{
-	GENERATED_BODY()
-
-		UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-		class UCameraComponent* FirstPersonCameraComponent;
-
-		/** Camera boom positioning the camera behind the character */
-		UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-		class USpringArmComponent* CameraBoom;
-
-	/** Follow camera */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-		class UCameraComponent* FollowCamera;
-public:
-	AThirdPersonCharacter();
-
-	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
-		float BaseTurnRate;
-
-	/** Base look up/down rate, in deg/sec. Other scaling may affect final rate. */
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
-		float BaseLookUpRate;
-
-protected:
-
-	/** Resets HMD orientation in VR. */
-	void OnResetVR();
-
-	/** Called for forwards/backward input */
-	void MoveForward(float Value);
-
-	/** Called for side to side input */
-	void MoveRight(float Value);
-
-	/**
-	* Called via input to turn at a given rate.
-	* @param Rate	This is a normalized rate, i.e. 1.0 means 100% of desired turn rate
-	*/
-	void TurnAtRate(float Rate);
-
-	/**
-	* Called via input to turn look up/down at a given rate.
-	* @param Rate	This is a normalized rate, i.e. 1.0 means 100% of desired turn rate
-	*/
-	void LookUpAtRate(float Rate);
-
-	/** Handler for when a touch input begins. */
-	void TouchStarted(ETouchIndex::Type FingerIndex, FVector Location);
-
-	/** Handler for when a touch input stops. */
-	void TouchStopped(ETouchIndex::Type FingerIndex, FVector Location);
-
-	void SwitchPawns();
-
-protected:
-	// APawn interface
-	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
-	// End of APawn interface
-	virtual void BeginPlay();
-
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Aim", meta = (BlueprintProtected = "true"))
-	TSubclassOf<class UUserWidget> HUDWidgetClass;
-	UPROPERTY()
-	class UUserWidget *CurrentWidget;
-
-public:
-	/** Returns CameraBoom subobject **/
-	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
-	/** Returns FollowCamera subobject **/
-	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
-
-	UFUNCTION()
-	void Sprint();
-
-	UFUNCTION()
-	void StopSprinting();
-
-	UFUNCTION()
-	void OnOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-
-	UFUNCTION()
-	void GetUp();
-
-	UFUNCTION(BlueprintPure, Category = "Shooting")
-	bool GetIsShooting();
-
-	UFUNCTION(BlueprintPure, Category = "Shooting")
-	bool GetIsAiming();
-	/*
-	UFUNCTION(BlueprintCallable, Category = "Shooting")
-	void SetIsShooting(bool NewIsShooting);
-	*/
-	UFUNCTION()
-	void StartShooting();
-
-	UFUNCTION()
-	void StopShooting();
-
-	//UPROPERTY(Category = "Shooting", EditAnywhere, BlueprintReadWrite)
-	//FVector GunOffset;
-
-	/* How fast the weapon will fire */
-	UPROPERTY(Category = "Shooting", EditAnywhere, BlueprintReadWrite)
-	float FireRate;
-
-	UFUNCTION()
-	void FireShot();
-
-	UFUNCTION(BlueprintCallable, Category = "Camera")
-	void ChangePOV();
-
-	UFUNCTION(BlueprintCallable, Category = "Camera")
-	void SetOverShoulderPOV();
-
-	UFUNCTION(BlueprintCallable, Category = "Camera")
-	void SetThirdPersonPOV();
-
-private:
-	UPROPERTY()
-	class USphereComponent *Sensor;
-
-	struct FTimerHandle GetUpHandle;
-
-	struct FTimerHandle ShootingHandle;
-
-	UPROPERTY(EditAnywhere, Category = "Shooting")
-	bool bIsShooting;
-
-	UPROPERTY(EditAnywhere, Category = "Shooting")
-	bool bIsAiming;
-
-	UPROPERTY()
-	class UPawnSensingComponent *PawnSensingComponent;
-
-	UFUNCTION()
-	void OnSeePlayer(APawn *Pawn);
-
-	UPROPERTY()
-	bool bIsDead;
-};
-
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "GameFramework/Character.h"
+#include "GameplayContext.h"
+#include "PreloadedContent.h"
+#include "ThirdPersonCharacter.generated.h"
+
+UCLASS(config = Game)
+class AThirdPersonCharacter : public ACharacter, public IPreloadedContent
+{
+	GENERATED_BODY()
+
+		/** First person camera. Like the boom and follow camera, only created once a player possesses the character */
+		UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+		class UCameraComponent* FirstPersonCameraComponent;
+
+		/** Camera boom positioning the camera behind the character */
+		UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+		class USpringArmComponent* CameraBoom;
+
+	/** Follow camera */
+	UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+		class UCameraComponent* FollowCamera;
+public:
+	AThirdPersonCharacter();
+
+	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+		float BaseTurnRate;
+
+	/** Base look up/down rate, in deg/sec. Other scaling may affect final rate. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
+		float BaseLookUpRate;
+
+protected:
+
+	/** Resets HMD orientation in VR. */
+	void OnResetVR();
+
+	/** Called for forwards/backward input */
+	void MoveForward(float Value);
+
+	/** Called for side to side input */
+	void MoveRight(float Value);
+
+	/**
+	* Called via input to turn at a given rate.
+	* @param Rate	This is a normalized rate, i.e. 1.0 means 100% of desired turn rate
+	*/
+	void TurnAtRate(float Rate);
+
+	/**
+	* Called via input to turn look up/down at a given rate.
+	* @param Rate	This is a normalized rate, i.e. 1.0 means 100% of desired turn rate
+	*/
+	void LookUpAtRate(float Rate);
+
+	/** Handler for when a touch input begins. */
+	void TouchStarted(ETouchIndex::Type FingerIndex, FVector Location);
+
+	/** Handler for when a touch input stops. */
+	void TouchStopped(ETouchIndex::Type FingerIndex, FVector Location);
+
+	void SwitchPawns();
+
+	/** A client's SwitchPawns input, possession only happens on the server */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSwitchPawns();
+
+protected:
+	// APawn interface
+	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+	// End of APawn interface
+	virtual void OnConstruction(const FTransform& Transform) override;
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void PawnClientRestart() override;
+	virtual void TickActor(float DeltaTime, enum ELevelTick TickType, FActorTickFunction& ThisTickFunction) override;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Content", meta = (BlueprintProtected = "true"))
+	TAssetPtr<USkeletalMesh> CharacterMeshAsset;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Content", meta = (BlueprintProtected = "true"))
+	TAssetSubclassOf<UAnimInstance> AnimClassAsset;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Aim", meta = (BlueprintProtected = "true"))
+	TSubclassOf<class UUserWidget> HUDWidgetClass;
+	UPROPERTY()
+	class UUserWidget *CurrentWidget;
+
+public:
+	/** Returns CameraBoom subobject, null until a player has possessed the character **/
+	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
+	/** Returns FollowCamera subobject, null until a player has possessed the character **/
+	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+
+	UFUNCTION()
+	void Sprint();
+
+	UFUNCTION()
+	void StopSprinting();
+
+	UFUNCTION()
+	void OnOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	UFUNCTION()
+	void GetUp();
+
+	/** Puts a dead character back together and parks it hidden so it can be spawned again */
+	void ResetForReuse();
+
+	/** Brings a character parked by ResetForReuse back into play at the given transform */
+	void Revive(const FVector& Location, const FRotator& Rotation);
+
+	UFUNCTION(BlueprintPure, Category = "Shooting")
+	bool GetIsShooting();
+
+	UFUNCTION(BlueprintPure, Category = "Shooting")
+	bool GetIsAiming();
+
+	/** Adds the soft referenced content this character needs to the list, for the content preloader */
+	virtual void GetContentAssets(TArray<FStringAssetReference>& OutAssets) const override;
+
+	/** Has this character been knocked down for good */
+	FORCEINLINE bool GetIsDead() const { return bIsDead; }
+	/*
+	UFUNCTION(BlueprintCallable, Category = "Shooting")
+	void SetIsShooting(bool NewIsShooting);
+	*/
+	UFUNCTION()
+	void StartShooting();
+
+	UFUNCTION()
+	void StopShooting();
+
+	//UPROPERTY(Category = "Shooting", EditAnywhere, BlueprintReadWrite)
+	//FVector GunOffset;
+
+	/* How fast the weapon will fire */
+	UPROPERTY(Category = "Shooting", EditAnywhere, BlueprintReadWrite)
+	float FireRate;
+
+	/** Fires one shot. Called by the fire scheduler while the character is shooting */
+	UFUNCTION()
+	void FireShot();
+
+	/** A client's shoot input. The fire scheduler and pools only exist on the server */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSetShooting(bool bShooting);
+
+	/** Shows a shot the server fired on the other clients the character is relevant to, as a local projectile that does no damage */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastFireShot(FVector_NetQuantize Location, FRotator Rotation);
+
+	/** Ticket held with the fire scheduler while shooting, INDEX_NONE otherwise */
+	FORCEINLINE int32 GetFireTicket() const { return FireTicket; }
+
+	/** Where the muzzle cache keeps this character's muzzle while it shoots, INDEX_NONE otherwise */
+	FORCEINLINE int32 GetMuzzleSlot() const { return MuzzleSlot; }
+
+	/** Called by the perception manager while this character can see the player */
+	UFUNCTION()
+	void OnSeePlayer(APawn *Pawn);
+
+	UFUNCTION(BlueprintCallable, Category = "Camera")
+	void ChangePOV();
+
+	UFUNCTION(BlueprintCallable, Category = "Camera")
+	void SetOverShoulderPOV();
+
+	UFUNCTION(BlueprintCallable, Category = "Camera")
+	void SetThirdPersonPOV();
+
+	/** Logs the components, ticking components and memory of player and AI characters in World */
+	static void ReportFootprint(UWorld* World);
+
+private:
+	/** Creates the cameras and boom the first time a player possesses this character. Enemies never pay for them */
+	void CreatePlayerComponents();
+
+	/** Gives the muzzle cache slot back once the character stops shooting */
+	void ReleaseMuzzleSlot();
+
+	/** Where shots leave the hand, from the muzzle cache when it has it */
+	FVector GetMuzzleLocation() const;
+
+	/** Following from behind, or with no cameras at all */
+	bool IsThirdPersonPOV() const;
+
+	/** Adds or removes this character from the perception and significance managers and the possessable registry */
+	void SetRegisteredWithManagers(bool bRegistered);
+
+	struct FTimerHandle GetUpHandle;
+
+
+	UPROPERTY(EditAnywhere, Replicated, Category = "Shooting")
+	bool bIsShooting;
+
+	UPROPERTY(EditAnywhere, Category = "Shooting")
+	bool bIsAiming;
+
+	UPROPERTY(ReplicatedUsing = OnRep_IsDead)
+	bool bIsDead;
+
+	/** Ragdolls the character on clients when the server knocks it down, and puts it back together when it is reused */
+	UFUNCTION()
+	void OnRep_IsDead();
+
+	/** Turns the character into a ragdoll */
+	void KnockDown();
+
+	/** Undoes KnockDown */
+	void ResetRagdoll();
+
+	/** Player pawn, game mode and frame timing without going back to the world for them */
+	FGameplayContextHandle GameplayContext;
+
+	int32 FireTicket;
+
+	/** World time of the last shot, so starting again can't beat the fire rate */
+	float LastShotTime;
+
+	/** On the owning client, spawns a projectile for show at the fire rate while shooting */
+	FTimerHandle PredictedShotHandle;
+
+	/** Where a shot leaves the gun and which way it goes */
+	void GetShotStart(FVector& OutLocation, FRotator& OutRotation) const;
+
+	/** The owning client's own copy of a shot, fired without waiting for the server */
+	void FirePredictedShot();
+
+	/** Slot in the muzzle cache while shooting, INDEX_NONE otherwise */
+	int32 MuzzleSlot;
+
+	/** Where this character reports its death, looked up once in BeginPlay */
+	UPROPERTY()
+	class AGameplayEventBus *EventBus;
+
+	/** Manager looking after this character's update rates, told how long each actor tick takes. NULL while not registered */
+	UPROPERTY()
+	class AEnemySignificanceManager *SignificanceManager;
+};
+
@@ -1,343 +1,541 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-
-#include "FirstAttempt.h"
-#include "ThirdPersonVehicle.h"
-#include "FrontWheel.h"
-#include "RearWheel.h"
-//#include "FirstAttemptHud.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "GameFramework/SpringArmComponent.h"
-#include "Camera/CameraComponent.h"
-#include "Components/InputComponent.h"
-#include "WheeledVehicleMovementComponent4W.h"
-#include "Engine/SkeletalMesh.h"
-#include "ThirdPersonCharacter.h"
-/*
-// Needed for VR Headset
-#if HMD_MODULE_INCLUDED
-#include "IHeadMountedDisplay.h"
-#endif // HMD_MODULE_INCLUDED
-*/
-const FName AThirdPersonVehicle::LookUpBinding("LookUp");
-const FName AThirdPersonVehicle::LookRightBinding("LookRight");
-
-#define LOCTEXT_NAMESPACE "VehiclePawn"
-
-AThirdPersonVehicle::AThirdPersonVehicle()
-{
-	// Car mesh
-	static ConstructorHelpers::FObjectFinder<USkeletalMesh> CarMesh(TEXT("/Game/Vehicle/Sedan/Sedan_SkelMesh.Sedan_SkelMesh"));
-	GetMesh()->SetSkeletalMesh(CarMesh.Object);
-
-	static ConstructorHelpers::FClassFinder<UObject> AnimBPClass(TEXT("/Game/Vehicle/Sedan/Sedan_AnimBP"));
-	GetMesh()->SetAnimInstanceClass(AnimBPClass.Class);
-
-	// Simulation
-	UWheeledVehicleMovementComponent4W* Vehicle4W = CastChecked<UWheeledVehicleMovementComponent4W>(GetVehicleMovement());
-
-	check(Vehicle4W->WheelSetups.Num() == 4);
-
-	Vehicle4W->WheelSetups[0].WheelClass = UFrontWheel::StaticClass();
-	Vehicle4W->WheelSetups[0].BoneName = FName("Wheel_Front_Left");
-	Vehicle4W->WheelSetups[0].AdditionalOffset = FVector(0.f, -12.f, 0.f);
-
-	Vehicle4W->WheelSetups[1].WheelClass = UFrontWheel::StaticClass();
-	Vehicle4W->WheelSetups[1].BoneName = FName("Wheel_Front_Right");
-	Vehicle4W->WheelSetups[1].AdditionalOffset = FVector(0.f, 12.f, 0.f);
-
-	Vehicle4W->WheelSetups[2].WheelClass = URearWheel::StaticClass();
-	Vehicle4W->WheelSetups[2].BoneName = FName("Wheel_Rear_Left");
-	Vehicle4W->WheelSetups[2].AdditionalOffset = FVector(0.f, -12.f, 0.f);
-
-	Vehicle4W->WheelSetups[3].WheelClass = URearWheel::StaticClass();
-	Vehicle4W->WheelSetups[3].BoneName = FName("Wheel_Rear_Right");
-	Vehicle4W->WheelSetups[3].AdditionalOffset = FVector(0.f, 12.f, 0.f);
-
-	// Create a spring arm component
-	SpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("SpringArm0"));
-	SpringArm->TargetOffset = FVector(0.f, 0.f, 200.f);
-	SpringArm->SetRelativeRotation(FRotator(-15.f, 0.f, 0.f));
-	SpringArm->SetupAttachment(RootComponent);
-	SpringArm->TargetArmLength = 600.0f;
-	SpringArm->bEnableCameraRotationLag = true;
-	SpringArm->CameraRotationLagSpeed = 7.f;
-	SpringArm->bInheritPitch = false;
-	SpringArm->bInheritRoll = false;
-
-	// Create camera component 
-	Camera = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera0"));
-	Camera->SetupAttachment(SpringArm, USpringArmComponent::SocketName);
-	Camera->bUsePawnControlRotation = false;
-	Camera->FieldOfView = 90.f;
-
-	// Create In-Car camera component 
-	InternalCameraOrigin = FVector(0.0f, -40.0f, 120.0f);
-
-	InternalCameraBase = CreateDefaultSubobject<USceneComponent>(TEXT("InternalCameraBase"));
-	InternalCameraBase->SetRelativeLocation(InternalCameraOrigin);
-	InternalCameraBase->SetupAttachment(GetMesh());
-
-	InternalCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("InternalCamera"));
-	InternalCamera->bUsePawnControlRotation = false;
-	InternalCamera->FieldOfView = 90.f;
-	InternalCamera->SetupAttachment(InternalCameraBase);
-
-	//Setup TextRenderMaterial
-	static ConstructorHelpers::FObjectFinder<UMaterial> TextMaterial(TEXT("Material'/Engine/EngineMaterials/AntiAliasedTextMaterialTranslucent.AntiAliasedTextMaterialTranslucent'"));
-
-	UMaterialInterface* Material = TextMaterial.Object;
-
-	// Create text render component for in car speed display
-	InCarSpeed = CreateDefaultSubobject<UTextRenderComponent>(TEXT("IncarSpeed"));
-	InCarSpeed->SetTextMaterial(Material);
-	InCarSpeed->SetRelativeLocation(FVector(70.0f, -75.0f, 99.0f));
-	InCarSpeed->SetRelativeRotation(FRotator(18.0f, 180.0f, 0.0f));
-	InCarSpeed->SetupAttachment(GetMesh());
-	InCarSpeed->SetRelativeScale3D(FVector(1.0f, 0.4f, 0.4f));
-
-	// Create text render component for in car gear display
-	InCarGear = CreateDefaultSubobject<UTextRenderComponent>(TEXT("IncarGear"));
-	InCarGear->SetTextMaterial(Material);
-	InCarGear->SetRelativeLocation(FVector(66.0f, -9.0f, 95.0f));
-	InCarGear->SetRelativeRotation(FRotator(25.0f, 180.0f, 0.0f));
-	InCarGear->SetRelativeScale3D(FVector(1.0f, 0.4f, 0.4f));
-	InCarGear->SetupAttachment(GetMesh());
-
-	// Colors for the incar gear display. One for normal one for reverse
-	GearDisplayReverseColor = FColor(255, 0, 0, 255);
-	GearDisplayColor = FColor(255, 255, 255, 255);
-
-	// Colors for the in-car gear display. One for normal one for reverse
-	GearDisplayReverseColor = FColor(255, 0, 0, 255);
-	GearDisplayColor = FColor(255, 255, 255, 255);
-
-	bInReverseGear = false;
-
-	Sensor = CreateDefaultSubobject<USphereComponent>(TEXT("Sensor"));
-	Sensor->SetSphereRadius(0, true);
-	Sensor->SetupAttachment(GetMesh());
-
-	//GetMesh()->OnComponentHit.AddDynamic(this, &AThirdPersonVehicle::OnHit);
-}
-
-void AThirdPersonVehicle::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
-{
-	Super::SetupPlayerInputComponent(PlayerInputComponent);
-
-	// set up gameplay key bindings
-	check(PlayerInputComponent);
-
-	PlayerInputComponent->BindAxis("VehicleMoveForward", this, &AThirdPersonVehicle::MoveForward);
-	PlayerInputComponent->BindAxis("VehicleMoveRight", this, &AThirdPersonVehicle::MoveRight);
-	PlayerInputComponent->BindAxis("LookUp");
-	PlayerInputComponent->BindAxis("LookRight");
-
-	PlayerInputComponent->BindAction("Handbrake", IE_Pressed, this, &AThirdPersonVehicle::OnHandbrakePressed);
-	PlayerInputComponent->BindAction("Handbrake", IE_Released, this, &AThirdPersonVehicle::OnHandbrakeReleased);
-	PlayerInputComponent->BindAction("SwitchCamera", IE_Pressed, this, &AThirdPersonVehicle::OnToggleCamera);
-	PlayerInputComponent->BindAction("SwitchPawns", IE_Pressed, this, &AThirdPersonVehicle::SwitchPawns);
-
-	PlayerInputComponent->BindAction("ResetVR", IE_Pressed, this, &AThirdPersonVehicle::OnResetVR);
-}
-
-void AThirdPersonVehicle::MoveForward(float Val)
-{
-	GetVehicleMovementComponent()->SetThrottleInput(Val);
-}
-
-void AThirdPersonVehicle::MoveRight(float Val)
-{
-	GetVehicleMovementComponent()->SetSteeringInput(Val);
-}
-
-void AThirdPersonVehicle::OnHandbrakePressed()
-{
-	GetVehicleMovementComponent()->SetHandbrakeInput(true);
-}
-
-void AThirdPersonVehicle::OnHandbrakeReleased()
-{
-	GetVehicleMovementComponent()->SetHandbrakeInput(false);
-}
-
-void AThirdPersonVehicle::OnToggleCamera()
-{
-	EnableIncarView(!bInCarCameraActive);
-}
-
-void AThirdPersonVehicle::EnableIncarView(const bool bState, const bool bForce)
-{
-	if ((bState != bInCarCameraActive) || (bForce == true))
-	{
-		bInCarCameraActive = bState;
-
-		if (bState == true)
-		{
-			OnResetVR();
-			Camera->Deactivate();
-			InternalCamera->Activate();
-		}
-		else
-		{
-			InternalCamera->Deactivate();
-			Camera->Activate();
-		}
-
-		InCarSpeed->SetVisibility(bInCarCameraActive);
-		InCarGear->SetVisibility(bInCarCameraActive);
-	}
-}
-
-
-void AThirdPersonVehicle::Tick(float Delta)
-{
-	Super::Tick(Delta);
-
-	// Setup the flag to say we are in reverse gear
-	bInReverseGear = GetVehicleMovement()->GetCurrentGear() < 0;
-
-	// Update the strings used in the hud (incar and onscreen)
-	UpdateHUDStrings();
-
-	// Set the string in the incar hud
-	SetupInCarHUD();
-
-	bool bHMDActive = false;
-	/*
-#if HMD_MODULE_INCLUDED
-	if ((GEngine->HMDDevice.IsValid() == true) && ((GEngine->HMDDevice->IsHeadTrackingAllowed() == true) || (GEngine->IsStereoscopic3D() == true)))
-	{
-		bHMDActive = true;
-	}
-#endif // HMD_MODULE_INCLUDED
-*/
-	if (bHMDActive == false)
-	{
-		if ((InputComponent) && (bInCarCameraActive == true))
-		{
-			FRotator HeadRotation = InternalCamera->RelativeRotation;
-			HeadRotation.Pitch += InputComponent->GetAxisValue(LookUpBinding);
-			HeadRotation.Yaw += InputComponent->GetAxisValue(LookRightBinding);
-			InternalCamera->RelativeRotation = HeadRotation;
-		}
-	}
-}
-
-void AThirdPersonVehicle::BeginPlay()
-{
-	Super::BeginPlay();
-
-	bool bEnableInCar = false;
-	/*
-#if HMD_MODULE_INCLUDED
-	bEnableInCar = UHeadMountedDisplayFunctionLibrary::IsHeadMountedDisplayEnabled();
-#endif // HMD_MODULE_INCLUDED
-*/
-	EnableIncarView(bEnableInCar, true);
-}
-
-void AThirdPersonVehicle::OnResetVR()
-{
-	/*
-#if HMD_MODULE_INCLUDED
-	if (GEngine->HMDDevice.IsValid())
-	{
-		GEngine->HMDDevice->ResetOrientationAndPosition();
-		InternalCamera->SetRelativeLocation(InternalCameraOrigin);
-		GetController()->SetControlRotation(FRotator());
-	}
-#endif // HMD_MODULE_INCLUDED
-*/
-}
-
-void AThirdPersonVehicle::UpdateHUDStrings()
-{
-	float KPH = FMath::Abs(GetVehicleMovement()->GetForwardSpeed()) * 0.036f;
-	int32 KPH_int = FMath::FloorToInt(KPH);
-
-	// Using FText because this is display text that should be localizable
-	SpeedDisplayString = FText::Format(LOCTEXT("SpeedFormat", "{0} km/h"), FText::AsNumber(KPH_int));
-
-	if (bInReverseGear == true)
-	{
-		GearDisplayString = FText(LOCTEXT("ReverseGear", "R"));
-	}
-	else
-	{
-		int32 Gear = GetVehicleMovement()->GetCurrentGear();
-		GearDisplayString = (Gear == 0) ? LOCTEXT("N", "N") : FText::AsNumber(Gear);
-	}
-}
-
-void AThirdPersonVehicle::SetupInCarHUD()
-{
-	APlayerController* PlayerController = Cast<APlayerController>(GetController());
-	if ((PlayerController != nullptr) && (InCarSpeed != nullptr) && (InCarGear != nullptr))
-	{
-		// Setup the text render component strings
-		InCarSpeed->SetText(SpeedDisplayString);
-		InCarGear->SetText(GearDisplayString);
-
-		if (bInReverseGear == false)
-		{
-			InCarGear->SetTextRenderColor(GearDisplayColor);
-		}
-		else
-		{
-			InCarGear->SetTextRenderColor(GearDisplayReverseColor);
-		}
-	}
-}
-
-void AThirdPersonVehicle::SwitchPawns()
-{
-	TArray<AActor*> OverlappingActors;
-	Sensor->GetOverlappingActors(OverlappingActors);
-	for (int i = 0; i < OverlappingActors.Num(); i++)
-	{
-		//UE_LOG(LogTemp, Warning, TEXT("Fuck"));
-		APawn *Pawn = Cast<APawn>(OverlappingActors[i]);
-		if (Pawn && Pawn != this)
-		{
-			//UE_LOG(LogTemp, Warning, TEXT("Ass"));
-			AController* TempController = GetController();
-			if (TempController)
-			{
-				//UE_LOG(LogTemp, Warning, TEXT("Bitch"));
-				TempController->UnPossess();
-				TempController->Possess(Pawn);
-				AThirdPersonCharacter *Character = Cast<AThirdPersonCharacter>(Pawn);
-				if (Character)
-				{
-					Character->GetUp();
-				}
-				/*
-				else
-				{
-					AThirdPersonVehicle *Vehicle = Cast<AThirdPersonVehicle>(Pawn);
-					if (Vehicle)
-					{
-						Vehicle->GetMesh()->SetSimulatePhysics(true);
-					}
-				}
-				*/
-			}
-			break;
-		}
-	}
-}
-/*
-void AThirdPersonVehicle::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
-{
-	UE_LOG(LogTemp, Warning, TEXT("Fuck"))
-	// Only add impulse and destroy projectile if we hit a physics
-	if ((OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL))
-	{
-		HitComp->SetSimulatePhysics(true);
-		HitComp->AddImpulseAtLocation(GetVelocity() * 20.0f, GetActorLocation());
-		OtherComp->SetSimulatePhysics(true);
-		OtherComp->AddImpulseAtLocation(GetVelocity() * 20.0f, GetActorLocation());
-	}
-}
-*/
-#undef LOCTEXT_NAMESPACE
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "FirstAttempt.h"
+#include "ThirdPersonVehicle.h"
+#include "FrontWheel.h"
+#include "RearWheel.h"
+//#include "FirstAttemptHud.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "Camera/CameraComponent.h"
+#include "Components/InputComponent.h"
+#include "WheeledVehicleMovementComponent4W.h"
+#include "Engine/SkeletalMesh.h"
+#include "ThirdPersonCharacter.h"
+#include "FirstAttemptGameModeBase.h"
+#include "PossessableRegistry.h"
+#include "ContentPreloader.h"
+#include "FirstAttemptStats.h"
+/*
+// Needed for VR Headset
+#if HMD_MODULE_INCLUDED
+#include "IHeadMountedDisplay.h"
+#endif // HMD_MODULE_INCLUDED
+*/
+const FName AThirdPersonVehicle::LookUpBinding("LookUp");
+const FName AThirdPersonVehicle::LookRightBinding("LookRight");
+
+#define LOCTEXT_NAMESPACE "VehiclePawn"
+
+DECLARE_CYCLE_STAT(TEXT("Vehicle Tick"), STAT_VehicleTick, STATGROUP_FirstAttempt);
+DECLARE_CYCLE_STAT(TEXT("Vehicle HUD Update"), STAT_VehicleHUDUpdate, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Vehicles Active"), STAT_VehiclesActive, STATGROUP_FirstAttempt);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Vehicles Dormant"), STAT_VehiclesDormant, STATGROUP_FirstAttempt);
+
+/** Speeds up to this many km/h use prebuilt text instead of formatting a new string */
+static const int32 MaxCachedSpeedKPH = 400;
+
+/** Highest forward gear with prebuilt text */
+static const int32 MaxCachedGear = 8;
+
+static const FText& GetSpeedText(int32 KPH)
+{
+	static TArray<FText> SpeedTexts;
+	if (SpeedTexts.Num() == 0)
+	{
+		SpeedTexts.Reserve(MaxCachedSpeedKPH + 1);
+		for (int32 i = 0; i <= MaxCachedSpeedKPH; i++)
+		{
+			SpeedTexts.Add(FText::Format(LOCTEXT("SpeedFormat", "{0} km/h"), FText::AsNumber(i)));
+		}
+	}
+	if (KPH <= MaxCachedSpeedKPH)
+	{
+		return SpeedTexts[FMath::Max(KPH, 0)];
+	}
+	// Faster than anything we expect, build it on demand
+	static FText OverflowText;
+	OverflowText = FText::Format(LOCTEXT("SpeedFormat", "{0} km/h"), FText::AsNumber(KPH));
+	return OverflowText;
+}
+
+static const FText& GetGearText(int32 Gear, bool bInReverseGear)
+{
+	// Index 0 is reverse, 1 is neutral and the forward gears follow
+	static TArray<FText> GearTexts;
+	if (GearTexts.Num() == 0)
+	{
+		GearTexts.Add(LOCTEXT("ReverseGear", "R"));
+		GearTexts.Add(LOCTEXT("N", "N"));
+		for (int32 i = 1; i <= MaxCachedGear; i++)
+		{
+			GearTexts.Add(FText::AsNumber(i));
+		}
+	}
+	if (bInReverseGear)
+	{
+		return GearTexts[0];
+	}
+	if (Gear <= MaxCachedGear)
+	{
+		return GearTexts[FMath::Max(Gear, 0) + 1];
+	}
+	static FText OverflowText;
+	OverflowText = FText::AsNumber(Gear);
+	return OverflowText;
+}
+
+AThirdPersonVehicle::AThirdPersonVehicle()
+{
+	// Car mesh, soft referenced so the content preloader can stream it in. Applied in OnConstruction
+	CarMeshAsset = TAssetPtr<USkeletalMesh>(FStringAssetReference(TEXT("/Game/Vehicle/Sedan/Sedan_SkelMesh.Sedan_SkelMesh")));
+	AnimClassAsset = TAssetSubclassOf<UAnimInstance>(FStringAssetReference(TEXT("/Game/Vehicle/Sedan/Sedan_AnimBP.Sedan_AnimBP_C")));
+
+	// Simulation
+	UWheeledVehicleMovementComponent4W* Vehicle4W = CastChecked<UWheeledVehicleMovementComponent4W>(GetVehicleMovement());
+
+	check(Vehicle4W->WheelSetups.Num() == 4);
+
+	Vehicle4W->WheelSetups[0].WheelClass = UFrontWheel::StaticClass();
+	Vehicle4W->WheelSetups[0].BoneName = FName("Wheel_Front_Left");
+	Vehicle4W->WheelSetups[0].AdditionalOffset = FVector(0.f, -12.f, 0.f);
+
+	Vehicle4W->WheelSetups[1].WheelClass = UFrontWheel::StaticClass();
+	Vehicle4W->WheelSetups[1].BoneName = FName("Wheel_Front_Right");
+	Vehicle4W->WheelSetups[1].AdditionalOffset = FVector(0.f, 12.f, 0.f);
+
+	Vehicle4W->WheelSetups[2].WheelClass = URearWheel::StaticClass();
+	Vehicle4W->WheelSetups[2].BoneName = FName("Wheel_Rear_Left");
+	Vehicle4W->WheelSetups[2].AdditionalOffset = FVector(0.f, -12.f, 0.f);
+
+	Vehicle4W->WheelSetups[3].WheelClass = URearWheel::StaticClass();
+	Vehicle4W->WheelSetups[3].BoneName = FName("Wheel_Rear_Right");
+	Vehicle4W->WheelSetups[3].AdditionalOffset = FVector(0.f, 12.f, 0.f);
+
+	// Create a spring arm component
+	SpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("SpringArm0"));
+	SpringArm->TargetOffset = FVector(0.f, 0.f, 200.f);
+	SpringArm->SetRelativeRotation(FRotator(-15.f, 0.f, 0.f));
+	SpringArm->SetupAttachment(RootComponent);
+	SpringArm->TargetArmLength = 600.0f;
+	SpringArm->bEnableCameraRotationLag = true;
+	SpringArm->CameraRotationLagSpeed = 7.f;
+	SpringArm->bInheritPitch = false;
+	SpringArm->bInheritRoll = false;
+
+	// Create camera component 
+	Camera = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera0"));
+	Camera->SetupAttachment(SpringArm, USpringArmComponent::SocketName);
+	Camera->bUsePawnControlRotation = false;
+	Camera->FieldOfView = 90.f;
+
+	// Create In-Car camera component 
+	InternalCameraOrigin = FVector(0.0f, -40.0f, 120.0f);
+
+	InternalCameraBase = CreateDefaultSubobject<USceneComponent>(TEXT("InternalCameraBase"));
+	InternalCameraBase->SetRelativeLocation(InternalCameraOrigin);
+	InternalCameraBase->SetupAttachment(GetMesh());
+
+	InternalCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("InternalCamera"));
+	InternalCamera->bUsePawnControlRotation = false;
+	InternalCamera->FieldOfView = 90.f;
+	InternalCamera->SetupAttachment(InternalCameraBase);
+
+	//Setup TextRenderMaterial
+	static ConstructorHelpers::FObjectFinder<UMaterial> TextMaterial(TEXT("Material'/Engine/EngineMaterials/AntiAliasedTextMaterialTranslucent.AntiAliasedTextMaterialTranslucent'"));
+
+	UMaterialInterface* Material = TextMaterial.Object;
+
+	// Create text render component for in car speed display
+	InCarSpeed = CreateDefaultSubobject<UTextRenderComponent>(TEXT("IncarSpeed"));
+	InCarSpeed->SetTextMaterial(Material);
+	InCarSpeed->SetRelativeLocation(FVector(70.0f, -75.0f, 99.0f));
+	InCarSpeed->SetRelativeRotation(FRotator(18.0f, 180.0f, 0.0f));
+	InCarSpeed->SetupAttachment(GetMesh());
+	InCarSpeed->SetRelativeScale3D(FVector(1.0f, 0.4f, 0.4f));
+
+	// Create text render component for in car gear display
+	InCarGear = CreateDefaultSubobject<UTextRenderComponent>(TEXT("IncarGear"));
+	InCarGear->SetTextMaterial(Material);
+	InCarGear->SetRelativeLocation(FVector(66.0f, -9.0f, 95.0f));
+	InCarGear->SetRelativeRotation(FRotator(25.0f, 180.0f, 0.0f));
+	InCarGear->SetRelativeScale3D(FVector(1.0f, 0.4f, 0.4f));
+	InCarGear->SetupAttachment(GetMesh());
+
+	// Colors for the incar gear display. One for normal one for reverse
+	GearDisplayReverseColor = FColor(255, 0, 0, 255);
+	GearDisplayColor = FColor(255, 255, 255, 255);
+
+	// Colors for the in-car gear display. One for normal one for reverse
+	GearDisplayReverseColor = FColor(255, 0, 0, 255);
+	GearDisplayColor = FColor(255, 255, 255, 255);
+
+	bInReverseGear = false;
+
+	// Nothing has been shown yet, so the first tick always fills in the HUD
+	DisplayedSpeedKPH = INDEX_NONE;
+	DisplayedGear = INDEX_NONE;
+	bHUDDirty = true;
+
+	//GetMesh()->OnComponentHit.AddDynamic(this, &AThirdPersonVehicle::OnHit);
+
+	// Parked cars go to sleep once they have stopped, and need hit events to know when to wake up
+	GetMesh()->SetNotifyRigidBodyCollision(true);
+	DormantSpeed = 10.f;
+	DormantDelay = 2.f;
+	StoppedTime = 0.f;
+	bIsDormant = false;
+
+	// Parked cars rarely change, so send them seldom and only to clients close enough to see them
+	NetCullDistanceSquared = FMath::Square(20000.f);
+	NetUpdateFrequency = 20.f;
+	MinNetUpdateFrequency = 2.f;
+}
+
+void AThirdPersonVehicle::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
+{
+	Super::SetupPlayerInputComponent(PlayerInputComponent);
+
+	// set up gameplay key bindings
+	check(PlayerInputComponent);
+
+	PlayerInputComponent->BindAxis("VehicleMoveForward", this, &AThirdPersonVehicle::MoveForward);
+	PlayerInputComponent->BindAxis("VehicleMoveRight", this, &AThirdPersonVehicle::MoveRight);
+	PlayerInputComponent->BindAxis("LookUp");
+	PlayerInputComponent->BindAxis("LookRight");
+
+	PlayerInputComponent->BindAction("Handbrake", IE_Pressed, this, &AThirdPersonVehicle::OnHandbrakePressed);
+	PlayerInputComponent->BindAction("Handbrake", IE_Released, this, &AThirdPersonVehicle::OnHandbrakeReleased);
+	PlayerInputComponent->BindAction("SwitchCamera", IE_Pressed, this, &AThirdPersonVehicle::OnToggleCamera);
+	PlayerInputComponent->BindAction("SwitchPawns", IE_Pressed, this, &AThirdPersonVehicle::SwitchPawns);
+
+	PlayerInputComponent->BindAction("ResetVR", IE_Pressed, this, &AThirdPersonVehicle::OnResetVR);
+}
+
+void AThirdPersonVehicle::MoveForward(float Val)
+{
+	GetVehicleMovementComponent()->SetThrottleInput(Val);
+}
+
+void AThirdPersonVehicle::MoveRight(float Val)
+{
+	GetVehicleMovementComponent()->SetSteeringInput(Val);
+}
+
+void AThirdPersonVehicle::OnHandbrakePressed()
+{
+	GetVehicleMovementComponent()->SetHandbrakeInput(true);
+}
+
+void AThirdPersonVehicle::OnHandbrakeReleased()
+{
+	GetVehicleMovementComponent()->SetHandbrakeInput(false);
+}
+
+void AThirdPersonVehicle::OnToggleCamera()
+{
+	EnableIncarView(!bInCarCameraActive);
+}
+
+void AThirdPersonVehicle::EnableIncarView(const bool bState, const bool bForce)
+{
+	if ((bState != bInCarCameraActive) || (bForce == true))
+	{
+		bInCarCameraActive = bState;
+
+		if (bState == true)
+		{
+			OnResetVR();
+			Camera->Deactivate();
+			InternalCamera->Activate();
+		}
+		else
+		{
+			InternalCamera->Deactivate();
+			Camera->Activate();
+		}
+
+		InCarSpeed->SetVisibility(bInCarCameraActive);
+		InCarGear->SetVisibility(bInCarCameraActive);
+
+		// The text renders were skipped while hidden, so bring them up to date
+		bHUDDirty = true;
+	}
+}
+
+
+void AThirdPersonVehicle::Tick(float Delta)
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_VehicleTick);
+	Super::Tick(Delta);
+
+	// Nobody is driving, so once the car has come to rest stop simulating it. Only the server knows that, a
+	// client has no controller for cars other players are driving
+	if (HasAuthority() && Controller == NULL)
+	{
+		StoppedTime = (GetVelocity().SizeSquared() < FMath::Square(DormantSpeed)) ? StoppedTime + Delta : 0.f;
+		if (StoppedTime >= DormantDelay)
+		{
+			SetDormant(true);
+			return;
+		}
+	}
+
+	// Setup the flag to say we are in reverse gear
+	bInReverseGear = GetVehicleMovement()->GetCurrentGear() < 0;
+
+	// Only touch the HUD when the displayed speed or gear actually changes
+	const int32 SpeedKPH = FMath::FloorToInt(FMath::Abs(GetVehicleMovement()->GetForwardSpeed()) * 0.036f);
+	const int32 Gear = GetVehicleMovement()->GetCurrentGear();
+	if (SpeedKPH != DisplayedSpeedKPH || Gear != DisplayedGear)
+	{
+		DisplayedSpeedKPH = SpeedKPH;
+		DisplayedGear = Gear;
+		bHUDDirty = true;
+
+		// Update the strings used in the hud (incar and onscreen)
+		UpdateHUDStrings();
+	}
+
+	// Set the string in the incar hud, which nobody can see unless the in-car camera is on
+	if (bHUDDirty && bInCarCameraActive)
+	{
+		SetupInCarHUD();
+	}
+
+	bool bHMDActive = false;
+	/*
+#if HMD_MODULE_INCLUDED
+	if ((GEngine->HMDDevice.IsValid() == true) && ((GEngine->HMDDevice->IsHeadTrackingAllowed() == true) || (GEngine->IsStereoscopic3D() == true)))
+	{
+		bHMDActive = true;
+	}
+#endif // HMD_MODULE_INCLUDED
+*/
+	if (bHMDActive == false)
+	{
+		if ((InputComponent) && (bInCarCameraActive == true))
+		{
+			FRotator HeadRotation = InternalCamera->RelativeRotation;
+			HeadRotation.Pitch += InputComponent->GetAxisValue(LookUpBinding);
+			HeadRotation.Yaw += InputComponent->GetAxisValue(LookRightBinding);
+			InternalCamera->RelativeRotation = HeadRotation;
+		}
+	}
+}
+
+void AThirdPersonVehicle::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+	// Leave alone anything a blueprint or the level has already set
+	if (GetMesh()->SkeletalMesh == NULL)
+	{
+		GetMesh()->SetSkeletalMesh(AContentPreloader::Resolve(CarMeshAsset));
+		// The wheels are set up from the mesh's bones and physics asset, which weren't there when the movement registered
+		GetVehicleMovement()->RecreatePhysicsState();
+	}
+	if (GetMesh()->AnimClass == NULL)
+	{
+		GetMesh()->SetAnimInstanceClass(AContentPreloader::Resolve(AnimClassAsset));
+	}
+}
+
+void AThirdPersonVehicle::GetContentAssets(TArray<FStringAssetReference>& OutAssets) const
+{
+	OutAssets.AddUnique(CarMeshAsset.ToStringReference());
+	OutAssets.AddUnique(AnimClassAsset.ToStringReference());
+}
+
+void AThirdPersonVehicle::BeginPlay()
+{
+	Super::BeginPlay();
+
+	INC_DWORD_STAT(STAT_VehiclesActive);
+
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APossessableRegistry *Registry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+	if (Registry)
+	{
+		Registry->AddPossessable(this);
+	}
+
+	bool bEnableInCar = false;
+	/*
+#if HMD_MODULE_INCLUDED
+	bEnableInCar = UHeadMountedDisplayFunctionLibrary::IsHeadMountedDisplayEnabled();
+#endif // HMD_MODULE_INCLUDED
+*/
+	EnableIncarView(bEnableInCar, true);
+}
+
+void AThirdPersonVehicle::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bIsDormant)
+	{
+		DEC_DWORD_STAT(STAT_VehiclesDormant);
+	}
+	else
+	{
+		DEC_DWORD_STAT(STAT_VehiclesActive);
+	}
+	// When the whole world is going away the registry goes with it, so only unregister on a plain destroy
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+		APossessableRegistry *Registry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+		if (Registry)
+		{
+			Registry->RemovePossessable(this);
+		}
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AThirdPersonVehicle::NotifyHit(class UPrimitiveComponent* MyComp, class AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
+{
+	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
+
+	// Something ran into a parked car, let it react
+	SetDormant(false);
+}
+
+void AThirdPersonVehicle::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GameplayContext.Bind(this);
+}
+
+void AThirdPersonVehicle::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+	SetDormant(false);
+
+	// The in-car text is only pushed for player controllers, so it may be stale from before
+	bHUDDirty = true;
+}
+
+void AThirdPersonVehicle::UnPossessed()
+{
+	Super::UnPossessed();
+
+	// Nobody is holding the pedals any more
+	GetVehicleMovementComponent()->SetThrottleInput(0.f);
+	GetVehicleMovementComponent()->SetSteeringInput(0.f);
+	GetVehicleMovementComponent()->SetHandbrakeInput(false);
+	StoppedTime = 0.f;
+}
+
+void AThirdPersonVehicle::SetDormant(bool bNewDormant)
+{
+	if (bNewDormant == bIsDormant)
+	{
+		return;
+	}
+	bIsDormant = bNewDormant;
+	StoppedTime = 0.f;
+
+	// PhysX skips the wheel and suspension update for a vehicle whose body is asleep, so sleeping the body
+	// and switching off our ticks is enough to take the car out of the simulation
+	SetActorTickEnabled(!bIsDormant);
+	GetVehicleMovementComponent()->SetComponentTickEnabled(!bIsDormant);
+	if (bIsDormant)
+	{
+		GetMesh()->PutAllRigidBodiesToSleep();
+		DEC_DWORD_STAT(STAT_VehiclesActive);
+		INC_DWORD_STAT(STAT_VehiclesDormant);
+	}
+	else
+	{
+		GetMesh()->WakeAllRigidBodies();
+		DEC_DWORD_STAT(STAT_VehiclesDormant);
+		INC_DWORD_STAT(STAT_VehiclesActive);
+	}
+}
+
+void AThirdPersonVehicle::OnResetVR()
+{
+	/*
+#if HMD_MODULE_INCLUDED
+	if (GEngine->HMDDevice.IsValid())
+	{
+		GEngine->HMDDevice->ResetOrientationAndPosition();
+		InternalCamera->SetRelativeLocation(InternalCameraOrigin);
+		GetController()->SetControlRotation(FRotator());
+	}
+#endif // HMD_MODULE_INCLUDED
+*/
+}
+
+void AThirdPersonVehicle::UpdateHUDStrings()
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_VehicleHUDUpdate);
+
+	// Using FText because this is display text that should be localizable. The text comes from tables built once
+	SpeedDisplayString = GetSpeedText(DisplayedSpeedKPH);
+	GearDisplayString = GetGearText(DisplayedGear, bInReverseGear);
+}
+
+void AThirdPersonVehicle::SetupInCarHUD()
+{
+	FIRSTATTEMPT_SCOPE_CYCLE_COUNTER(STAT_VehicleHUDUpdate);
+
+	APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if ((PlayerController != nullptr) && (InCarSpeed != nullptr) && (InCarGear != nullptr))
+	{
+		bHUDDirty = false;
+
+		// Setup the text render component strings
+		InCarSpeed->SetText(SpeedDisplayString);
+		InCarGear->SetText(GearDisplayString);
+
+		if (bInReverseGear == false)
+		{
+			InCarGear->SetTextRenderColor(GearDisplayColor);
+		}
+		else
+		{
+			InCarGear->SetTextRenderColor(GearDisplayReverseColor);
+		}
+	}
+}
+
+void AThirdPersonVehicle::SwitchPawns()
+{
+	if (Role < ROLE_Authority)
+	{
+		ServerSwitchPawns();
+		return;
+	}
+	// The registry keeps every possessable pawn in a grid, so this only looks at the few nearby
+	AFirstAttemptGameModeBase *GameMode = GameplayContext.IsValid() ? GameplayContext->GetGameMode() : NULL;
+	APossessableRegistry *Registry = GameMode ? GameMode->GetPossessableRegistry() : NULL;
+	if (Registry)
+	{
+		Registry->SwitchPawns(this);
+	}
+}
+
+void AThirdPersonVehicle::ServerSwitchPawns_Implementation()
+{
+	SwitchPawns();
+}
+
+bool AThirdPersonVehicle::ServerSwitchPawns_Validate()
+{
+	return true;
+}
+/*
+void AThirdPersonVehicle::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	UE_LOG(LogTemp, Warning, TEXT("Fuck"))
+	// Only add impulse and destroy projectile if we hit a physics
+	if ((OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL))
+	{
+		HitComp->SetSimulatePhysics(true);
+		HitComp->AddImpulseAtLocation(GetVelocity() * 20.0f, GetActorLocation());
+		OtherComp->SetSimulatePhysics(true);
+		OtherComp->AddImpulseAtLocation(GetVelocity() * 20.0f, GetActorLocation());
+	}
+}
+*/
+#undef LOCTEXT_NAMESPACE
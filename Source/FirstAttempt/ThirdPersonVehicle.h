@@ -1,135 +1,183 @@
-// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
-#pragma once
-#include "WheeledVehicle.h"
-#include "ThirdPersonVehicle.generated.h"
-
-class UCameraComponent;
-class USpringArmComponent;
-class UTextRenderComponent;
-class UInputComponent;
-UCLASS(config = Game)
-class AThirdPersonVehicle : public AWheeledVehicle
-{
-	GENERATED_BODY()
-
-		/** Spring arm that will offset the camera */
-		UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		USpringArmComponent* SpringArm;
-
-	/** Camera component that will be our viewpoint */
-	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		UCameraComponent* Camera;
-
-	/** SCene component for the In-Car view origin */
-	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		class USceneComponent* InternalCameraBase;
-
-	/** Camera component for the In-Car view */
-	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		UCameraComponent* InternalCamera;
-
-	/** Text component for the In-Car speed */
-	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		UTextRenderComponent* InCarSpeed;
-
-	/** Text component for the In-Car gear */
-	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
-		UTextRenderComponent* InCarGear;
-
-
-public:
-	AThirdPersonVehicle();
-
-	/** The current speed as a string eg 10 km/h */
-	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
-		FText SpeedDisplayString;
-
-	/** The current gear as a string (R,N, 1,2 etc) */
-	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
-		FText GearDisplayString;
-
-	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
-		/** The color of the incar gear text in forward gears */
-		FColor	GearDisplayColor;
-
-	/** The color of the incar gear text when in reverse */
-	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
-		FColor	GearDisplayReverseColor;
-
-	/** Are we using incar camera */
-	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly)
-		bool bInCarCameraActive;
-
-	/** Are we in reverse gear */
-	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly)
-		bool bInReverseGear;
-
-	/** Initial offset of incar camera */
-	FVector InternalCameraOrigin;
-	// Begin Pawn interface
-	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
-	// End Pawn interface
-
-	// Begin Actor interface
-	virtual void Tick(float Delta) override;
-protected:
-	virtual void BeginPlay() override;
-
-public:
-	// End Actor interface
-
-	/** Handle pressing forwards */
-	void MoveForward(float Val);
-	/** Setup the strings used on the hud */
-	void SetupInCarHUD();
-
-	/** Update the physics material used by the vehicle mesh */
-	void UpdatePhysicsMaterial();
-	/** Handle pressing right */
-	void MoveRight(float Val);
-	/** Handle handbrake pressed */
-	void OnHandbrakePressed();
-	/** Handle handbrake released */
-	void OnHandbrakeReleased();
-	/** Switch between cameras */
-	void OnToggleCamera();
-	/** Handle reset VR device */
-	void OnResetVR();
-
-	void SwitchPawns();
-
-	static const FName LookUpBinding;
-	static const FName LookRightBinding;
-
-private:
-	/**
-	* Activate In-Car camera. Enable camera and sets visibility of incar hud display
-	*
-	* @param	bState true will enable in car view and set visibility of various if its doesnt match new state
-	* @param	bForce true will force to always change state
-	*/
-	void EnableIncarView(const bool bState, const bool bForce = false);
-
-	/** Update the gear and speed strings */
-	void UpdateHUDStrings();
-
-	/* Are we on a 'slippery' surface */
-	bool bIsLowFriction;
-
-	class USphereComponent *Sensor;
-
-public:
-	/** Returns SpringArm subobject **/
-	FORCEINLINE USpringArmComponent* GetSpringArm() const { return SpringArm; }
-	/** Returns Camera subobject **/
-	FORCEINLINE UCameraComponent* GetCamera() const { return Camera; }
-	/** Returns InternalCamera subobject **/
-	FORCEINLINE UCameraComponent* GetInternalCamera() const { return InternalCamera; }
-	/** Returns InCarSpeed subobject **/
-	FORCEINLINE UTextRenderComponent* GetInCarSpeed() const { return InCarSpeed; }
-	/** Returns InCarGear subobject **/
-	FORCEINLINE UTextRenderComponent* GetInCarGear() const { return InCarGear; }
-	
-	//UFUNCTION()
-	//void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
-};
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "WheeledVehicle.h"
+#include "GameplayContext.h"
+#include "PreloadedContent.h"
+#include "ThirdPersonVehicle.generated.h"
+
+class UCameraComponent;
+class USpringArmComponent;
+class UTextRenderComponent;
+class UInputComponent;
+UCLASS(config = Game)
+class AThirdPersonVehicle : public AWheeledVehicle, public IPreloadedContent
+{
+	GENERATED_BODY()
+
+		/** Spring arm that will offset the camera */
+		UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		USpringArmComponent* SpringArm;
+
+	/** Camera component that will be our viewpoint */
+	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		UCameraComponent* Camera;
+
+	/** SCene component for the In-Car view origin */
+	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		class USceneComponent* InternalCameraBase;
+
+	/** Camera component for the In-Car view */
+	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		UCameraComponent* InternalCamera;
+
+	/** Text component for the In-Car speed */
+	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		UTextRenderComponent* InCarSpeed;
+
+	/** Text component for the In-Car gear */
+	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		UTextRenderComponent* InCarGear;
+
+
+public:
+	AThirdPersonVehicle();
+
+	/** The current speed as a string eg 10 km/h */
+	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
+		FText SpeedDisplayString;
+
+	/** The current gear as a string (R,N, 1,2 etc) */
+	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
+		FText GearDisplayString;
+
+	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
+		/** The color of the incar gear text in forward gears */
+		FColor	GearDisplayColor;
+
+	/** The color of the incar gear text when in reverse */
+	UPROPERTY(Category = Display, VisibleDefaultsOnly, BlueprintReadOnly)
+		FColor	GearDisplayReverseColor;
+
+	/** Are we using incar camera */
+	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly)
+		bool bInCarCameraActive;
+
+	/** Are we in reverse gear */
+	UPROPERTY(Category = Camera, VisibleDefaultsOnly, BlueprintReadOnly)
+		bool bInReverseGear;
+
+	/** Initial offset of incar camera */
+	FVector InternalCameraOrigin;
+
+	/** Is the car parked with its physics asleep and its ticks off */
+	UFUNCTION(BlueprintPure, Category = Dormancy)
+		bool GetIsDormant() const { return bIsDormant; }
+
+	/** Puts a parked car to sleep or wakes it back up */
+	void SetDormant(bool bNewDormant);
+	// Begin Pawn interface
+	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
+	virtual void PostInitializeComponents() override;
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void UnPossessed() override;
+	// End Pawn interface
+
+	// Begin Actor interface
+	virtual void Tick(float Delta) override;
+	virtual void NotifyHit(class UPrimitiveComponent* MyComp, class AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override;
+	virtual void OnConstruction(const FTransform& Transform) override;
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** An unpossessed car slower than this, in cm/s, counts as stopped */
+	UPROPERTY(Category = Dormancy, EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected = "true"))
+		float DormantSpeed;
+
+	/** How long an unpossessed car has to stay stopped before it goes dormant */
+	UPROPERTY(Category = Dormancy, EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected = "true"))
+		float DormantDelay;
+
+	UPROPERTY(Category = Content, EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected = "true"))
+		TAssetPtr<USkeletalMesh> CarMeshAsset;
+
+	UPROPERTY(Category = Content, EditDefaultsOnly, BlueprintReadOnly, meta = (BlueprintProtected = "true"))
+		TAssetSubclassOf<UAnimInstance> AnimClassAsset;
+
+public:
+	// End Actor interface
+
+	/** Handle pressing forwards */
+	void MoveForward(float Val);
+	/** Setup the strings used on the hud */
+	void SetupInCarHUD();
+
+	/** Update the physics material used by the vehicle mesh */
+	void UpdatePhysicsMaterial();
+	/** Handle pressing right */
+	void MoveRight(float Val);
+	/** Handle handbrake pressed */
+	void OnHandbrakePressed();
+	/** Handle handbrake released */
+	void OnHandbrakeReleased();
+	/** Switch between cameras */
+	void OnToggleCamera();
+	/** Handle reset VR device */
+	void OnResetVR();
+
+	void SwitchPawns();
+
+	/** A client's SwitchPawns input, possession only happens on the server */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSwitchPawns();
+
+	/** Adds the soft referenced content this vehicle needs to the list, for the content preloader */
+	virtual void GetContentAssets(TArray<FStringAssetReference>& OutAssets) const override;
+
+	static const FName LookUpBinding;
+	static const FName LookRightBinding;
+
+private:
+	/**
+	* Activate In-Car camera. Enable camera and sets visibility of incar hud display
+	*
+	* @param	bState true will enable in car view and set visibility of various if its doesnt match new state
+	* @param	bForce true will force to always change state
+	*/
+	void EnableIncarView(const bool bState, const bool bForce = false);
+
+	/** Update the gear and speed strings */
+	void UpdateHUDStrings();
+
+	/* Are we on a 'slippery' surface */
+	bool bIsLowFriction;
+
+	/** Speed in whole km/h the HUD strings were last built for */
+	int32 DisplayedSpeedKPH;
+
+	/** Gear the HUD strings were last built for */
+	int32 DisplayedGear;
+
+	/** The in-car text renders need the latest strings and colour pushed to them */
+	bool bHUDDirty;
+
+	/** How long the car has been stopped with nobody driving it */
+	float StoppedTime;
+
+	bool bIsDormant;
+
+public:
+	/** Returns SpringArm subobject **/
+	FORCEINLINE USpringArmComponent* GetSpringArm() const { return SpringArm; }
+	/** Returns Camera subobject **/
+	FORCEINLINE UCameraComponent* GetCamera() const { return Camera; }
+	/** Returns InternalCamera subobject **/
+	FORCEINLINE UCameraComponent* GetInternalCamera() const { return InternalCamera; }
+	/** Returns InCarSpeed subobject **/
+	FORCEINLINE UTextRenderComponent* GetInCarSpeed() const { return InCarSpeed; }
+	/** Returns InCarGear subobject **/
+	FORCEINLINE UTextRenderComponent* GetInCarGear() const { return InCarGear; }
+	
+	//UFUNCTION()
+	//void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+};